@@ -0,0 +1,108 @@
+#include "asset_manifest.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "content_hash.h"
+#include "output_writer.h"
+#include "trace.h"
+
+namespace dataminer {
+
+absl::StatusOr<std::unique_ptr<AssetManifest>> AssetManifest::Scan(
+    const absl::string_view root) {
+  TRACE_SCOPE("ScanAssets");
+  const std::filesystem::path root_path{std::string(root)};
+  absl::flat_hash_set<std::string> files;
+  std::error_code error;
+  std::filesystem::recursive_directory_iterator it(root_path, error);
+  for (; !error && it != std::filesystem::recursive_directory_iterator();
+       it.increment(error)) {
+    // The entry's type comes from the directory listing, so this doesn't
+    // stat the file.
+    if (!it->is_regular_file(error)) continue;
+    files.insert(it->path().lexically_relative(root_path).generic_string());
+  }
+  if (error) {
+    return absl::UnavailableError(absl::StrCat(
+        "Couldn't scan assets in '", root, "': ", error.message()));
+  }
+  return std::unique_ptr<AssetManifest>(
+      new AssetManifest(std::string(root), std::move(files)));
+}
+
+std::unique_ptr<AssetManifest> AssetManifest::Empty(
+    const absl::string_view root) {
+  return std::unique_ptr<AssetManifest>(
+      new AssetManifest(std::string(root), {}));
+}
+
+bool AssetManifest::Reference(const absl::string_view path) const {
+  {
+    absl::MutexLock lock(&mu_);
+    referenced_.emplace(path);
+  }
+  return Contains(path);
+}
+
+std::vector<std::string> AssetManifest::Missing() const {
+  std::vector<std::string> missing;
+  {
+    absl::MutexLock lock(&mu_);
+    for (const std::string& path : referenced_) {
+      if (!Contains(path)) missing.push_back(path);
+    }
+  }
+  std::sort(missing.begin(), missing.end());
+  return missing;
+}
+
+std::vector<std::string> AssetManifest::Orphaned(
+    const absl::string_view prefix) const {
+  std::vector<std::string> orphaned;
+  {
+    absl::MutexLock lock(&mu_);
+    for (const std::string& path : files_) {
+      if (absl::StartsWith(path, prefix) && !referenced_.contains(path)) {
+        orphaned.push_back(path);
+      }
+    }
+  }
+  std::sort(orphaned.begin(), orphaned.end());
+  return orphaned;
+}
+
+std::string AssetManifest::PathsHash() const {
+  std::vector<absl::string_view> paths(files_.begin(), files_.end());
+  std::sort(paths.begin(), paths.end());
+  std::string all;
+  for (const absl::string_view path : paths) absl::StrAppend(&all, path, "\n");
+  return ContentHashString(all);
+}
+
+absl::Status AssetManifest::Save(const absl::string_view output_path) const {
+  std::vector<absl::string_view> paths(files_.begin(), files_.end());
+  std::sort(paths.begin(), paths.end());
+  std::ostringstream out;
+  for (const absl::string_view path : paths) {
+    std::ifstream in(absl::StrCat(root_, "/", path), std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+    if (in.bad()) {
+      return absl::UnavailableError(
+          absl::StrCat("Couldn't read asset '", path, "'."));
+    }
+    out << path << " " << contents.size() << " "
+        << ContentHashString(contents) << "\n";
+  }
+  return WriteOutput(output_path, out.str());
+}
+
+}  // namespace dataminer
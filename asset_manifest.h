@@ -0,0 +1,81 @@
+#ifndef __ASSET_MANIFEST_H__
+#define __ASSET_MANIFEST_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace dataminer {
+
+// The set of files under the assets directory, read with one directory scan
+// at startup so that emitters can check whether an icon exists without a
+// stat() per unit.
+//
+// Emitters check assets with Reference(), which also remembers what they
+// asked for. Once every emitter is done, Missing() and Orphaned() report all
+// the broken or unused assets in one go, instead of one log line per unit.
+//
+// Paths are relative to the scanned root and use '/', e.g.
+// "characters/ui_image_portrait_spaceTitus.png". Safe to use from multiple
+// threads.
+class AssetManifest {
+ public:
+  // Recursively lists every regular file under `root`.
+  static absl::StatusOr<std::unique_ptr<AssetManifest>> Scan(
+      absl::string_view root);
+
+  // A manifest with no files, for when `root` can't be scanned, so that every
+  // referenced asset is reported missing.
+  static std::unique_ptr<AssetManifest> Empty(absl::string_view root);
+
+  AssetManifest(const AssetManifest&) = delete;
+  AssetManifest& operator=(const AssetManifest&) = delete;
+
+  // Returns true if `path` exists, and records that something refers to it.
+  bool Reference(absl::string_view path) const;
+
+  // Returns true if `path` exists, without recording a reference.
+  bool Contains(absl::string_view path) const {
+    return files_.contains(path);
+  }
+
+  // The referenced paths that don't exist, sorted.
+  std::vector<std::string> Missing() const;
+
+  // The existing paths starting with `prefix` that nothing referenced,
+  // sorted.
+  std::vector<std::string> Orphaned(absl::string_view prefix) const;
+
+  // Writes one "<path> <size> <content hash>" line per asset, sorted by
+  // path, to `output_path`. This reads every asset, so it's only done on
+  // request; the resulting file can be diffed to see which assets changed
+  // between game versions.
+  absl::Status Save(absl::string_view output_path) const;
+
+  // A hash of the sorted paths, which changes when an asset is added or
+  // removed, but not when one is modified.
+  std::string PathsHash() const;
+
+  size_t size() const { return files_.size(); }
+
+ private:
+  AssetManifest(std::string root, absl::flat_hash_set<std::string> files)
+      : root_(std::move(root)), files_(std::move(files)) {}
+
+  const std::string root_;
+  const absl::flat_hash_set<std::string> files_;
+
+  mutable absl::Mutex mu_;
+  mutable absl::flat_hash_set<std::string> referenced_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace dataminer
+
+#endif  // __ASSET_MANIFEST_H__
@@ -0,0 +1,99 @@
+#include "batch_queries.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "query_handler.h"
+#include "thread_pool.h"
+
+namespace dataminer {
+
+namespace {
+
+// How many queries each task answers. Big enough that scheduling is noise,
+// small enough that a chunk splits evenly over the threads.
+constexpr int kQueriesPerTask = 256;
+
+// A chunk of queries and their responses. The strings keep their capacity
+// from one chunk to the next, so after the first few chunks, lines are read
+// and responses written into buffers that are already big enough.
+struct Chunk {
+  std::vector<std::string> queries;
+  std::vector<std::string> responses;
+  // How many of `queries` this chunk holds.
+  int size = 0;
+};
+
+// Reads up to queries.size() non-blank lines into `chunk`.
+void Read(std::istream& in, Chunk& chunk) {
+  chunk.size = 0;
+  while (chunk.size < static_cast<int>(chunk.queries.size()) &&
+         std::getline(in, chunk.queries[chunk.size])) {
+    std::string& line = chunk.queries[chunk.size];
+    line.erase(absl::StripTrailingAsciiWhitespace(line).size());
+    if (!line.empty()) ++chunk.size;
+  }
+}
+
+void Write(const Chunk& chunk, std::ostream& out) {
+  for (int i = 0; i < chunk.size; ++i) {
+    out.write(chunk.responses[i].data(), chunk.responses[i].size());
+    out.put('\n');
+  }
+}
+
+// Queues the tasks that answer `chunk`.
+void Answer(const MinerSnapshot& snapshot, Chunk& chunk, ThreadPool& pool) {
+  for (int begin = 0; begin < chunk.size; begin += kQueriesPerTask) {
+    const int end = std::min(begin + kQueriesPerTask, chunk.size);
+    pool.Schedule([&snapshot, &chunk, begin, end] {
+      for (int i = begin; i < end; ++i) {
+        HandleQuery(snapshot, chunk.queries[i], chunk.responses[i]);
+      }
+    });
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<int64_t> RunBatchQueries(const MinerSnapshot& snapshot,
+                                        std::istream& in, std::ostream& out,
+                                        const int num_threads) {
+  ThreadPool pool(num_threads);
+  // A few tasks per thread, so a slow task doesn't leave the rest idle.
+  const int chunk_size = 4 * std::max(num_threads, 1) * kQueriesPerTask;
+  Chunk chunks[2];
+  for (Chunk& chunk : chunks) {
+    chunk.queries.resize(chunk_size);
+    chunk.responses.resize(chunk_size);
+  }
+
+  int64_t answered = 0;
+  int current = 0;
+  // Whether the other chunk has responses that haven't been written yet.
+  bool unwritten = false;
+  Read(in, chunks[current]);
+  while (chunks[current].size > 0) {
+    Chunk& chunk = chunks[current];
+    Chunk& other = chunks[1 - current];
+    Answer(snapshot, chunk, pool);
+    if (unwritten) Write(other, out);
+    Read(in, other);
+    pool.Wait();
+    answered += chunk.size;
+    unwritten = true;
+    current = 1 - current;
+  }
+  if (unwritten) Write(chunks[1 - current], out);
+  out.flush();
+
+  if (in.bad()) return absl::DataLossError("Error reading the queries.");
+  if (!out) return absl::DataLossError("Error writing the responses.");
+  return answered;
+}
+
+}  // namespace dataminer
@@ -0,0 +1,27 @@
+#ifndef __BATCH_QUERIES_H__
+#define __BATCH_QUERIES_H__
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+#include "absl/status/statusor.h"
+#include "miner_snapshot.h"
+
+namespace dataminer {
+
+// Answers every query in `in`, one line of JSON each (see query_handler.h),
+// and writes one response line per query to `out`, in the same order. Blank
+// lines are skipped.
+//
+// Queries are read in chunks and answered in parallel on `num_threads`
+// threads. While one chunk is being answered, the previous one is written
+// out and the next one read in, into buffers that are reused for the whole
+// run. Returns the number of queries answered.
+absl::StatusOr<int64_t> RunBatchQueries(const MinerSnapshot& snapshot,
+                                        std::istream& in, std::ostream& out,
+                                        int num_threads);
+
+}  // namespace dataminer
+
+#endif  // __BATCH_QUERIES_H__
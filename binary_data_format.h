@@ -0,0 +1,284 @@
+#ifndef __BINARY_DATA_FORMAT_H__
+#define __BINARY_DATA_FORMAT_H__
+
+// The layout of the planner's binary data file, written by CreateBinaryData
+// and read by BinaryDataReader.
+//
+// The file is built to be memory-mapped and used in place:
+//
+//   FileHeader
+//   SectionEntry[header.section_count]
+//   section data, each section starting on an 8-byte boundary
+//
+// Every section is an array of one fixed-width record type, except kStrings,
+// which is the string pool: every distinct string in the file, stored once,
+// back to back, without terminators. Records refer to strings with a
+// StringRef, and to runs of records in other sections with a ListRef.
+// Cross-references that the miner can resolve (e.g. a recipe ingredient to
+// its upgrade) are stored as record indices, with -1 meaning unresolved.
+//
+// All integers are little-endian. Any change to a record's layout bumps
+// kVersion, and readers reject versions and record sizes they don't know.
+
+#include <cstdint>
+
+#include "absl/base/config.h"
+
+#ifndef ABSL_IS_LITTLE_ENDIAN
+#error "The binary data format is only defined for little-endian hosts."
+#endif
+
+namespace dataminer {
+namespace binary_data {
+
+inline constexpr char kMagic[8] = {'T', 'A', 'C', 'D', 'A', 'T', 'A', '\0'};
+inline constexpr uint32_t kVersion = 3;
+
+enum SectionKind : uint32_t {
+  kStrings = 1,            // char
+  kStringLists = 2,        // StringRef
+  kCharacters = 3,         // CharacterRecord
+  kRankUps = 4,            // RankUpRecord
+  kUpgrades = 5,           // UpgradeRecord
+  kIngredients = 6,        // IngredientRecord
+  kCampaigns = 7,          // CampaignRecord
+  kBattles = 8,            // BattleRecord
+  kGuaranteedRewards = 9,  // GuaranteedRewardRecord
+  kItems = 10,             // ItemRecord
+  kItemLevels = 11,        // ItemLevelRecord
+  kMows = 12,              // MowRecord
+  kMowRecipes = 13,        // MowRecipeRecord
+  kMowUpgradeCosts = 14,   // MowUpgradeCostRecord
+  kNpcs = 15,              // NpcRecord
+  kEnemies = 16,           // EnemyRecord
+  kNpcStats = 17,          // NpcStatsRecord
+};
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t section_count;
+  uint64_t file_size;
+};
+
+struct SectionEntry {
+  uint32_t kind;  // A SectionKind.
+  uint32_t record_size;
+  uint64_t offset;  // From the start of the file.
+  uint64_t count;   // The number of records.
+};
+
+// A string in the kStrings pool.
+struct StringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+// A run of `count` records starting at index `begin` of some other section.
+struct ListRef {
+  uint32_t begin;
+  uint32_t count;
+};
+
+// Carries every field of the planner's character JSON.
+struct CharacterRecord {
+  StringRef id;
+  StringRef name;
+  StringRef title;
+  StringRef full_name;
+  StringRef short_name;
+  StringRef extra_short_name;
+  StringRef faction;
+  StringRef alliance;
+  StringRef base_rarity;
+  StringRef melee_damage_type;
+  StringRef ranged_damage_type;  // Empty if the unit has no ranged attack.
+  StringRef equipment_slots[3];
+  StringRef icon;        // See GetIconPath.
+  StringRef round_icon;  // See GetRoundIconPath.
+  int32_t health;
+  int32_t damage;
+  int32_t armor;
+  int32_t movement;
+  int32_t melee_hits;
+  int32_t ranged_hits;
+  int32_t ranged_range;
+  int32_t avatar_index;  // Index into the game's avatars, or -1.
+  ListRef traits;        // kStringLists
+  ListRef rank_ups;      // kRankUps, one per rank starting at Stone I.
+  // The distinct, sorted damage types of the unit's abilities.
+  ListRef active_ability_damage_types;   // kStringLists
+  ListRef passive_ability_damage_types;  // kStringLists
+};
+
+// The six materials needed to leave one rank, in the order the planner's
+// rank-up JSON lists them.
+struct RankUpRecord {
+  StringRef top_row_health;
+  StringRef bottom_row_health;
+  StringRef top_row_damage;
+  StringRef bottom_row_damage;
+  StringRef top_row_armor;
+  StringRef bottom_row_armor;
+};
+
+struct UpgradeRecord {
+  StringRef id;
+  StringRef name;
+  StringRef rarity;
+  StringRef stat_type;
+  int32_t gold;
+  uint32_t craftable;    // 1 if the upgrade has a recipe.
+  ListRef ingredients;   // kIngredients
+};
+
+struct IngredientRecord {
+  StringRef id;
+  int32_t upgrade_index;  // Index into kUpgrades, or -1.
+  int32_t amount;
+};
+
+struct CampaignRecord {
+  StringRef id;
+  ListRef battles;           // kBattles
+  ListRef allowed_factions;  // kStringLists
+};
+
+struct BattleRecord {
+  StringRef id;
+  StringRef boss;
+  StringRef chance_id;
+  int32_t campaign_index;  // Index into kCampaigns.
+  int32_t energy_cost;
+  int32_t max_attempts;
+  int32_t spawn_points;
+  int32_t lightning_victory;
+  int32_t chance_numerator;
+  int32_t chance_denominator;
+  float effective_rate;
+  ListRef guaranteed;      // kGuaranteedRewards
+  ListRef required_units;  // kStringLists
+  ListRef enemies;         // kEnemies
+};
+
+// One of a battle's enemy types, resolved from the config's raw
+// "npcId:level" strings. Entries the miner couldn't resolve are left out.
+struct EnemyRecord {
+  int32_t npc_index;  // Index into kNpcs.
+  int32_t level;      // Index into the NPC's stats, after corrections.
+  int32_t count;      // How many of this NPC at this level the battle has.
+};
+
+struct GuaranteedRewardRecord {
+  StringRef id;
+  int32_t min;
+  int32_t max;
+};
+
+struct ItemRecord {
+  StringRef id;
+  StringRef name;
+  StringRef rarity;
+  StringRef type;
+  StringRef ability_id;
+  uint32_t is_relic;
+  uint32_t is_unique_relic;
+  ListRef allowed_units;     // kStringLists
+  ListRef allowed_factions;  // kStringLists
+  ListRef levels;            // kItemLevels
+};
+
+// The indices into ItemLevelRecord::stats, in the planner's JSON order.
+enum ItemStat : uint32_t {
+  kBlockChance = 0,
+  kBlockDamage,
+  kBlockChanceBonus,
+  kBlockDamageBonus,
+  kCritChance,
+  kCritDamage,
+  kCritChanceBonus,
+  kCritDamageBonus,
+  kArmor,
+  kHp,
+  kNumItemStats,
+};
+
+struct ItemLevelRecord {
+  int32_t gold_cost;
+  int32_t salvage_cost;
+  int32_t mythic_salvage_cost;
+  uint32_t stats_present;  // Bit i is set if stats[i] is present.
+  int32_t stats[kNumItemStats];
+};
+
+struct MowRecord {
+  StringRef id;
+  StringRef name;
+  StringRef short_name;
+  StringRef title;
+  StringRef faction;
+  StringRef alliance;
+  StringRef primary_ability;
+  StringRef secondary_ability;
+  ListRef primary_recipes;    // kMowRecipes
+  ListRef secondary_recipes;  // kMowRecipes
+};
+
+struct MowRecipeRecord {
+  StringRef materials[3];
+};
+
+// In the config's NPC order, so EnemyRecord::npc_index indexes it directly.
+struct NpcRecord {
+  StringRef id;
+  StringRef name;
+  StringRef faction;
+  StringRef alliance;
+  ListRef stats;  // kNpcStats, in the config's order.
+};
+
+// One entry of an NPC's stats table, which EnemyRecord::level indexes.
+struct NpcStatsRecord {
+  int32_t level;
+  int32_t rank;
+  int32_t stars;
+  int32_t damage;
+  int32_t armor;
+  int32_t health;
+};
+
+struct MowUpgradeCostRecord {
+  int32_t gold;
+  int32_t salvage;
+  int32_t components;
+  int32_t badges_amount;
+  int32_t forge_badges_amount;
+  uint32_t reserved;
+  StringRef badges_rarity;
+  StringRef forge_badges_rarity;
+};
+
+static_assert(sizeof(FileHeader) == 24);
+static_assert(sizeof(SectionEntry) == 24);
+static_assert(sizeof(StringRef) == 8);
+static_assert(sizeof(ListRef) == 8);
+static_assert(sizeof(CharacterRecord) == 192);
+static_assert(sizeof(RankUpRecord) == 48);
+static_assert(sizeof(UpgradeRecord) == 48);
+static_assert(sizeof(IngredientRecord) == 16);
+static_assert(sizeof(CampaignRecord) == 24);
+static_assert(sizeof(BattleRecord) == 80);
+static_assert(sizeof(EnemyRecord) == 12);
+static_assert(sizeof(GuaranteedRewardRecord) == 16);
+static_assert(sizeof(ItemRecord) == 72);
+static_assert(sizeof(ItemLevelRecord) == 56);
+static_assert(sizeof(MowRecord) == 80);
+static_assert(sizeof(MowRecipeRecord) == 24);
+static_assert(sizeof(MowUpgradeCostRecord) == 40);
+static_assert(sizeof(NpcRecord) == 40);
+static_assert(sizeof(NpcStatsRecord) == 24);
+
+}  // namespace binary_data
+}  // namespace dataminer
+
+#endif  // __BINARY_DATA_FORMAT_H__
@@ -0,0 +1,338 @@
+#include "binary_data_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "status_macros.h"
+
+namespace dataminer {
+
+namespace {
+
+using binary_data::CampaignRecord;
+using binary_data::CharacterRecord;
+using binary_data::FileHeader;
+using binary_data::ListRef;
+using binary_data::SectionEntry;
+using binary_data::StringRef;
+
+// The record size of each SectionKind, indexed by kind. Zero marks a kind
+// that doesn't exist.
+constexpr uint32_t kRecordSizes[] = {
+    0,
+    sizeof(char),
+    sizeof(binary_data::StringRef),
+    sizeof(binary_data::CharacterRecord),
+    sizeof(binary_data::RankUpRecord),
+    sizeof(binary_data::UpgradeRecord),
+    sizeof(binary_data::IngredientRecord),
+    sizeof(binary_data::CampaignRecord),
+    sizeof(binary_data::BattleRecord),
+    sizeof(binary_data::GuaranteedRewardRecord),
+    sizeof(binary_data::ItemRecord),
+    sizeof(binary_data::ItemLevelRecord),
+    sizeof(binary_data::MowRecord),
+    sizeof(binary_data::MowRecipeRecord),
+    sizeof(binary_data::MowUpgradeCostRecord),
+    sizeof(binary_data::NpcRecord),
+    sizeof(binary_data::EnemyRecord),
+    sizeof(binary_data::NpcStatsRecord),
+};
+static_assert(sizeof(kRecordSizes) / sizeof(kRecordSizes[0]) ==
+              binary_data::kNpcStats + 1);
+
+absl::Status CorruptError(const absl::string_view what) {
+  return absl::DataLossError(absl::StrCat("Corrupt binary data: ", what));
+}
+
+// Checks the references of one section's records against the rest of the
+// file. Each check names the offending record, so a bad file is easy to
+// track down with the validator.
+class ReferenceChecker {
+ public:
+  explicit ReferenceChecker(const size_t strings_size)
+      : strings_size_(strings_size) {}
+
+  absl::Status String(const StringRef ref, const absl::string_view what,
+                      const size_t index) const {
+    const uint64_t end = uint64_t{ref.offset} + ref.length;
+    if (end > strings_size_) {
+      return CorruptError(absl::StrCat(what, " ", index,
+                                       " refers to a string past the end of "
+                                       "the string pool."));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status List(const ListRef ref, const size_t section_size,
+                    const absl::string_view what, const size_t index) const {
+    if (uint64_t{ref.begin} + ref.count > section_size) {
+      return CorruptError(
+          absl::StrCat(what, " ", index, " refers to records [", ref.begin,
+                       ", ", uint64_t{ref.begin} + ref.count,
+                       ") of a section with ", section_size, " records."));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Index(const int32_t ref, const size_t section_size,
+                     const absl::string_view what, const size_t index) const {
+    if (ref < -1 || (ref >= 0 && static_cast<size_t>(ref) >= section_size)) {
+      return CorruptError(absl::StrCat(what, " ", index, " refers to record ",
+                                       ref, " of a section with ",
+                                       section_size, " records."));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  const size_t strings_size_;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<BinaryDataReader>> BinaryDataReader::Open(
+    const absl::string_view path) {
+  const std::string path_str(path);
+  const int fd = open(path_str.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::NotFoundError(absl::StrCat("Couldn't open '", path, "': ",
+                                            std::strerror(errno)));
+  }
+  struct stat sbuf;
+  if (fstat(fd, &sbuf) != 0) {
+    const absl::Status status = absl::UnavailableError(absl::StrCat(
+        "Couldn't stat '", path, "': ", std::strerror(errno)));
+    close(fd);
+    return status;
+  }
+  const size_t size = static_cast<size_t>(sbuf.st_size);
+  if (size == 0) {
+    close(fd);
+    return CorruptError(absl::StrCat("'", path, "' is empty."));
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive on its own.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return absl::UnavailableError(absl::StrCat("Couldn't map '", path, "': ",
+                                               std::strerror(errno)));
+  }
+  std::unique_ptr<BinaryDataReader> reader(new BinaryDataReader(
+      absl::string_view(static_cast<const char*>(mapping), size), mapping,
+      size));
+  if (absl::Status status = reader->Init(); !status.ok()) return status;
+  return reader;
+}
+
+absl::StatusOr<std::unique_ptr<BinaryDataReader>> BinaryDataReader::FromBuffer(
+    const absl::string_view data) {
+  if (reinterpret_cast<uintptr_t>(data.data()) % 8 != 0) {
+    return absl::InvalidArgumentError(
+        "Binary data buffers must be 8-byte aligned.");
+  }
+  std::unique_ptr<BinaryDataReader> reader(
+      new BinaryDataReader(data, nullptr, 0));
+  if (absl::Status status = reader->Init(); !status.ok()) return status;
+  return reader;
+}
+
+BinaryDataReader::~BinaryDataReader() {
+  if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+}
+
+absl::Status BinaryDataReader::Init() {
+  if (data_.size() < sizeof(FileHeader)) {
+    return CorruptError("the file is smaller than its header.");
+  }
+  FileHeader header;
+  std::memcpy(&header, data_.data(), sizeof(header));
+  if (std::memcmp(header.magic, binary_data::kMagic, sizeof(header.magic)) !=
+      0) {
+    return CorruptError("bad magic.");
+  }
+  if (header.version != binary_data::kVersion) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("Unsupported binary data version ", header.version,
+                     "; this reader understands version ",
+                     binary_data::kVersion, "."));
+  }
+  if (header.file_size != data_.size()) {
+    return CorruptError(absl::StrCat("the header says the file has ",
+                                     header.file_size, " bytes, but it has ",
+                                     data_.size(), "."));
+  }
+  const uint64_t table_end =
+      sizeof(FileHeader) +
+      uint64_t{header.section_count} * sizeof(SectionEntry);
+  if (table_end > data_.size()) {
+    return CorruptError("the section table runs past the end of the file.");
+  }
+
+  const auto* entries =
+      reinterpret_cast<const SectionEntry*>(data_.data() + sizeof(FileHeader));
+  for (uint32_t i = 0; i < header.section_count; ++i) {
+    const SectionEntry& entry = entries[i];
+    if (entry.kind == 0 || entry.kind > kMaxSectionKind) {
+      return CorruptError(absl::StrCat("unknown section kind ", entry.kind));
+    }
+    if (entry.record_size != kRecordSizes[entry.kind]) {
+      return CorruptError(absl::StrCat(
+          "section ", entry.kind, " has ", entry.record_size,
+          "-byte records; expected ", kRecordSizes[entry.kind], "."));
+    }
+    if (sections_[entry.kind].data != nullptr) {
+      return CorruptError(absl::StrCat("duplicate section ", entry.kind));
+    }
+    if (entry.offset % 8 != 0 || entry.offset < table_end ||
+        entry.offset > data_.size() ||
+        entry.count > (data_.size() - entry.offset) / entry.record_size) {
+      return CorruptError(absl::StrCat("section ", entry.kind,
+                                       " is out of bounds or misaligned."));
+    }
+    sections_[entry.kind] = {data_.data() + entry.offset, entry.count};
+  }
+  strings_ = absl::string_view(sections_[binary_data::kStrings].data,
+                               sections_[binary_data::kStrings].count);
+  return absl::OkStatus();
+}
+
+absl::Status BinaryDataReader::Validate() const {
+  const ReferenceChecker check(strings_.size());
+
+  for (size_t i = 0; i < string_lists().size(); ++i) {
+    RETURN_IF_ERROR(check.String(string_lists()[i], "string list", i));
+  }
+  for (size_t i = 0; i < characters().size(); ++i) {
+    const CharacterRecord& c = characters()[i];
+    for (const StringRef ref :
+         {c.id, c.name, c.title, c.full_name, c.short_name,
+          c.extra_short_name, c.faction, c.alliance, c.base_rarity,
+          c.melee_damage_type, c.ranged_damage_type, c.equipment_slots[0],
+          c.equipment_slots[1], c.equipment_slots[2], c.icon, c.round_icon}) {
+      RETURN_IF_ERROR(check.String(ref, "character", i));
+    }
+    RETURN_IF_ERROR(
+        check.List(c.traits, string_lists().size(), "character", i));
+    RETURN_IF_ERROR(check.List(c.rank_ups, rank_ups().size(), "character", i));
+    RETURN_IF_ERROR(check.List(c.active_ability_damage_types,
+                               string_lists().size(), "character", i));
+    RETURN_IF_ERROR(check.List(c.passive_ability_damage_types,
+                               string_lists().size(), "character", i));
+  }
+  for (size_t i = 0; i < rank_ups().size(); ++i) {
+    const binary_data::RankUpRecord& r = rank_ups()[i];
+    for (const StringRef ref :
+         {r.top_row_health, r.bottom_row_health, r.top_row_damage,
+          r.bottom_row_damage, r.top_row_armor, r.bottom_row_armor}) {
+      RETURN_IF_ERROR(check.String(ref, "rank-up", i));
+    }
+  }
+  for (size_t i = 0; i < upgrades().size(); ++i) {
+    const binary_data::UpgradeRecord& u = upgrades()[i];
+    for (const StringRef ref : {u.id, u.name, u.rarity, u.stat_type}) {
+      RETURN_IF_ERROR(check.String(ref, "upgrade", i));
+    }
+    RETURN_IF_ERROR(
+        check.List(u.ingredients, ingredients().size(), "upgrade", i));
+  }
+  for (size_t i = 0; i < ingredients().size(); ++i) {
+    const binary_data::IngredientRecord& ingredient = ingredients()[i];
+    RETURN_IF_ERROR(check.String(ingredient.id, "ingredient", i));
+    RETURN_IF_ERROR(check.Index(ingredient.upgrade_index, upgrades().size(),
+                                "ingredient", i));
+  }
+  for (size_t i = 0; i < campaigns().size(); ++i) {
+    const CampaignRecord& c = campaigns()[i];
+    RETURN_IF_ERROR(check.String(c.id, "campaign", i));
+    RETURN_IF_ERROR(check.List(c.battles, battles().size(), "campaign", i));
+    RETURN_IF_ERROR(
+        check.List(c.allowed_factions, string_lists().size(), "campaign", i));
+  }
+  for (size_t i = 0; i < battles().size(); ++i) {
+    const binary_data::BattleRecord& b = battles()[i];
+    for (const StringRef ref : {b.id, b.boss, b.chance_id}) {
+      RETURN_IF_ERROR(check.String(ref, "battle", i));
+    }
+    RETURN_IF_ERROR(
+        check.Index(b.campaign_index, campaigns().size(), "battle", i));
+    RETURN_IF_ERROR(
+        check.List(b.guaranteed, guaranteed_rewards().size(), "battle", i));
+    RETURN_IF_ERROR(
+        check.List(b.required_units, string_lists().size(), "battle", i));
+    RETURN_IF_ERROR(check.List(b.enemies, enemies().size(), "battle", i));
+  }
+  for (size_t i = 0; i < enemies().size(); ++i) {
+    const binary_data::EnemyRecord& enemy = enemies()[i];
+    if (enemy.npc_index < 0 || enemy.level < 0 || enemy.count <= 0) {
+      return CorruptError(absl::StrCat("enemy ", i, " has NPC ",
+                                       enemy.npc_index, ", level ",
+                                       enemy.level, " and count ",
+                                       enemy.count, "."));
+    }
+    RETURN_IF_ERROR(check.Index(enemy.npc_index, npcs().size(), "enemy", i));
+    if (static_cast<uint32_t>(enemy.level) >=
+        npcs()[enemy.npc_index].stats.count) {
+      return CorruptError(absl::StrCat(
+          "enemy ", i, " has level ", enemy.level, ", but its NPC has ",
+          npcs()[enemy.npc_index].stats.count, " levels of stats."));
+    }
+  }
+  for (size_t i = 0; i < guaranteed_rewards().size(); ++i) {
+    RETURN_IF_ERROR(
+        check.String(guaranteed_rewards()[i].id, "guaranteed reward", i));
+  }
+  for (size_t i = 0; i < items().size(); ++i) {
+    const binary_data::ItemRecord& item = items()[i];
+    for (const StringRef ref :
+         {item.id, item.name, item.rarity, item.type, item.ability_id}) {
+      RETURN_IF_ERROR(check.String(ref, "item", i));
+    }
+    RETURN_IF_ERROR(
+        check.List(item.allowed_units, string_lists().size(), "item", i));
+    RETURN_IF_ERROR(
+        check.List(item.allowed_factions, string_lists().size(), "item", i));
+    RETURN_IF_ERROR(check.List(item.levels, item_levels().size(), "item", i));
+  }
+  for (size_t i = 0; i < mows().size(); ++i) {
+    const binary_data::MowRecord& mow = mows()[i];
+    for (const StringRef ref :
+         {mow.id, mow.name, mow.short_name, mow.title, mow.faction,
+          mow.alliance, mow.primary_ability, mow.secondary_ability}) {
+      RETURN_IF_ERROR(check.String(ref, "MoW", i));
+    }
+    RETURN_IF_ERROR(
+        check.List(mow.primary_recipes, mow_recipes().size(), "MoW", i));
+    RETURN_IF_ERROR(
+        check.List(mow.secondary_recipes, mow_recipes().size(), "MoW", i));
+  }
+  for (size_t i = 0; i < mow_recipes().size(); ++i) {
+    for (const StringRef ref : mow_recipes()[i].materials) {
+      RETURN_IF_ERROR(check.String(ref, "MoW recipe", i));
+    }
+  }
+  for (size_t i = 0; i < mow_upgrade_costs().size(); ++i) {
+    const binary_data::MowUpgradeCostRecord& cost = mow_upgrade_costs()[i];
+    for (const StringRef ref : {cost.badges_rarity, cost.forge_badges_rarity}) {
+      RETURN_IF_ERROR(check.String(ref, "MoW upgrade cost", i));
+    }
+  }
+  for (size_t i = 0; i < npcs().size(); ++i) {
+    const binary_data::NpcRecord& npc = npcs()[i];
+    for (const StringRef ref : {npc.id, npc.name, npc.faction, npc.alliance}) {
+      RETURN_IF_ERROR(check.String(ref, "NPC", i));
+    }
+    RETURN_IF_ERROR(check.List(npc.stats, npc_stats().size(), "NPC", i));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace dataminer
@@ -0,0 +1,138 @@
+#ifndef __BINARY_DATA_READER_H__
+#define __BINARY_DATA_READER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "binary_data_format.h"
+
+namespace dataminer {
+
+// Reads the file written by CreateBinaryData in place. Opening a file checks
+// its header and section table, which is cheap and independent of the file's
+// size; the records themselves are never copied or decoded, the accessors
+// just point into the mapping.
+//
+// A reader is immutable once opened, so it can be shared between threads.
+class BinaryDataReader {
+ public:
+  // Maps the file at `path` into memory.
+  static absl::StatusOr<std::unique_ptr<BinaryDataReader>> Open(
+      absl::string_view path);
+
+  // Reads from `data`, which must outlive the reader and start on an 8-byte
+  // boundary.
+  static absl::StatusOr<std::unique_ptr<BinaryDataReader>> FromBuffer(
+      absl::string_view data);
+
+  BinaryDataReader(const BinaryDataReader&) = delete;
+  BinaryDataReader& operator=(const BinaryDataReader&) = delete;
+  ~BinaryDataReader();
+
+  // Checks that every StringRef, ListRef and record index in the file is in
+  // bounds. Unlike opening, this touches every record, so it's meant for
+  // tools and tests rather than the serving path.
+  absl::Status Validate() const;
+
+  absl::string_view String(binary_data::StringRef ref) const {
+    return absl::string_view(strings_.data() + ref.offset, ref.length);
+  }
+  absl::Span<const binary_data::StringRef> StringList(
+      binary_data::ListRef ref) const {
+    return string_lists().subspan(ref.begin, ref.count);
+  }
+
+  absl::Span<const binary_data::StringRef> string_lists() const {
+    return Records<binary_data::StringRef>(binary_data::kStringLists);
+  }
+  absl::Span<const binary_data::CharacterRecord> characters() const {
+    return Records<binary_data::CharacterRecord>(binary_data::kCharacters);
+  }
+  absl::Span<const binary_data::RankUpRecord> rank_ups() const {
+    return Records<binary_data::RankUpRecord>(binary_data::kRankUps);
+  }
+  absl::Span<const binary_data::UpgradeRecord> upgrades() const {
+    return Records<binary_data::UpgradeRecord>(binary_data::kUpgrades);
+  }
+  absl::Span<const binary_data::IngredientRecord> ingredients() const {
+    return Records<binary_data::IngredientRecord>(binary_data::kIngredients);
+  }
+  absl::Span<const binary_data::CampaignRecord> campaigns() const {
+    return Records<binary_data::CampaignRecord>(binary_data::kCampaigns);
+  }
+  absl::Span<const binary_data::BattleRecord> battles() const {
+    return Records<binary_data::BattleRecord>(binary_data::kBattles);
+  }
+  absl::Span<const binary_data::GuaranteedRewardRecord> guaranteed_rewards()
+      const {
+    return Records<binary_data::GuaranteedRewardRecord>(
+        binary_data::kGuaranteedRewards);
+  }
+  absl::Span<const binary_data::ItemRecord> items() const {
+    return Records<binary_data::ItemRecord>(binary_data::kItems);
+  }
+  absl::Span<const binary_data::ItemLevelRecord> item_levels() const {
+    return Records<binary_data::ItemLevelRecord>(binary_data::kItemLevels);
+  }
+  absl::Span<const binary_data::MowRecord> mows() const {
+    return Records<binary_data::MowRecord>(binary_data::kMows);
+  }
+  absl::Span<const binary_data::MowRecipeRecord> mow_recipes() const {
+    return Records<binary_data::MowRecipeRecord>(binary_data::kMowRecipes);
+  }
+  absl::Span<const binary_data::MowUpgradeCostRecord> mow_upgrade_costs()
+      const {
+    return Records<binary_data::MowUpgradeCostRecord>(
+        binary_data::kMowUpgradeCosts);
+  }
+  absl::Span<const binary_data::NpcRecord> npcs() const {
+    return Records<binary_data::NpcRecord>(binary_data::kNpcs);
+  }
+  absl::Span<const binary_data::EnemyRecord> enemies() const {
+    return Records<binary_data::EnemyRecord>(binary_data::kEnemies);
+  }
+  absl::Span<const binary_data::NpcStatsRecord> npc_stats() const {
+    return Records<binary_data::NpcStatsRecord>(binary_data::kNpcStats);
+  }
+
+  // The total size of the file, in bytes.
+  size_t size() const { return data_.size(); }
+
+ private:
+  // The highest SectionKind this reader knows about.
+  static constexpr uint32_t kMaxSectionKind = binary_data::kNpcStats;
+
+  struct Section {
+    const char* data = nullptr;
+    uint64_t count = 0;
+  };
+
+  BinaryDataReader(absl::string_view data, void* mapping, size_t mapping_size)
+      : data_(data), mapping_(mapping), mapping_size_(mapping_size) {}
+
+  // Checks the header and section table and fills in `sections_`.
+  absl::Status Init();
+
+  template <typename T>
+  absl::Span<const T> Records(const binary_data::SectionKind kind) const {
+    const Section& section = sections_[kind];
+    return absl::Span<const T>(reinterpret_cast<const T*>(section.data),
+                               section.count);
+  }
+
+  absl::string_view data_;
+  // The mmap backing `data_`, or null if the caller owns the buffer.
+  void* mapping_;
+  size_t mapping_size_;
+  absl::string_view strings_;
+  Section sections_[kMaxSectionKind + 1];
+};
+
+}  // namespace dataminer
+
+#endif  // __BINARY_DATA_READER_H__
@@ -0,0 +1,66 @@
+// Checks a binary data file written by the miner's --binary_data output, and
+// prints how many records each section holds.
+//
+// bazel run -c opt :binary_data_validator --
+//   --binary_data=$MINING_OUTPUT/newPlannerData.bin
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "binary_data_reader.h"
+
+ABSL_FLAG(std::string, binary_data, "",
+          "The binary data file to validate.");
+
+namespace dataminer {
+namespace {
+
+absl::Status Main() {
+  absl::StatusOr<std::unique_ptr<BinaryDataReader>> reader =
+      BinaryDataReader::Open(absl::GetFlag(FLAGS_binary_data));
+  if (!reader.ok()) return reader.status();
+  if (absl::Status status = (*reader)->Validate(); !status.ok()) {
+    return status;
+  }
+  const BinaryDataReader& data = **reader;
+  std::cout << "size:               " << data.size() << " bytes\n"
+            << "characters:         " << data.characters().size() << "\n"
+            << "rank ups:           " << data.rank_ups().size() << "\n"
+            << "upgrades:           " << data.upgrades().size() << "\n"
+            << "ingredients:        " << data.ingredients().size() << "\n"
+            << "campaigns:          " << data.campaigns().size() << "\n"
+            << "battles:            " << data.battles().size() << "\n"
+            << "enemies:            " << data.enemies().size() << "\n"
+            << "guaranteed rewards: " << data.guaranteed_rewards().size()
+            << "\n"
+            << "items:              " << data.items().size() << "\n"
+            << "item levels:        " << data.item_levels().size() << "\n"
+            << "MoWs:               " << data.mows().size() << "\n"
+            << "MoW recipes:        " << data.mow_recipes().size() << "\n"
+            << "MoW upgrade costs:  " << data.mow_upgrade_costs().size()
+            << "\n"
+            << "NPCs:               " << data.npcs().size() << "\n"
+            << "NPC stats:          " << data.npc_stats().size() << "\n"
+            << "string lists:       " << data.string_lists().size() << "\n";
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace dataminer
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+  if (absl::Status status = dataminer::Main(); !status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
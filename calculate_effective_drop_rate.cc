@@ -1,12 +1,18 @@
+#include "calculate_effective_drop_rate.h"
+
 #include <cstdio>
 #include <map>
 #include <random>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/flags/flag.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "metrics.h"
 #include "miner.pb.h"
+#include "trace.h"
 
 ABSL_FLAG(int, effective_rate_simulation_runs, 1'000'000'000,
           "Number of simulation runs for effective rate calculation");
@@ -27,6 +33,7 @@ namespace {
 // increases the chance of certain rewards. The lower the denominator, the much
 // higher the effective rate is compared to the calculated rate.
 float Calculate(const int num_runs, const int num, const int denom) {
+  TRACE_SCOPE("SimulateDropRate");
   if (num_runs <= 0) {
     LOG(ERROR) << "Invalid number of simulation runs: " << num_runs;
     return 0.0f;
@@ -67,20 +74,25 @@ float Calculate(const int num_runs, const int num, const int denom) {
   return static_cast<float>(success) / num_runs;
 }
 
+// The effective rates simulated so far, backed by --drop_rate_config_path.
+// Gameconfigs can be loaded from several threads at once (see miner_c_api.h),
+// so every access goes through `mu_`.
 class RateStorage {
  public:
-  static void Init() { rate_storage_.InitImpl(); }
-
-  static void Add(const int num_sims, const int num, const int denom,
-                  const int ratex1000) {
-    rate_storage_.AddImpl(num_sims, num, denom, ratex1000);
-
+  // Stores `ratex1000` unless another thread got there first, and returns the
+  // rate that's stored either way.
+  static int Add(const int num_sims, const int num, const int denom,
+                 const int ratex1000) {
+    absl::MutexLock lock(&rate_storage_.mu_);
+    const int stored = rate_storage_.AddImpl(num_sims, num, denom, ratex1000);
     rate_storage_.Persist();
+    return stored;
   }
 
   static std::optional<int> Get(const int num_sims, const int num,
                                 const int denom) {
-    Init();
+    absl::MutexLock lock(&rate_storage_.mu_);
+    rate_storage_.InitImpl();
     const auto& inner_map = rate_storage_.rates_[num_sims][num];
     const auto it = inner_map.find(denom);
     if (it != inner_map.end()) return it->second;
@@ -90,7 +102,7 @@ class RateStorage {
  private:
   RateStorage() {}
 
-  DropRateConfig Convert() {
+  DropRateConfig Convert() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     InitImpl();
     DropRateConfig config;
     for (const auto& [num_sims, outer_map] : rates_) {
@@ -108,19 +120,14 @@ class RateStorage {
     return config;
   }
 
-  void AddImpl(const int num_sims, const int num, const int denom,
-               const int ratex1000) {
+  int AddImpl(const int num_sims, const int num, const int denom,
+              const int ratex1000) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     InitImpl();
-    std::map<int, int>& inner_map = rates_[num_sims][num];
-    auto it = inner_map.find(denom);
-    if (it != inner_map.end()) {
-      // Silently drop duplicates.
-      return;
-    }
-    inner_map[denom] = ratex1000;
+    // Silently drop duplicates.
+    return rates_[num_sims][num].try_emplace(denom, ratex1000).first->second;
   }
 
-  void Persist() {
+  void Persist() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     const std::string path = absl::GetFlag(FLAGS_drop_rate_config_path);
     if (path.empty()) {
       // Do nothing if we don't have persistent storage.
@@ -129,12 +136,12 @@ class RateStorage {
     FILE* fp = fopen(path.c_str(), "w");
     CHECK(fp != nullptr) << "Failed to open '" << path
                          << "' to write drop rates.";
-    std::string out = rate_storage_.Convert().SerializeAsString();
+    std::string out = Convert().SerializeAsString();
     fwrite(out.data(), 1, out.size(), fp);
     fclose(fp);
   }
 
-  void InitImpl() {
+  void InitImpl() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     if (is_initted_) return;
     is_initted_ = true;
     const std::string path = absl::GetFlag(FLAGS_drop_rate_config_path);
@@ -170,9 +177,10 @@ class RateStorage {
     }
   }
 
+  absl::Mutex mu_;
   // num_sims -> <num, -> <denom, rate*1000>>>
-  std::map<int, std::map<int, std::map<int, int>>> rates_;
-  bool is_initted_ = false;
+  std::map<int, std::map<int, std::map<int, int>>> rates_ ABSL_GUARDED_BY(mu_);
+  bool is_initted_ ABSL_GUARDED_BY(mu_) = false;
 
   static RateStorage rate_storage_;
 };
@@ -181,17 +189,33 @@ RateStorage RateStorage::rate_storage_;
 
 }  // namespace
 
+DropRateSource GetDropRateSource() {
+  return {absl::GetFlag(FLAGS_drop_rate_config_path),
+          absl::GetFlag(FLAGS_effective_rate_simulation_runs)};
+}
+
 float CalculateEffectiveDropRate(const int num, const int denom) {
   static const int num_sims =
       absl::GetFlag(FLAGS_effective_rate_simulation_runs);
+  static Counter& hits = Metrics::Get().GetCounter(
+      "miner_drop_rate_cache_hits_total",
+      "Effective drop rates found in the drop-rate config.");
+  static Counter& misses = Metrics::Get().GetCounter(
+      "miner_drop_rate_cache_misses_total",
+      "Effective drop rates that had to be simulated.");
   if (const std::optional<int> rate = RateStorage::Get(num_sims, num, denom);
       rate.has_value()) {
+    hits.Increment();
     return *rate / 1000.0f;
   }
-  const float rate = Calculate(num_sims, num, denom);
-  RateStorage::Add(num_sims, num, denom, static_cast<int>(rate * 1000));
-
-  return rate;
+  misses.Increment();
+  const int ratex1000 = RateStorage::Add(
+      num_sims, num, denom,
+      static_cast<int>(Calculate(num_sims, num, denom) * 1000));
+
+  // Return what later runs will read back, so that outputs built in the run
+  // that simulates a rate match the ones built after it.
+  return ratex1000 / 1000.0f;
 }
 
 }  // namespace dataminer
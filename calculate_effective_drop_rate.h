@@ -1,10 +1,21 @@
 #ifndef __CALCULATE_EFFECTIVE_DROP_RATE_H__
 #define __CALCULATE_EFFECTIVE_DROP_RATE_H__
 
+#include <string>
+
 namespace dataminer {
 
 float CalculateEffectiveDropRate(int num, int denom);
 
+// Where CalculateEffectiveDropRate's answers come from: the rates persisted
+// in `config_path` (empty if they aren't persisted) for `simulation_runs`
+// runs per rate.
+struct DropRateSource {
+  std::string config_path;
+  int simulation_runs;
+};
+DropRateSource GetDropRateSource();
+
 }  // namespace dataminer
 
 #endif  // __CALCULATE_EFFECTIVE_DROP_RATE_H__
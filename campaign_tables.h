@@ -0,0 +1,227 @@
+#ifndef __CAMPAIGN_TABLES_H__
+#define __CAMPAIGN_TABLES_H__
+
+// Constant tables for the display strings the planner uses for campaigns and
+// ranks. Everything here is evaluated at compile time, and lookups never
+// allocate.
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
+namespace dataminer {
+
+struct CampaignInfo {
+  // Snowprint's campaign ID.
+  absl::string_view id;
+  // The campaign's display name in the planner.
+  absl::string_view name;
+  // What the planner puts in front of a battle number to name a node, e.g.
+  // "FoCE" for Fall of Cadia Elite.
+  absl::string_view battle_prefix;
+};
+
+// Sorted by ID, so FindCampaign can binary search it.
+inline constexpr CampaignInfo kCampaigns[] = {
+    {"campaign1", "Indomitus", "I"},
+    {"campaign2", "Fall of Cadia", "FoC"},
+    {"campaign3", "Octarius", "O"},
+    {"campaign4", "Saim-Hann", "SH"},
+    {"elite1", "Indomitus Elite", "IE"},
+    {"elite2", "Fall of Cadia Elite", "FoCE"},
+    {"elite3", "Octarius Elite", "OE"},
+    {"elite4", "Saim-Hann Elite", "SHE"},
+    {"eliteMirror1", "Indomitus Mirror Elite", "IME"},
+    {"eliteMirror2", "Fall of Cadia Mirror Elite", "FoCME"},
+    {"eliteMirror3", "Octarius Mirror Elite", "OME"},
+    {"eliteMirror4", "Saim-Hann Mirror Elite", "SHME"},
+    {"eventExtremis1", "Adeptus Mechanicus Extremis", "AME"},
+    {"eventExtremis2", "Tyranids Extremis", "TE"},
+    {"eventExtremis3", "T'au Empire Extremis", "TAE"},
+    {"eventStandard1", "Adeptus Mechanicus Standard", "AMS"},
+    {"eventStandard2", "Tyranids Standard", "TS"},
+    {"eventStandard3", "T'au Empire Standard", "TAS"},
+    {"mirror1", "Indomitus Mirror", "IM"},
+    {"mirror2", "Fall of Cadia Mirror", "FoCM"},
+    {"mirror3", "Octarius Mirror", "OM"},
+    {"mirror4", "Saim-Hann Mirror", "SHM"},
+};
+
+// Returns the campaign with ID `id`, or null if there isn't one.
+constexpr const CampaignInfo* FindCampaign(const absl::string_view id) {
+  size_t lo = 0;
+  size_t hi = std::size(kCampaigns);
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (kCampaigns[mid].id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == std::size(kCampaigns) || kCampaigns[lo].id != id) return nullptr;
+  return &kCampaigns[lo];
+}
+
+// Returns the planner's name for battle `battle_id` of the campaign, e.g.
+// "FoCE12", or "FoCEC12B" for a boss node.
+inline std::string GetPlannerBattleId(const CampaignInfo& campaign,
+                                      const absl::string_view battle_id) {
+  if (!battle_id.empty() && battle_id.back() == 'B') {
+    return absl::StrCat(campaign.battle_prefix, "C", battle_id);
+  }
+  return absl::StrCat(campaign.battle_prefix, battle_id);
+}
+
+// Like above, for the campaign with ID `campaign_id`. Battles of campaigns
+// that aren't in kCampaigns are named "<campaign ID><battle ID>".
+inline std::string GetPlannerBattleId(const absl::string_view campaign_id,
+                                      const absl::string_view battle_id) {
+  const CampaignInfo* info = FindCampaign(campaign_id);
+  if (info == nullptr) return absl::StrCat(campaign_id, battle_id);
+  return GetPlannerBattleId(*info, battle_id);
+}
+
+// The rank names the planner uses in campaign data, indexed by the rank as
+// Snowprint numbers it (0 is Stone 1).
+inline constexpr absl::string_view kRankNames[] = {
+    "Stone 1",      "Stone 2",      "Stone 3",       //
+    "Iron 1",       "Iron 2",       "Iron 3",        //
+    "Bronze 1",     "Bronze 2",     "Bronze 3",      //
+    "Silver 1",     "Silver 2",     "Silver 3",      //
+    "Gold 1",       "Gold 2",       "Gold 3",        //
+    "Diamond 1",    "Diamond 2",    "Diamond 3",     //
+    "Adamantine 1", "Adamantine 2", "Adamantine 3",  //
+};
+
+// The same ranks, spelled the way the planner's rank-up data spells them.
+inline constexpr absl::string_view kRomanRankNames[] = {
+    "Stone I",      "Stone II",      "Stone III",       //
+    "Iron I",       "Iron II",       "Iron III",        //
+    "Bronze I",     "Bronze II",     "Bronze III",      //
+    "Silver I",     "Silver II",     "Silver III",      //
+    "Gold I",       "Gold II",       "Gold III",        //
+    "Diamond I",    "Diamond II",    "Diamond III",     //
+    "Adamantine I", "Adamantine II", "Adamantine III",  //
+};
+
+namespace campaign_tables_internal {
+
+constexpr bool CampaignsAreSorted() {
+  for (size_t i = 1; i < std::size(kCampaigns); ++i) {
+    if (!(kCampaigns[i - 1].id < kCampaigns[i].id)) return false;
+  }
+  return true;
+}
+
+constexpr bool HasSuffix(const absl::string_view s,
+                        const absl::string_view suffix) {
+  return s.size() >= suffix.size() &&
+         s.substr(s.size() - suffix.size()) == suffix;
+}
+
+constexpr bool HasPrefix(const absl::string_view s,
+                          const absl::string_view prefix) {
+  return s.substr(0, prefix.size()) == prefix;
+}
+
+// Returns true if `derived` is `base` followed by `suffix`.
+constexpr bool IsExtension(const absl::string_view derived,
+                           const absl::string_view base,
+                           const absl::string_view suffix) {
+  return derived.size() == base.size() + suffix.size() &&
+         HasPrefix(derived, base) && HasSuffix(derived, suffix);
+}
+
+// Each mirror and elite campaign is named and prefixed after the standard
+// campaign with the same number, e.g. "elite2" is "Fall of Cadia" + " Elite"
+// and "FoC" + "E". Each event's standard and extremis campaigns share a name
+// and a prefix up to the last word and letter.
+constexpr bool CampaignsAreConsistent() {
+  struct Variant {
+    absl::string_view id_prefix;
+    absl::string_view name_suffix;
+    absl::string_view battle_prefix_suffix;
+  };
+  constexpr Variant kVariants[] = {
+      {"mirror", " Mirror", "M"},
+      {"elite", " Elite", "E"},
+      {"eliteMirror", " Mirror Elite", "ME"},
+  };
+  for (const CampaignInfo& campaign : kCampaigns) {
+    const absl::string_view number =
+        campaign.id.substr(campaign.id.size() - 1);
+    for (const Variant& variant : kVariants) {
+      if (campaign.id.size() != variant.id_prefix.size() + 1 ||
+          !HasPrefix(campaign.id, variant.id_prefix)) {
+        continue;
+      }
+      // Numbers are single digits, so the ID is exactly prefix + digit.
+      const CampaignInfo* base = nullptr;
+      for (const CampaignInfo& candidate : kCampaigns) {
+        if (IsExtension(candidate.id, "campaign", number)) base = &candidate;
+      }
+      if (base == nullptr ||
+          !IsExtension(campaign.name, base->name, variant.name_suffix) ||
+          !IsExtension(campaign.battle_prefix, base->battle_prefix,
+                       variant.battle_prefix_suffix)) {
+        return false;
+      }
+    }
+    if (IsExtension(campaign.id, "eventStandard", number)) {
+      const CampaignInfo* extremis = nullptr;
+      for (const CampaignInfo& candidate : kCampaigns) {
+        if (IsExtension(candidate.id, "eventExtremis", number)) {
+          extremis = &candidate;
+        }
+      }
+      if (extremis == nullptr) return false;
+      const absl::string_view standard_prefix = campaign.battle_prefix;
+      const absl::string_view extremis_prefix = extremis->battle_prefix;
+      const absl::string_view event = campaign.name.substr(
+          0, campaign.name.size() - absl::string_view(" Standard").size());
+      const absl::string_view event_prefix =
+          standard_prefix.substr(0, standard_prefix.size() - 1);
+      if (!IsExtension(campaign.name, event, " Standard") ||
+          !IsExtension(extremis->name, event, " Extremis") ||
+          !IsExtension(standard_prefix, event_prefix, "S") ||
+          !IsExtension(extremis_prefix, event_prefix, "E")) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Both spellings name the same tier, differing only in the numeral.
+constexpr bool RankNamesAreConsistent() {
+  constexpr absl::string_view kNumerals[] = {"I", "II", "III"};
+  for (size_t i = 0; i < std::size(kRankNames); ++i) {
+    const absl::string_view arabic = kRankNames[i];
+    const absl::string_view roman = kRomanRankNames[i];
+    const char digit = static_cast<char>('1' + i % 3);
+    if (arabic.back() != digit) return false;
+    const absl::string_view tier = arabic.substr(0, arabic.size() - 1);
+    if (!IsExtension(roman, tier, kNumerals[i % 3])) return false;
+  }
+  return true;
+}
+
+}  // namespace campaign_tables_internal
+
+static_assert(campaign_tables_internal::CampaignsAreSorted(),
+              "kCampaigns must be sorted by ID.");
+static_assert(campaign_tables_internal::CampaignsAreConsistent(),
+              "A campaign's name or battle prefix doesn't match its family.");
+static_assert(std::size(kRankNames) == std::size(kRomanRankNames));
+static_assert(campaign_tables_internal::RankNamesAreConsistent(),
+              "kRankNames and kRomanRankNames disagree.");
+static_assert(FindCampaign("elite2")->battle_prefix == "FoCE");
+static_assert(FindCampaign("campaign5") == nullptr);
+
+}  // namespace dataminer
+
+#endif  // __CAMPAIGN_TABLES_H__
@@ -0,0 +1,31 @@
+#ifndef __CONTENT_HASH_H__
+#define __CONTENT_HASH_H__
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+
+namespace dataminer {
+
+// A 64-bit FNV-1a hash of `data`. Unlike absl::Hash, the value is stable
+// across processes and builds, so it's safe to persist and compare between
+// runs of the miner.
+inline uint64_t ContentHash(const absl::string_view data) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// The hash formatted as 16 lowercase hex digits.
+inline std::string ContentHashString(const absl::string_view data) {
+  return absl::StrFormat("%016x", ContentHash(data));
+}
+
+}  // namespace dataminer
+
+#endif  // __CONTENT_HASH_H__
@@ -0,0 +1,158 @@
+#include "cost_rollup.h"
+
+#include <algorithm>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
+namespace dataminer {
+
+namespace {
+
+void AddScaled(std::vector<int64_t>& lhs, const std::vector<int64_t>& rhs,
+               const int64_t scale) {
+  if (lhs.size() < rhs.size()) lhs.resize(rhs.size());
+  for (size_t i = 0; i < rhs.size(); ++i) lhs[i] += scale * rhs[i];
+}
+
+// Returns the position of `rarity` in `rarities`, adding it if it's new.
+int RarityIndex(std::vector<std::string>& rarities,
+                const absl::string_view rarity) {
+  const auto it = std::find(rarities.begin(), rarities.end(), rarity);
+  if (it != rarities.end()) return it - rarities.begin();
+  rarities.emplace_back(rarity);
+  return rarities.size() - 1;
+}
+
+}  // namespace
+
+Cost& Cost::operator+=(const Cost& other) {
+  gold += other.gold;
+  salvage += other.salvage;
+  mythic_salvage += other.mythic_salvage;
+  components += other.components;
+  AddScaled(badges, other.badges, 1);
+  AddScaled(forge_badges, other.forge_badges, 1);
+  return *this;
+}
+
+Cost& Cost::operator-=(const Cost& other) {
+  gold -= other.gold;
+  salvage -= other.salvage;
+  mythic_salvage -= other.mythic_salvage;
+  components -= other.components;
+  AddScaled(badges, other.badges, -1);
+  AddScaled(forge_badges, other.forge_badges, -1);
+  return *this;
+}
+
+CostRollup CostRollup::Build(const ClientGameConfig& config,
+                             const RecipeGraph& graph) {
+  CostRollup rollup;
+  rollup.graph_ = &graph;
+
+  // Ingredients come before the recipes that use them, so their totals are
+  // always ready.
+  rollup.craft_gold_.resize(graph.size());
+  for (const int material : graph.TopologicalOrder()) {
+    const Upgrades::Upgrade& upgrade = graph.upgrade(material);
+    if (!upgrade.has_recipe()) continue;
+    int64_t gold = upgrade.gold();
+    for (const RecipeGraph::MaterialCount& ingredient :
+         graph.Ingredients(material)) {
+      gold += ingredient.count * rollup.craft_gold_[ingredient.material];
+    }
+    rollup.craft_gold_[material] = gold;
+  }
+
+  // levels(L - 1) is what it costs to reach level L, so an item's level 1 is
+  // free and the running total starts at level 2.
+  rollup.item_offsets_.push_back(0);
+  for (const Item& item : config.items().items()) {
+    if (!rollup.items_.try_emplace(item.id(), rollup.items_.size()).second) {
+      continue;
+    }
+    Cost total;
+    rollup.item_levels_.push_back(total);
+    for (int i = 1; i < item.levels_size(); ++i) {
+      const Item::Level& level = item.levels(i);
+      total.gold += level.gold_cost();
+      total.salvage += level.salvage_cost();
+      total.mythic_salvage += level.mythic_salvage_cost();
+      rollup.item_levels_.push_back(total);
+    }
+    rollup.item_offsets_.push_back(rollup.item_levels_.size());
+  }
+
+  // mow_upgrade_costs(i) is what it costs to go from level i + 1 to i + 2.
+  Cost total;
+  rollup.mow_levels_.push_back(total);
+  for (const MachineOfWarUpgradeCosts& cost :
+       config.units().mow_upgrade_costs()) {
+    total.gold += cost.gold();
+    total.salvage += cost.salvage();
+    total.components += cost.components();
+    if (cost.has_badges()) {
+      const int rarity =
+          RarityIndex(rollup.badge_rarities_, cost.badges().rarity());
+      if (total.badges.size() <= static_cast<size_t>(rarity)) {
+        total.badges.resize(rarity + 1);
+      }
+      total.badges[rarity] += cost.badges().amount();
+    }
+    if (cost.has_forge_badges()) {
+      const int rarity = RarityIndex(rollup.forge_badge_rarities_,
+                                     cost.forge_badges().rarity());
+      if (total.forge_badges.size() <= static_cast<size_t>(rarity)) {
+        total.forge_badges.resize(rarity + 1);
+      }
+      total.forge_badges[rarity] += cost.forge_badges().amount();
+    }
+    rollup.mow_levels_.push_back(total);
+  }
+  // Pad every total to the final number of rarities, so that callers can
+  // index them without checking.
+  for (Cost& level : rollup.mow_levels_) {
+    level.badges.resize(rollup.badge_rarities_.size());
+    level.forge_badges.resize(rollup.forge_badge_rarities_.size());
+  }
+  return rollup;
+}
+
+absl::Span<const Cost> CostRollup::ItemLevels(
+    const absl::string_view item_id) const {
+  const auto it = items_.find(item_id);
+  if (it == items_.end()) return {};
+  const int item = it->second;
+  return absl::MakeConstSpan(
+      item_levels_.data() + item_offsets_[item],
+      item_offsets_[item + 1] - item_offsets_[item]);
+}
+
+absl::StatusOr<Cost> CostRollup::Range(const absl::string_view what,
+                                       const absl::Span<const Cost> totals,
+                                       const int from, const int to) {
+  if (from < 1 || to < from || to > static_cast<int>(totals.size())) {
+    return absl::OutOfRangeError(
+        absl::StrCat("Can't take ", what, " from level ", from, " to level ",
+                     to, "; it has ", totals.size(), " level(s)."));
+  }
+  Cost cost = totals[to - 1];
+  cost -= totals[from - 1];
+  return cost;
+}
+
+absl::StatusOr<Cost> CostRollup::ItemCost(const absl::string_view item_id,
+                                          const int from, const int to) const {
+  if (!items_.contains(item_id)) {
+    return absl::NotFoundError(absl::StrCat("Unknown item '", item_id, "'."));
+  }
+  return Range(item_id, ItemLevels(item_id), from, to);
+}
+
+absl::StatusOr<Cost> CostRollup::MowAbilityCost(const int from,
+                                                const int to) const {
+  return Range("a MoW ability", mow_levels_, from, to);
+}
+
+}  // namespace dataminer
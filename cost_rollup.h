@@ -0,0 +1,106 @@
+#ifndef __COST_ROLLUP_H__
+#define __COST_ROLLUP_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "miner.pb.h"
+#include "recipe_graph.h"
+
+namespace dataminer {
+
+// What something costs in every currency the config prices things in. Each
+// kind of cost only fills in the fields that apply to it.
+struct Cost {
+  int64_t gold = 0;
+  int64_t salvage = 0;
+  int64_t mythic_salvage = 0;
+  int64_t components = 0;
+  // Indexed like CostRollup::badge_rarities().
+  std::vector<int64_t> badges;
+  std::vector<int64_t> forge_badges;
+
+  Cost& operator+=(const Cost& other);
+  Cost& operator-=(const Cost& other);
+};
+
+// Precomputed cumulative costs, so the planner doesn't have to add up raw
+// per-level costs on every request:
+//
+//  - the gold to craft each upgrade, counting every recipe below it;
+//  - the cost of taking each item between any two levels;
+//  - the cost of taking a MoW ability between any two levels.
+//
+// Levels are stored as running totals, so every range query is one
+// subtraction.
+//
+// Points into the config and RecipeGraph it was built from, which must
+// outlive it. It's immutable once built, so it can be shared between threads.
+class CostRollup {
+ public:
+  static CostRollup Build(const ClientGameConfig& config,
+                          const RecipeGraph& graph);
+
+  CostRollup(CostRollup&&) = default;
+  CostRollup& operator=(CostRollup&&) = default;
+
+  const RecipeGraph& graph() const { return *graph_; }
+
+  // The badge rarities that appear in MoW upgrade costs, in the order they
+  // first appear.
+  absl::Span<const std::string> badge_rarities() const {
+    return badge_rarities_;
+  }
+  absl::Span<const std::string> forge_badge_rarities() const {
+    return forge_badge_rarities_;
+  }
+
+  // The gold it takes to craft one of `material` from base materials: its
+  // own recipe's gold plus that of every craft below it. Zero for base
+  // materials.
+  int64_t CraftGold(int material) const { return craft_gold_[material]; }
+
+  // The cost of taking item `item_id` from level `from` to level `to`, where
+  // levels start at 1. Fails if there's no such item or the levels are out
+  // of range.
+  absl::StatusOr<Cost> ItemCost(absl::string_view item_id, int from,
+                                int to) const;
+
+  // The cost of taking a MoW ability from level `from` to level `to`, where
+  // levels start at 1. All MoWs share the same costs.
+  absl::StatusOr<Cost> MowAbilityCost(int from, int to) const;
+
+  // The running totals behind the queries above. The entry for level L is
+  // the cost of going from level 1 to level L, so index 0 is always zero.
+  absl::Span<const Cost> ItemLevels(absl::string_view item_id) const;
+  absl::Span<const Cost> MowAbilityLevels() const { return mow_levels_; }
+
+ private:
+  CostRollup() = default;
+
+  // Returns totals[to - 1] - totals[from - 1], or an error if either level
+  // is out of range.
+  static absl::StatusOr<Cost> Range(absl::string_view what,
+                                    absl::Span<const Cost> totals, int from,
+                                    int to);
+
+  const RecipeGraph* graph_ = nullptr;
+  std::vector<std::string> badge_rarities_;
+  std::vector<std::string> forge_badge_rarities_;
+  std::vector<int64_t> craft_gold_;
+  absl::flat_hash_map<absl::string_view, int> items_;
+  // Item i's running totals are item_levels_[item_offsets_[i],
+  // item_offsets_[i + 1]).
+  std::vector<int> item_offsets_;
+  std::vector<Cost> item_levels_;
+  std::vector<Cost> mow_levels_;
+};
+
+}  // namespace dataminer
+
+#endif  // __COST_ROLLUP_H__
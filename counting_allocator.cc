@@ -0,0 +1,45 @@
+// Replaces the global operator new and delete with ones that count each
+// thread's allocations into metrics_internal::allocation_counts, for
+// AllocationScope. Link this into a binary to turn allocation metrics on.
+//
+// The counts are plain thread-locals, so the hook costs two adds per
+// allocation and takes no locks.
+
+#include <cstdlib>
+#include <new>
+
+#include "metrics.h"
+
+namespace {
+
+void* CountedAllocate(const std::size_t size) {
+  dataminer::AllocationCounts& counts =
+      dataminer::metrics_internal::allocation_counts;
+  ++counts.allocations;
+  counts.bytes += static_cast<int64_t>(size);
+  // malloc(0) may return null, which operator new mustn't.
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+}  // namespace
+
+void* operator new(const std::size_t size) {
+  void* const p = CountedAllocate(size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](const std::size_t size) { return operator new(size); }
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+
+void operator delete(void* const p) noexcept { std::free(p); }
+void operator delete[](void* const p) noexcept { std::free(p); }
+void operator delete(void* const p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* const p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,145 @@
+#include "covering_lp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "absl/status/status.h"
+
+namespace dataminer {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+constexpr double kEpsilon = 1e-9;
+
+}  // namespace
+
+CoveringLp::CoveringLp(const std::vector<double>& costs,
+                       const std::vector<double>& upper,
+                       const std::vector<std::vector<double>>& rows,
+                       const std::vector<double>& rhs)
+    : rows_(rhs.size()),
+      columns_(costs.size() + rows_),
+      tableau_(rows_ * columns_),
+      rhs_(rhs.size()),
+      reduced_costs_(columns_),
+      upper_(columns_, kInfinity),
+      state_(columns_, State::kAtLower),
+      basis_(rows_) {
+  const int variables = costs.size();
+  std::copy(costs.begin(), costs.end(), reduced_costs_.begin());
+  std::copy(upper.begin(), upper.end(), upper_.begin());
+  // Row i reads s_i - A_i x = -b_i.
+  for (int i = 0; i < rows_; ++i) {
+    for (int j = 0; j < variables; ++j) at(i, j) = -rows[i][j];
+    at(i, variables + i) = 1;
+    rhs_[i] = -rhs[i];
+    basis_[i] = variables + i;
+    state_[variables + i] = State::kBasic;
+  }
+}
+
+absl::StatusOr<std::vector<double>> CoveringLp::Solve() {
+  const int variables = columns_ - rows_;
+  const int max_pivots = 50 * columns_;
+  for (int pivot = 0; pivot < max_pivots; ++pivot) {
+    const std::vector<double> values = BasicValues();
+    // The most infeasible basic variable leaves the basis.
+    int leaving = -1;
+    double worst = kEpsilon;
+    bool below = false;
+    for (int i = 0; i < rows_; ++i) {
+      const double shortfall = -values[i];
+      const double excess = values[i] - upper_[basis_[i]];
+      if (shortfall > worst) {
+        leaving = i;
+        worst = shortfall;
+        below = true;
+      } else if (excess > worst) {
+        leaving = i;
+        worst = excess;
+        below = false;
+      }
+    }
+    if (leaving < 0) {
+      std::vector<double> x(variables);
+      for (int j = 0; j < variables; ++j) {
+        if (state_[j] == State::kAtUpper) x[j] = upper_[j];
+      }
+      for (int i = 0; i < rows_; ++i) {
+        if (basis_[i] < variables) x[basis_[i]] = values[i];
+      }
+      return x;
+    }
+
+    // The entering variable is the one that moves the leaving variable
+    // towards its bound while keeping every reduced cost's sign.
+    int entering = -1;
+    double best_ratio = kInfinity;
+    double best_alpha = 0;
+    for (int j = 0; j < columns_; ++j) {
+      if (state_[j] == State::kBasic) continue;
+      const double alpha = at(leaving, j);
+      const bool increases = state_[j] == State::kAtLower;
+      // x_B = rhs - alpha x_j, so raising x_B takes a negative alpha on a
+      // variable that can go up, or a positive one on a variable that can
+      // go down.
+      const bool helps = below == increases ? alpha < -kEpsilon
+                                            : alpha > kEpsilon;
+      if (!helps) continue;
+      const double ratio = std::abs(reduced_costs_[j] / alpha);
+      if (ratio < best_ratio - kEpsilon ||
+          (ratio < best_ratio + kEpsilon &&
+           std::abs(alpha) > std::abs(best_alpha))) {
+        entering = j;
+        best_ratio = ratio;
+        best_alpha = alpha;
+      }
+    }
+    if (entering < 0) {
+      infeasible_ = true;
+      for (int i = 0; i < rows_; ++i) {
+        if (std::abs(at(leaving, variables + i)) > kEpsilon) {
+          short_constraints_.push_back(i);
+        }
+      }
+      return absl::FailedPreconditionError(
+          "The constraints can't be satisfied within the bounds.");
+    }
+    state_[basis_[leaving]] = below ? State::kAtLower : State::kAtUpper;
+    Pivot(leaving, entering);
+  }
+  return absl::InternalError("The farming LP didn't converge.");
+}
+
+std::vector<double> CoveringLp::BasicValues() {
+  std::vector<double> values = rhs_;
+  for (int j = 0; j < columns_; ++j) {
+    if (state_[j] != State::kAtUpper) continue;
+    for (int i = 0; i < rows_; ++i) values[i] -= at(i, j) * upper_[j];
+  }
+  return values;
+}
+
+void CoveringLp::Pivot(const int row, const int column) {
+  const double pivot = at(row, column);
+  for (int j = 0; j < columns_; ++j) at(row, j) /= pivot;
+  rhs_[row] /= pivot;
+  for (int i = 0; i < rows_; ++i) {
+    if (i == row) continue;
+    const double factor = at(i, column);
+    if (factor == 0) continue;
+    for (int j = 0; j < columns_; ++j) at(i, j) -= factor * at(row, j);
+    rhs_[i] -= factor * rhs_[row];
+  }
+  const double factor = reduced_costs_[column];
+  for (int j = 0; j < columns_; ++j) {
+    reduced_costs_[j] -= factor * at(row, j);
+  }
+  basis_[row] = column;
+  state_[column] = State::kBasic;
+}
+
+}  // namespace dataminer
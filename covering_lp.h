@@ -0,0 +1,68 @@
+#ifndef __COVERING_LP_H__
+#define __COVERING_LP_H__
+
+#include <vector>
+
+#include "absl/status/statusor.h"
+
+namespace dataminer {
+
+// Solves
+//
+//   minimize    c.x
+//   subject to  A x >= b
+//               0 <= x <= upper
+//
+// for c >= 0 and b > 0 with a dense, bounded-variable dual simplex. An upper
+// bound may be infinity. Each row gets a surplus variable s = A x - b >= 0,
+// and the surpluses make up the first basis. With every x at zero the reduced
+// costs are just c, so that basis is dual feasible from the start, and each
+// pivot fixes the row that's furthest short of its b.
+//
+// This is FarmingPlanner's solver. miner_benchmark checks it against brute
+// force on small random LPs.
+class CoveringLp {
+ public:
+  CoveringLp(const std::vector<double>& costs,
+             const std::vector<double>& upper,
+             const std::vector<std::vector<double>>& rows,
+             const std::vector<double>& rhs);
+
+  // Returns the optimal x, or an error if A x >= b can't be met, in which case
+  // short_constraints() are the constraints that can't all be met. Pivoting
+  // mixes the rows, so the tableau row that shows it is a combination of
+  // constraints, which are the ones whose slacks it uses.
+  absl::StatusOr<std::vector<double>> Solve();
+
+  bool infeasible() const { return infeasible_; }
+  const std::vector<int>& short_constraints() const {
+    return short_constraints_;
+  }
+
+ private:
+  enum class State { kBasic, kAtLower, kAtUpper };
+
+  double& at(const int row, const int column) {
+    return tableau_[row * columns_ + column];
+  }
+
+  // The basic variables' values, with every nonbasic variable at its bound.
+  std::vector<double> BasicValues();
+
+  void Pivot(int row, int column);
+
+  const int rows_;
+  const int columns_;
+  std::vector<double> tableau_;
+  std::vector<double> rhs_;
+  std::vector<double> reduced_costs_;
+  std::vector<double> upper_;
+  std::vector<State> state_;
+  std::vector<int> basis_;
+  bool infeasible_ = false;
+  std::vector<int> short_constraints_;
+};
+
+}  // namespace dataminer
+
+#endif  // __COVERING_LP_H__
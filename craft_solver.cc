@@ -0,0 +1,151 @@
+#include "craft_solver.h"
+
+#include <algorithm>
+
+namespace dataminer {
+
+namespace {
+
+std::vector<int64_t> Densify(const RecipeGraph::Materials& materials,
+                             const int size) {
+  std::vector<int64_t> dense(size);
+  for (const RecipeGraph::MaterialCount& material : materials) {
+    dense[material.material] = material.count;
+  }
+  return dense;
+}
+
+}  // namespace
+
+CraftSolver::CraftSolver(const RecipeGraph& graph) : graph_(graph) {
+  std::vector<int> position(graph.size());
+  const absl::Span<const int> order = graph.TopologicalOrder();
+  for (size_t i = 0; i < order.size(); ++i) position[order[i]] = i;
+
+  std::vector<bool> seen(graph.size());
+  std::vector<int> subgraph;
+  std::vector<int> stack;
+  offsets_.reserve(graph.size() + 1);
+  offsets_.push_back(0);
+  for (int material = 0; material < graph.size(); ++material) {
+    subgraph.clear();
+    stack.assign(1, material);
+    seen[material] = true;
+    while (!stack.empty()) {
+      const int next = stack.back();
+      stack.pop_back();
+      subgraph.push_back(next);
+      for (const RecipeGraph::MaterialCount& ingredient :
+           graph.Ingredients(next)) {
+        if (seen[ingredient.material]) continue;
+        seen[ingredient.material] = true;
+        stack.push_back(ingredient.material);
+      }
+    }
+    for (const int m : subgraph) seen[m] = false;
+    // Later in the topological order means further from the base
+    // materials, so sorting by descending position puts products first.
+    std::sort(subgraph.begin(), subgraph.end(),
+              [&position](const int lhs, const int rhs) {
+                return position[lhs] > position[rhs];
+              });
+    subgraphs_.insert(subgraphs_.end(), subgraph.begin(), subgraph.end());
+    offsets_.push_back(subgraphs_.size());
+  }
+}
+
+bool CraftSolver::Propagate(const std::vector<int64_t>& stock,
+                            const int material, const int64_t count,
+                            std::vector<int64_t>& demand,
+                            Result* result) const {
+  const absl::Span<const int> subgraph = Subgraph(material);
+  for (const int m : subgraph) demand[m] = 0;
+  demand[material] = count;
+  bool feasible = true;
+  for (const int m : subgraph) {
+    int64_t needed = demand[m];
+    if (needed == 0) continue;
+    if (m != material) {
+      const int64_t used = std::min(needed, stock[m]);
+      needed -= used;
+      if (result != nullptr && used > 0) result->used.push_back({m, used});
+    }
+    if (needed == 0) continue;
+    const absl::Span<const RecipeGraph::MaterialCount> ingredients =
+        graph_.Ingredients(m);
+    if (ingredients.empty()) {
+      feasible = false;
+      if (result == nullptr) return false;
+      result->shortfall.push_back({m, needed});
+      continue;
+    }
+    if (result != nullptr) result->crafted.push_back({m, needed});
+    for (const RecipeGraph::MaterialCount& ingredient : ingredients) {
+      demand[ingredient.material] += ingredient.count * needed;
+    }
+  }
+  return feasible;
+}
+
+CraftSolver::Result CraftSolver::Craft(const RecipeGraph::Materials& inventory,
+                                       const int material,
+                                       const int64_t count) const {
+  const std::vector<int64_t> stock = Densify(inventory, graph_.size());
+  std::vector<int64_t> demand(graph_.size());
+  Result result;
+  result.feasible = Propagate(stock, material, count, demand, &result);
+  for (RecipeGraph::Materials* materials :
+       {&result.used, &result.crafted, &result.shortfall}) {
+    std::sort(materials->begin(), materials->end(),
+              [](const RecipeGraph::MaterialCount& lhs,
+                 const RecipeGraph::MaterialCount& rhs) {
+                return lhs.material < rhs.material;
+              });
+  }
+  return result;
+}
+
+int64_t CraftSolver::MaxCraftable(const std::vector<int64_t>& stock,
+                                  const int material,
+                                  std::vector<int64_t>& demand) const {
+  if (graph_.Ingredients(material).empty()) return 0;
+  // Being able to craft N means being able to craft fewer, so double until
+  // a count fails, then binary search below it.
+  int64_t low = 0;
+  int64_t high = 1;
+  while (high <= kMaxCount &&
+         Propagate(stock, material, high, demand, nullptr)) {
+    low = high;
+    high *= 2;
+  }
+  if (high > kMaxCount) return low;
+  while (high - low > 1) {
+    const int64_t mid = low + (high - low) / 2;
+    if (Propagate(stock, material, mid, demand, nullptr)) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int64_t CraftSolver::MaxCraftable(const RecipeGraph::Materials& inventory,
+                                  const int material) const {
+  std::vector<int64_t> demand(graph_.size());
+  return MaxCraftable(Densify(inventory, graph_.size()), material, demand);
+}
+
+RecipeGraph::Materials CraftSolver::Craftable(
+    const RecipeGraph::Materials& inventory) const {
+  const std::vector<int64_t> stock = Densify(inventory, graph_.size());
+  std::vector<int64_t> demand(graph_.size());
+  RecipeGraph::Materials craftable;
+  for (int material = 0; material < graph_.size(); ++material) {
+    const int64_t count = MaxCraftable(stock, material, demand);
+    if (count > 0) craftable.push_back({material, count});
+  }
+  return craftable;
+}
+
+}  // namespace dataminer
@@ -0,0 +1,95 @@
+#ifndef __CRAFT_SOLVER_H__
+#define __CRAFT_SOLVER_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "recipe_graph.h"
+
+namespace dataminer {
+
+// Answers what a player can craft from their inventory: whether they can
+// craft N of a material, what they'd be short of if not, and the most of a
+// material they can craft.
+//
+// Crafting works top down. The demand for the material is pushed through
+// its recipe, one material at a time, with every product before its
+// ingredients. By the time a material is reached, every recipe that uses it
+// has added its demand, so ingredients shared between recipes are counted
+// once against the inventory. Each material's demand is met from stock first,
+// and only the rest is crafted or, for base materials, reported as a
+// shortfall. Using stock is never worse than crafting, so this is exact.
+//
+// The order each material's subgraph is walked in is computed once, up front,
+// so a query only touches the materials under its target.
+//
+// Points into the RecipeGraph it was built from, which must outlive it. It's
+// immutable once built, so it can be shared between threads.
+class CraftSolver {
+ public:
+  struct Result {
+    // Whether the inventory covers the whole craft.
+    bool feasible = false;
+    // How much of each material comes out of the inventory.
+    RecipeGraph::Materials used;
+    // How many of each material gets crafted, including the target.
+    RecipeGraph::Materials crafted;
+    // The base materials the inventory is short of.
+    RecipeGraph::Materials shortfall;
+  };
+
+  // The largest count Craft() takes and MaxCraftable() tries, which keeps
+  // the demand for every base material well inside an int64_t.
+  static constexpr int64_t kMaxCount = int64_t{1} << 30;
+
+  explicit CraftSolver(const RecipeGraph& graph);
+
+  CraftSolver(const CraftSolver&) = delete;
+  CraftSolver& operator=(const CraftSolver&) = delete;
+
+  const RecipeGraph& graph() const { return graph_; }
+
+  // Works out how to craft `count` new `material`s from `inventory`, which is
+  // sorted by material. Stock of `material` itself isn't used. `count` must
+  // be at most kMaxCount.
+  Result Craft(const RecipeGraph::Materials& inventory, int material,
+               int64_t count) const;
+
+  // The most of `material` that `inventory` can craft. Zero for base
+  // materials.
+  int64_t MaxCraftable(const RecipeGraph::Materials& inventory,
+                       int material) const;
+
+  // Every craftable material that `inventory` can craft at least one of,
+  // with the most it can craft.
+  RecipeGraph::Materials Craftable(
+      const RecipeGraph::Materials& inventory) const;
+
+ private:
+  // `material` and everything its recipe uses, directly or not, with every
+  // product before its ingredients.
+  absl::Span<const int> Subgraph(int material) const {
+    return absl::MakeConstSpan(subgraphs_.data() + offsets_[material],
+                               offsets_[material + 1] - offsets_[material]);
+  }
+
+  // Pushes the demand for `count` of `material` down its subgraph, against
+  // the dense `stock`. Returns true if nothing's short. Fills `result` if
+  // it isn't null.
+  bool Propagate(const std::vector<int64_t>& stock, int material,
+                 int64_t count, std::vector<int64_t>& demand,
+                 Result* result) const;
+
+  int64_t MaxCraftable(const std::vector<int64_t>& stock, int material,
+                       std::vector<int64_t>& demand) const;
+
+  const RecipeGraph& graph_;
+  // Subgraph(m) is subgraphs_[offsets_[m], offsets_[m + 1]).
+  std::vector<int> offsets_;
+  std::vector<int> subgraphs_;
+};
+
+}  // namespace dataminer
+
+#endif  // __CRAFT_SOLVER_H__
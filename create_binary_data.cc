@@ -0,0 +1,432 @@
+#include "create_binary_data.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "asset_manifest.h"
+#include "binary_data_format.h"
+#include "game_config_index.h"
+#include "icon_paths.h"
+#include "miner.pb.h"
+#include "output_writer.h"
+#include "trace.h"
+
+namespace dataminer {
+
+namespace {
+
+using binary_data::BattleRecord;
+using binary_data::CampaignRecord;
+using binary_data::CharacterRecord;
+using binary_data::EnemyRecord;
+using binary_data::FileHeader;
+using binary_data::GuaranteedRewardRecord;
+using binary_data::IngredientRecord;
+using binary_data::ItemLevelRecord;
+using binary_data::ItemRecord;
+using binary_data::ListRef;
+using binary_data::MowRecipeRecord;
+using binary_data::MowRecord;
+using binary_data::MowUpgradeCostRecord;
+using binary_data::NpcRecord;
+using binary_data::NpcStatsRecord;
+using binary_data::RankUpRecord;
+using binary_data::SectionEntry;
+using binary_data::SectionKind;
+using binary_data::StringRef;
+using binary_data::UpgradeRecord;
+
+// Accumulates the records of every section, then lays them out in one buffer.
+class BinaryDataBuilder {
+ public:
+  StringRef AddString(const absl::string_view s) {
+    auto [it, inserted] = string_refs_.try_emplace(std::string(s));
+    if (inserted) {
+      it->second = {static_cast<uint32_t>(strings_.size()),
+                    static_cast<uint32_t>(s.size())};
+      strings_.append(s.data(), s.size());
+    }
+    return it->second;
+  }
+
+  template <typename Strings>
+  ListRef AddStringList(const Strings& strings) {
+    ListRef list = {static_cast<uint32_t>(string_lists_.size()), 0};
+    for (const absl::string_view s : strings) {
+      string_lists_.push_back(AddString(s));
+      ++list.count;
+    }
+    return list;
+  }
+
+  void AddCharacters(const GameConfigIndex& index,
+                     const AssetManifest& manifest);
+  void AddUpgrades(const GameConfigIndex& index);
+  void AddCampaigns(const GameConfig& config);
+  void AddItems(const GameConfig& config);
+  void AddMows(const GameConfig& config);
+  void AddNpcs(const GameConfig& config);
+
+  std::string Serialize() const;
+
+ private:
+  ListRef AddMowRecipes(const MachineOfWar::Ability& ability);
+
+  absl::flat_hash_map<std::string, StringRef> string_refs_;
+  std::string strings_;
+  std::vector<StringRef> string_lists_;
+  std::vector<CharacterRecord> characters_;
+  std::vector<RankUpRecord> rank_ups_;
+  std::vector<UpgradeRecord> upgrades_;
+  std::vector<IngredientRecord> ingredients_;
+  std::vector<CampaignRecord> campaigns_;
+  std::vector<BattleRecord> battles_;
+  std::vector<EnemyRecord> enemies_;
+  std::vector<GuaranteedRewardRecord> guaranteed_rewards_;
+  std::vector<ItemRecord> items_;
+  std::vector<ItemLevelRecord> item_levels_;
+  std::vector<MowRecord> mows_;
+  std::vector<MowRecipeRecord> mow_recipes_;
+  std::vector<MowUpgradeCostRecord> mow_upgrade_costs_;
+  std::vector<NpcRecord> npcs_;
+  std::vector<NpcStatsRecord> npc_stats_;
+};
+
+// The distinct damage types of `abilities`, sorted, as the character JSON
+// lists them.
+std::set<absl::string_view> AbilityDamageTypes(
+    const GameConfigIndex& index,
+    const google::protobuf::RepeatedPtrField<std::string>& abilities) {
+  std::set<absl::string_view> damage_types;
+  for (const absl::string_view name : abilities) {
+    const Units::Ability* ability = index.FindAbility(name);
+    if (ability == nullptr) continue;
+    for (const absl::string_view damage_type : ability->damage_types()) {
+      if (!damage_type.empty()) damage_types.insert(damage_type);
+    }
+  }
+  return damage_types;
+}
+
+void BinaryDataBuilder::AddCharacters(const GameConfigIndex& index,
+                                      const AssetManifest& manifest) {
+  for (const Unit& unit :
+       index.config().client_game_config().units().units()) {
+    CharacterRecord record{};
+    record.id = AddString(unit.id());
+    record.name = AddString(unit.name());
+    record.title = AddString(unit.title());
+    record.full_name = AddString(unit.full_name());
+    record.short_name = AddString(unit.short_name());
+    record.extra_short_name = AddString(unit.extra_short_name());
+    record.faction = AddString(unit.faction_id());
+    record.alliance = AddString(unit.alliance());
+    record.base_rarity = AddString(unit.base_rarity());
+    record.melee_damage_type = AddString(unit.melee_attack().damage_type());
+    record.ranged_damage_type = AddString(unit.ranged_attack().damage_type());
+    for (int i = 0; i < 3; ++i) {
+      record.equipment_slots[i] = AddString(
+          i < unit.equipment_slots_size() ? unit.equipment_slots(i) : "");
+    }
+    record.icon = AddString(GetIconPath(unit.id(), index, manifest));
+    record.round_icon = AddString(GetRoundIconPath(unit.id(), index, manifest));
+    record.health = unit.stats().health();
+    record.damage = unit.stats().damage();
+    record.armor = unit.stats().armor();
+    record.movement = unit.movement();
+    record.melee_hits = unit.melee_attack().hits();
+    record.ranged_hits = unit.ranged_attack().hits();
+    record.ranged_range = unit.ranged_attack().range();
+    record.avatar_index = index.AvatarIndex(unit.id());
+    record.traits = AddStringList(unit.traits());
+    record.active_ability_damage_types =
+        AddStringList(AbilityDamageTypes(index, unit.active_abilities()));
+    record.passive_ability_damage_types =
+        AddStringList(AbilityDamageTypes(index, unit.passive_abilities()));
+    record.rank_ups = {static_cast<uint32_t>(rank_ups_.size()),
+                       static_cast<uint32_t>(unit.rank_up_requirements_size())};
+    for (const Unit::RankUpRequirements& req : unit.rank_up_requirements()) {
+      rank_ups_.push_back({
+          .top_row_health = AddString(req.top_row_health()),
+          .bottom_row_health = AddString(req.bottom_row_health()),
+          .top_row_damage = AddString(req.top_row_damage()),
+          .bottom_row_damage = AddString(req.bottom_row_damage()),
+          .top_row_armor = AddString(req.top_row_armor()),
+          .bottom_row_armor = AddString(req.bottom_row_armor()),
+      });
+    }
+    characters_.push_back(record);
+  }
+}
+
+void BinaryDataBuilder::AddUpgrades(const GameConfigIndex& index) {
+  for (const Upgrades::Upgrade& upgrade :
+       index.config().client_game_config().upgrades().upgrades()) {
+    UpgradeRecord record{};
+    record.id = AddString(upgrade.id());
+    record.name = AddString(upgrade.name());
+    record.rarity = AddString(upgrade.rarity());
+    record.stat_type = AddString(upgrade.stat_type());
+    record.gold = upgrade.gold();
+    record.craftable = upgrade.has_recipe() ? 1 : 0;
+    record.ingredients = {static_cast<uint32_t>(ingredients_.size()), 0};
+    for (const auto& ingredient : upgrade.recipe().ingredients()) {
+      ingredients_.push_back({
+          .id = AddString(ingredient.id()),
+          .upgrade_index = index.UpgradeIndex(ingredient.id()),
+          .amount = ingredient.amount(),
+      });
+      ++record.ingredients.count;
+    }
+    upgrades_.push_back(record);
+  }
+}
+
+void BinaryDataBuilder::AddCampaigns(const GameConfig& config) {
+  const Battles& battles = config.client_game_config().battles();
+  for (const google::protobuf::RepeatedPtrField<Campaign>* list :
+       {&battles.standard_campaigns(), &battles.mirror_campaigns(),
+        &battles.elite_campaigns(), &battles.mirror_elite_campaigns(),
+        &battles.campaign_events()}) {
+    for (const Campaign& campaign : *list) {
+      const int campaign_index = campaigns_.size();
+      CampaignRecord campaign_record{};
+      campaign_record.id = AddString(campaign.id());
+      campaign_record.allowed_factions =
+          AddStringList(campaign.allowed_factions());
+      campaign_record.battles = {static_cast<uint32_t>(battles_.size()),
+                                 static_cast<uint32_t>(campaign.battles_size())};
+      for (const Campaign::Battle& battle : campaign.battles()) {
+        BattleRecord record{};
+        record.id = AddString(battle.id());
+        record.boss = AddString(battle.boss());
+        record.campaign_index = campaign_index;
+        record.energy_cost = battle.energy_cost();
+        record.max_attempts = battle.max_attempts();
+        record.spawn_points = battle.spawn_points();
+        record.lightning_victory = battle.lightning_victory();
+        const Campaign::Battle::PotentialRewardItem& chance_of =
+            battle.reward().chance_of();
+        record.chance_id = AddString(chance_of.id());
+        record.chance_numerator = chance_of.chance_numerator();
+        record.chance_denominator = chance_of.chance_denominator();
+        record.effective_rate = chance_of.effective_rate();
+        record.guaranteed = {static_cast<uint32_t>(guaranteed_rewards_.size()),
+                             static_cast<uint32_t>(battle.reward().base_size())};
+        for (const auto& reward : battle.reward().base()) {
+          guaranteed_rewards_.push_back({
+              .id = AddString(reward.id()),
+              .min = reward.min(),
+              .max = reward.max(),
+          });
+        }
+        record.required_units = AddStringList(battle.required_units());
+        record.enemies = {static_cast<uint32_t>(enemies_.size()),
+                          static_cast<uint32_t>(battle.enemy_refs_size())};
+        for (const Campaign::Battle::EnemyRef& ref : battle.enemy_refs()) {
+          enemies_.push_back({
+              .npc_index = ref.npc_index(),
+              .level = ref.level(),
+              .count = ref.count(),
+          });
+        }
+        battles_.push_back(record);
+      }
+      campaigns_.push_back(campaign_record);
+    }
+  }
+}
+
+void BinaryDataBuilder::AddItems(const GameConfig& config) {
+  for (const Item& item : config.client_game_config().items().items()) {
+    ItemRecord record{};
+    record.id = AddString(item.id());
+    record.name = AddString(item.name());
+    record.rarity = AddString(item.rarity());
+    record.type = AddString(item.equipment_type());
+    record.ability_id = AddString(item.ability_id());
+    record.is_relic = item.is_relic() ? 1 : 0;
+    record.is_unique_relic = item.is_unique_relic() ? 1 : 0;
+    record.allowed_units = AddStringList(item.allowed_units());
+    record.allowed_factions = AddStringList(item.allowed_factions());
+    record.levels = {static_cast<uint32_t>(item_levels_.size()),
+                     static_cast<uint32_t>(item.levels_size())};
+    for (const Item::Level& level : item.levels()) {
+      ItemLevelRecord level_record{};
+      level_record.gold_cost = level.gold_cost();
+      level_record.salvage_cost = level.salvage_cost();
+      level_record.mythic_salvage_cost = level.mythic_salvage_cost();
+      const Item::Stats& stats = level.stats();
+      const std::pair<bool, int> values[binary_data::kNumItemStats] = {
+          {stats.has_block_chance(), stats.block_chance()},
+          {stats.has_block_damage(), stats.block_damage()},
+          {stats.has_block_chance_bonus(), stats.block_chance_bonus()},
+          {stats.has_block_damage_bonus(), stats.block_damage_bonus()},
+          {stats.has_crit_chance(), stats.crit_chance()},
+          {stats.has_crit_damage(), stats.crit_damage()},
+          {stats.has_crit_chance_bonus(), stats.crit_chance_bonus()},
+          {stats.has_crit_damage_bonus(), stats.crit_damage_bonus()},
+          {stats.has_fixed_armor(), stats.fixed_armor()},
+          {stats.has_hp(), stats.hp()},
+      };
+      for (uint32_t i = 0; i < binary_data::kNumItemStats; ++i) {
+        if (!values[i].first) continue;
+        level_record.stats_present |= 1u << i;
+        level_record.stats[i] = values[i].second;
+      }
+      item_levels_.push_back(level_record);
+    }
+    items_.push_back(record);
+  }
+}
+
+ListRef BinaryDataBuilder::AddMowRecipes(const MachineOfWar::Ability& ability) {
+  ListRef list = {static_cast<uint32_t>(mow_recipes_.size()),
+                  static_cast<uint32_t>(ability.upgrade_recipes_size())};
+  for (const auto& recipe : ability.upgrade_recipes()) {
+    mow_recipes_.push_back({{AddString(recipe.mat1()), AddString(recipe.mat2()),
+                             AddString(recipe.mat3())}});
+  }
+  return list;
+}
+
+void BinaryDataBuilder::AddMows(const GameConfig& config) {
+  const Units& units = config.client_game_config().units();
+  for (const MachineOfWar& mow : units.mows()) {
+    MowRecord record{};
+    record.id = AddString(mow.id());
+    record.name = AddString(mow.name());
+    record.short_name = AddString(mow.short_name());
+    record.title = AddString(mow.title());
+    record.faction = AddString(mow.faction_id());
+    record.alliance = AddString(mow.alliance());
+    record.primary_ability = AddString(mow.active_ability().name());
+    record.secondary_ability = AddString(mow.passive_ability().name());
+    record.primary_recipes = AddMowRecipes(mow.active_ability());
+    record.secondary_recipes = AddMowRecipes(mow.passive_ability());
+    mows_.push_back(record);
+  }
+  for (const MachineOfWarUpgradeCosts& cost : units.mow_upgrade_costs()) {
+    MowUpgradeCostRecord record{};
+    record.gold = cost.gold();
+    record.salvage = cost.salvage();
+    record.components = cost.components();
+    record.badges_amount = cost.badges().amount();
+    record.badges_rarity = AddString(cost.badges().rarity());
+    record.forge_badges_amount = cost.forge_badges().amount();
+    record.forge_badges_rarity = AddString(cost.forge_badges().rarity());
+    mow_upgrade_costs_.push_back(record);
+  }
+}
+
+void BinaryDataBuilder::AddNpcs(const GameConfig& config) {
+  for (const Npc& npc : config.client_game_config().units().npcs()) {
+    npcs_.push_back({
+        .id = AddString(npc.id()),
+        .name = AddString(npc.name()),
+        .faction = AddString(npc.faction_id()),
+        .alliance = AddString(npc.alliance()),
+        .stats = {static_cast<uint32_t>(npc_stats_.size()),
+                  static_cast<uint32_t>(npc.stats_size())},
+    });
+    for (const Npc::Stats& stats : npc.stats()) {
+      npc_stats_.push_back({
+          .level = stats.level(),
+          .rank = stats.rank(),
+          .stars = stats.stars(),
+          .damage = stats.damage(),
+          .armor = stats.armor(),
+          .health = stats.health(),
+      });
+    }
+  }
+}
+
+struct SectionData {
+  SectionKind kind;
+  uint32_t record_size;
+  const char* data;
+  uint64_t count;
+};
+
+template <typename T>
+SectionData MakeSection(const SectionKind kind, const std::vector<T>& records) {
+  return {kind, sizeof(T), reinterpret_cast<const char*>(records.data()),
+          records.size()};
+}
+
+uint64_t AlignUp(const uint64_t offset) { return (offset + 7) & ~uint64_t{7}; }
+
+std::string BinaryDataBuilder::Serialize() const {
+  const SectionData sections[] = {
+      {binary_data::kStrings, 1, strings_.data(), strings_.size()},
+      MakeSection(binary_data::kStringLists, string_lists_),
+      MakeSection(binary_data::kCharacters, characters_),
+      MakeSection(binary_data::kRankUps, rank_ups_),
+      MakeSection(binary_data::kUpgrades, upgrades_),
+      MakeSection(binary_data::kIngredients, ingredients_),
+      MakeSection(binary_data::kCampaigns, campaigns_),
+      MakeSection(binary_data::kBattles, battles_),
+      MakeSection(binary_data::kGuaranteedRewards, guaranteed_rewards_),
+      MakeSection(binary_data::kItems, items_),
+      MakeSection(binary_data::kItemLevels, item_levels_),
+      MakeSection(binary_data::kMows, mows_),
+      MakeSection(binary_data::kMowRecipes, mow_recipes_),
+      MakeSection(binary_data::kMowUpgradeCosts, mow_upgrade_costs_),
+      MakeSection(binary_data::kNpcs, npcs_),
+      MakeSection(binary_data::kEnemies, enemies_),
+      MakeSection(binary_data::kNpcStats, npc_stats_),
+  };
+  constexpr size_t kNumSections = sizeof(sections) / sizeof(sections[0]);
+
+  std::vector<SectionEntry> entries;
+  uint64_t offset =
+      AlignUp(sizeof(FileHeader) + kNumSections * sizeof(SectionEntry));
+  for (const SectionData& section : sections) {
+    entries.push_back({section.kind, section.record_size, offset,
+                       section.count});
+    offset = AlignUp(offset + section.count * section.record_size);
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, binary_data::kMagic, sizeof(header.magic));
+  header.version = binary_data::kVersion;
+  header.section_count = kNumSections;
+  header.file_size = offset;
+
+  // Zero-filled, so the alignment padding between sections is deterministic.
+  std::string out(offset, '\0');
+  std::memcpy(out.data(), &header, sizeof(header));
+  std::memcpy(out.data() + sizeof(header), entries.data(),
+              entries.size() * sizeof(SectionEntry));
+  for (size_t i = 0; i < kNumSections; ++i) {
+    if (sections[i].count == 0) continue;
+    std::memcpy(out.data() + entries[i].offset, sections[i].data,
+                sections[i].count * sections[i].record_size);
+  }
+  return out;
+}
+
+}  // namespace
+
+absl::Status CreateBinaryData(const absl::string_view path,
+                              const GameConfigIndex& index,
+                              const AssetManifest& manifest) {
+  TRACE_SCOPE("CreateBinaryData");
+  const GameConfig& game_config = index.config();
+  BinaryDataBuilder builder;
+  builder.AddCharacters(index, manifest);
+  builder.AddUpgrades(index);
+  builder.AddCampaigns(game_config);
+  builder.AddItems(game_config);
+  builder.AddMows(game_config);
+  builder.AddNpcs(game_config);
+  return WriteOutput(path, builder.Serialize());
+}
+
+}  // namespace dataminer
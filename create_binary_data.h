@@ -0,0 +1,22 @@
+#ifndef __CREATE_BINARY_DATA_H__
+#define __CREATE_BINARY_DATA_H__
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "asset_manifest.h"
+#include "game_config_index.h"
+
+namespace dataminer {
+
+// Writes the characters, recipes, rank-ups, campaigns, equipment and MoW data
+// to `path` as a single memory-mappable file. See binary_data_format.h for the
+// layout and binary_data_reader.h for reading it back. The character icons
+// are referenced in `manifest`, as in CreateCharacterData.
+// Returns an error status if the creation fails.
+absl::Status CreateBinaryData(const absl::string_view path,
+                              const GameConfigIndex& index,
+                              const AssetManifest& manifest);
+
+}  // namespace dataminer
+
+#endif  // __CREATE_BINARY_DATA_H__
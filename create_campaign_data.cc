@@ -1,51 +1,36 @@
 #include "create_campaign_data.h"
 
+#include <algorithm>
 #include <cstdlib>
-#include <fstream>
+#include <iterator>
 #include <random>
+#include <sstream>
 #include <tuple>
+#include <vector>
 
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "campaign_tables.h"
+#include "material_drop_index.h"
 #include "miner.pb.h"
+#include "output_writer.h"
+#include "thread_pool.h"
+#include "trace.h"
 
 namespace dataminer {
 
 namespace {
 
-std::string GetCampaignName(const Campaign& campaign) {
-  const std::map<std::string, std::string> kCampaignNames = {
-      {"campaign1", "Indomitus"},
-      {"campaign2", "Fall of Cadia"},
-      {"campaign3", "Octarius"},
-      {"campaign4", "Saim-Hann"},
-      {"mirror1", "Indomitus Mirror"},
-      {"mirror2", "Fall of Cadia Mirror"},
-      {"mirror3", "Octarius Mirror"},
-      {"mirror4", "Saim-Hann Mirror"},
-      {"elite1", "Indomitus Elite"},
-      {"elite2", "Fall of Cadia Elite"},
-      {"elite3", "Octarius Elite"},
-      {"elite4", "Saim-Hann Elite"},
-      {"eliteMirror1", "Indomitus Mirror Elite"},
-      {"eliteMirror2", "Fall of Cadia Mirror Elite"},
-      {"eliteMirror3", "Octarius Mirror Elite"},
-      {"eliteMirror4", "Saim-Hann Mirror Elite"},
-      {"eventStandard1", "Adeptus Mechanicus Standard"},
-      {"eventStandard2", "Tyranids Standard"},
-      {"eventStandard3", "T'au Empire Standard"},
-      {"eventExtremis1", "Adeptus Mechanicus Extremis"},
-      {"eventExtremis2", "Tyranids Extremis"},
-      {"eventExtremis3", "T'au Empire Extremis"},
-  };
-  auto it = kCampaignNames.find(campaign.id());
-  if (it == kCampaignNames.end()) {
+absl::string_view GetCampaignName(const Campaign& campaign) {
+  const CampaignInfo* info = FindCampaign(campaign.id());
+  if (info == nullptr) {
     LOG(ERROR) << "Unknown campaign id: " << campaign.id();
     return "Unknown Campaign";
   }
-  return it->second;
+  return info->name;
 }
 
 std::string GetCampaignType(const Campaign& campaign,
@@ -74,23 +59,10 @@ std::string GetCampaignType(const Campaign& campaign,
 
 std::string GetBattleId(const Campaign& campaign,
                         const Campaign::Battle& battle) {
-  const std::map<std::string, std::string> kCampaignPrefixes = {
-      {"campaign1", "I"},        {"campaign2", "FoC"},
-      {"campaign3", "O"},        {"campaign4", "SH"},
-      {"mirror1", "IM"},         {"mirror2", "FoCM"},
-      {"mirror3", "OM"},         {"mirror4", "SHM"},
-      {"elite1", "IE"},          {"elite2", "FoCE"},
-      {"elite3", "OE"},          {"elite4", "SHE"},
-      {"eliteMirror1", "IME"},   {"eliteMirror2", "FoCME"},
-      {"eliteMirror3", "OME"},   {"eliteMirror4", "SHME"},
-      {"eventStandard1", "AMS"}, {"eventStandard2", "TS"},
-      {"eventStandard3", "TAS"}, {"eventExtremis1", "AME"},
-      {"eventExtremis2", "TE"},  {"eventExtremis3", "TAE"},
-  };
-  if (absl::EndsWith(battle.id(), "B")) {
-    return absl::StrCat(kCampaignPrefixes.at(campaign.id()), "C", battle.id());
+  if (FindCampaign(campaign.id()) == nullptr) {
+    LOG(ERROR) << "No battle prefix for campaign id: " << campaign.id();
   }
-  return absl::StrCat(kCampaignPrefixes.at(campaign.id()), battle.id());
+  return GetPlannerBattleId(campaign.id(), battle.id());
 }
 
 void EmitBattleRewards(std::ostream& out,
@@ -125,16 +97,6 @@ void EmitBattleRewards(std::ostream& out,
   out << "        },\n";
 }
 
-const std::map<std::string, const Npc*>& GetNpcMap(const GameConfig& config) {
-  static std::map<std::string, const Npc*> npc_map;
-  if (npc_map.empty()) {
-    for (const auto& npc : config.client_game_config().units().npcs()) {
-      npc_map[npc.id()] = &npc;
-    }
-  }
-  return npc_map;
-}
-
 struct EnemyDetails {
   std::string id;
   std::string name;
@@ -150,57 +112,24 @@ struct EnemyDetails {
   }
 };
 
-void CollectEnemyInfo(const std::map<std::string, int>& enemies,
-                      const GameConfig& config,
+void CollectEnemyInfo(const Campaign::Battle& battle,
+                      const GameConfigIndex& index,
                       std::set<std::string>& alliances,
                       std::set<std::string>& factions,
                       std::map<EnemyDetails, int>& enemy_details) {
-  const std::map<std::string, const Npc*>& npc_map = GetNpcMap(config);
-  for (const auto& [enemy, count] : enemies) {
-    const auto index = enemy.find(':');
-    if (enemy == "powupHealth") continue;
-    if (index == std::string::npos) {
-      LOG(ERROR) << "Invalid enemy format: " << enemy;
-      continue;
-    }
-    const std::string npc_id = enemy.substr(0, index);
-    int level;
-    if (!absl::SimpleAtoi(enemy.substr(index + 1), &level)) {
-      LOG(ERROR) << "Invalid level format for enemy: " << enemy;
-    }
-    if (auto it = enemy.find("Boss"); it != std::string::npos) {
-      // For whatever reason, SP made the boss indices 1-based, but the
-      // normal-NPC indices 0 based.
-      level -= 1;
-    }
-    if (npc_id == "necroNpc1TutWarriorFTUEtest") {
-      // Some random NPC goes out of bounds.
-      level -= 1;
-    }
-    auto it = npc_map.find(npc_id);
-    if (it == npc_map.end()) {
-      LOG(ERROR) << "Unknown NPC id: " << npc_id;
-      continue;
-    }
-    const Npc* npc = it->second;
-    if (level < 0 || level >= npc->stats_size()) {
-      if (level < 0) {
-        LOG(ERROR) << "NPC " << npc_id << " has negative level: " << level;
-        continue;
-      }
-      // The T'au bosses in the T'au Extremis challenge 25B go out of bounds.
-      if (level >= npc->stats_size()) level = npc->stats_size() - 1;
-    }
-    alliances.insert(npc->alliance());
-    factions.insert(npc->faction_id());
+  const Units& units = index.config().client_game_config().units();
+  for (const Campaign::Battle::EnemyRef& ref : battle.enemy_refs()) {
+    const Npc& npc = units.npcs(ref.npc_index());
+    alliances.insert(npc.alliance());
+    factions.insert(npc.faction_id());
     EnemyDetails details = {
-        .id = npc->id(),
-        .name = npc->name(),
-        .rank = npc->stats(level).rank(),
-        .stars = npc->stats(level).stars(),
+        .id = npc.id(),
+        .name = npc.name(),
+        .rank = npc.stats(ref.level()).rank(),
+        .stars = npc.stats(ref.level()).stars(),
     };
-    auto it2 = enemy_details.insert({details, count});
-    if (!it2.second) it2.first->second += count;
+    auto it = enemy_details.insert({details, ref.count()});
+    if (!it.second) it.first->second += ref.count();
   }
 }
 
@@ -242,65 +171,19 @@ void EmitArray(std::ostream& out, const T& items, bool one_line = false,
   }
 }
 
-std::string RankToString(int rank) {
-  switch (rank) {
-    case 0:
-      return "Stone 1";
-    case 1:
-      return "Stone 2";
-    case 2:
-      return "Stone 3";
-    case 3:
-      return "Iron 1";
-    case 4:
-      return "Iron 2";
-    case 5:
-      return "Iron 3";
-    case 6:
-      return "Bronze 1";
-    case 7:
-      return "Bronze 2";
-    case 8:
-      return "Bronze 3";
-    case 9:
-      return "Silver 1";
-    case 10:
-      return "Silver 2";
-    case 11:
-      return "Silver 3";
-    case 12:
-      return "Gold 1";
-    case 13:
-      return "Gold 2";
-    case 14:
-      return "Gold 3";
-    case 15:
-      return "Diamond 1";
-    case 16:
-      return "Diamond 2";
-    case 17:
-      return "Diamond 3";
-    case 18:
-      return "Adamantine 1";
-    case 19:
-      return "Adamantine 2";
-    case 20:
-      return "Adamantine 3";
-    default:
-      LOG(ERROR) << "Unknown rank: " << rank;
-      return "Unknown Rank";
+absl::string_view RankToString(const int rank) {
+  if (rank < 0 || rank >= static_cast<int>(std::size(kRankNames))) {
+    LOG(ERROR) << "Unknown rank: " << rank;
+    return "Unknown Rank";
   }
+  return kRankNames[rank];
 }
 
-void EmitEnemies(std::ostream& out, const GameConfig& config,
+void EmitEnemies(std::ostream& out, const GameConfigIndex& index,
                  const Campaign::Battle& battle) {
   std::set<std::string> alliances, factions;
   std::map<EnemyDetails, int> enemy_details;
-  std::map<std::string, int> enemies;
-  for (const std::string& enemy : battle.enemies()) {
-    enemies[enemy]++;
-  }
-  CollectEnemyInfo(enemies, config, alliances, factions, enemy_details);
+  CollectEnemyInfo(battle, index, alliances, factions, enemy_details);
   out << "        \"enemiesAlliances\": [";
   EmitArray(out, alliances, /*one_line=*/true);
   out << "],\n";
@@ -330,7 +213,7 @@ void EmitEnemies(std::ostream& out, const GameConfig& config,
   out << "\n        ]\n";
 }
 
-void EmitCampaignBattle(std::ostream& out, const GameConfig& config,
+void EmitCampaignBattle(std::ostream& out, const GameConfigIndex& index,
                         const Campaign& campaign,
                         const Campaign::Battle& battle) {
   out << "    \"" << GetBattleId(campaign, battle) << "\": {\n";
@@ -358,52 +241,62 @@ void EmitCampaignBattle(std::ostream& out, const GameConfig& config,
   }
   out << "],\n";
   EmitBattleRewards(out, battle.reward());
-  EmitEnemies(out, config, battle);
+  EmitEnemies(out, index, battle);
   out << "    }";
 }
 
-void EmitCampaignBattles(std::ostream& out, const GameConfig& config,
+void EmitCampaignBattles(std::ostream& out, const GameConfigIndex& index,
                          const Campaign& campaign, bool& first) {
   for (const Campaign::Battle& battle : campaign.battles()) {
     if (!first) out << ",";
     first = false;
     out << "\n";
-    EmitCampaignBattle(out, config, campaign, battle);
+    EmitCampaignBattle(out, index, campaign, battle);
   }
 }
 
 }  // namespace
 
 absl::Status CreateCampaignData(const absl::string_view path,
-                                const GameConfig& game_config) {
-  std::ofstream out(std::string(path).c_str());
+                                const GameConfigIndex& index) {
+  TRACE_SCOPE("CreateCampaignData");
+  const GameConfig& game_config = index.config();
+  std::ostringstream out;
   // std::ostream& out = std::cout;  // debug
 
-  out << "{";
-  bool first = true;
+  // The campaigns in the order they appear in the output.
+  const std::vector<const Campaign*> campaigns =
+      MaterialDropIndex::Campaigns(game_config.client_game_config().battles());
 
-  for (const Campaign& campaign :
-       game_config.client_game_config().battles().standard_campaigns()) {
-    EmitCampaignBattles(out, game_config, campaign, first);
-  }
-  for (const Campaign& campaign :
-       game_config.client_game_config().battles().mirror_campaigns()) {
-    EmitCampaignBattles(out, game_config, campaign, first);
-  }
-  for (const Campaign& campaign :
-       game_config.client_game_config().battles().elite_campaigns()) {
-    EmitCampaignBattles(out, game_config, campaign, first);
-  }
-  for (const Campaign& campaign :
-       game_config.client_game_config().battles().mirror_elite_campaigns()) {
-    EmitCampaignBattles(out, game_config, campaign, first);
+  // Each campaign is rendered into its own buffer. A buffer holds the battles
+  // exactly as the serial loop would have written them, except that the
+  // separating comma before its first battle is left to the stitching below.
+  std::vector<std::string> rendered(campaigns.size());
+  {
+    // This usually runs on the miner's generator pool, so it only takes the
+    // cores the other generators leave free.
+    ThreadPool pool(std::min<int>(campaigns.size(),
+                                  ThreadPool::SpareThreadCount()));
+    for (size_t i = 0; i < campaigns.size(); ++i) {
+      pool.Schedule([&index, campaign = campaigns[i], &chunk = rendered[i]] {
+        std::ostringstream buffer;
+        bool first = true;
+        EmitCampaignBattles(buffer, index, *campaign, first);
+        chunk = buffer.str();
+      });
+    }
   }
-  for (const Campaign& campaign :
-       game_config.client_game_config().battles().campaign_events()) {
-    EmitCampaignBattles(out, game_config, campaign, first);
+
+  out << "{";
+  bool first = true;
+  for (const std::string& chunk : rendered) {
+    if (chunk.empty()) continue;
+    if (!first) out << ",";
+    first = false;
+    out << chunk;
   }
   out << "\n}\n";
-  return absl::OkStatus();
+  return WriteJsonOutput(path, out.str());
 }
 
 }  // namespace dataminer
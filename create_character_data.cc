@@ -1,37 +1,29 @@
-#include <sys/stat.h>
-
 #include <cstdio>
-#include <fstream>
+#include <sstream>
 
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "asset_manifest.h"
+#include "game_config_index.h"
+#include "icon_paths.h"
 #include "miner.pb.h"
+#include "output_writer.h"
+#include "trace.h"
 
 namespace dataminer {
 
 namespace {
 
-const Units::Ability* FindAbility(const GameConfig& game_config,
-                                  const absl::string_view name) {
-  for (const Units::Ability& ability :
-       game_config.client_game_config().units().abilities()) {
-    if (ability.id() == name) {
-      return &ability;
-    }
-  }
-  return nullptr;
-}
-
 void EmitAbility(
-    std::ofstream& out, const GameConfig& game_config,
+    std::ostream& out, const GameConfigIndex& index,
     const google::protobuf::RepeatedPtrField<std::string>& abilities,
     const absl::string_view label) {
   std::set<absl::string_view> damage_types;
   for (const absl::string_view name : abilities) {
-    const Units::Ability* ability = FindAbility(game_config, name);
+    const Units::Ability* ability = index.FindAbility(name);
     if (ability == nullptr) continue;
     for (const absl::string_view damage_type : ability->damage_types()) {
       if (!damage_type.empty()) {
@@ -53,71 +45,12 @@ void EmitAbility(
 }
 
 int GetCharacterNumber(const absl::string_view id,
-                       const GameConfig& game_config) {
-  int index = 0;
-  for (const Avatars::Avatar& avatar :
-       game_config.client_game_config().avatars().avatars()) {
-    if (avatar.unit_id() == id) return index;
-    ++index;
+                       const GameConfigIndex& index) {
+  const int number = index.AvatarIndex(id);
+  if (number < 0) {
+    LOG(ERROR) << "Couldn't find avatar for {\"" << id << "\", \"\"}";
   }
-  LOG(ERROR) << "Couldn't find avatar for {\"" << id << "\", \"\"}";
-  return -1;
-}
-
-std::string GetIconPath(const absl::string_view id,
-                        const GameConfig& game_config) {
-  constexpr absl::string_view img_prefix = "ui_image_portrait_";
-  constexpr absl::string_view img_suffix = ".png";
-  std::string img = "";
-  for (const Avatars::Avatar& avatar :
-       game_config.client_game_config().avatars().avatars()) {
-    if (avatar.unit_id() == id) {
-      img = avatar.id();
-      break;
-    }
-  }
-
-  img = absl::StrCat(img_prefix, img, img_suffix);
-  const std::string full_path = absl::StrCat("assets/characters/", img);
-  struct stat sbuf;
-  const int res = stat(full_path.c_str(), &sbuf);
-  if (res != 0) {
-    LOG(ERROR) << "Couldn't find avatar icon for {\"" << id << "\", \"\"}";
-  }
-
-  return absl::StrCat("snowprint_assets/characters/", img);
-}
-
-// TODO: refactor this with GetIconPath and GetCharacterNumber.
-std::string GetRoundIconPath(const absl::string_view id,
-                             const GameConfig& game_config) {
-  const std::map<std::string, std::string> kOverrides = {
-      {"spaceStormcaller",
-       R"(snowprint_assets/characters/ui_image_RoundPortrait_space_stormcaller_01.png)"},
-  };
-  if (const auto it = kOverrides.find(std::string(id)); it != kOverrides.end()) {
-    return it->second;
-  }
-  constexpr absl::string_view img_prefix = "ui_image_RoundPortrait_";
-  constexpr absl::string_view img_suffix = ".png";
-  std::string img = "";
-  for (const Avatars::Avatar& avatar :
-       game_config.client_game_config().avatars().avatars()) {
-    if (avatar.unit_id() == id) {
-      img = avatar.id();
-      break;
-    }
-  }
-
-  img = absl::StrCat(img_prefix, img, img_suffix);
-  const std::string full_path = absl::StrCat("assets/characters/", img);
-  struct stat sbuf;
-  const int res = stat(full_path.c_str(), &sbuf);
-  if (res != 0) {
-    LOG(ERROR) << "Couldn't find avatar icon for {\"" << id << "\", \"\"}";
-  }
-
-  return absl::StrCat("snowprint_assets/characters/", img);
+  return number;
 }
 
 }  // namespace
@@ -125,8 +58,11 @@ std::string GetRoundIconPath(const absl::string_view id,
 // Creates the character data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateCharacterData(const absl::string_view path,
-                                 const GameConfig& game_config) {
-  std::ofstream out(std::string(path).c_str());
+                                 const GameConfigIndex& index,
+                                 const AssetManifest& manifest) {
+  TRACE_SCOPE("CreateCharacterData");
+  const GameConfig& game_config = index.config();
+  std::ostringstream out;
 
   out << "[";
   bool first = true;
@@ -173,21 +109,20 @@ absl::Status CreateCharacterData(const absl::string_view path,
       out << "\"" << trait << "\"";
     }
     out << "]";
-    EmitAbility(out, game_config, unit.active_abilities(), "Active Ability");
-    EmitAbility(out, game_config, unit.passive_abilities(), "Passive Ability");
+    EmitAbility(out, index, unit.active_abilities(), "Active Ability");
+    EmitAbility(out, index, unit.passive_abilities(), "Passive Ability");
     out << ",\n";
-    out << "        \"Number\": " << GetCharacterNumber(unit.id(), game_config)
+    out << "        \"Number\": " << GetCharacterNumber(unit.id(), index)
         << ",\n";
-    out << "        \"Icon\": \"" << GetIconPath(unit.id(), game_config)
-        << "\",\n";
+    out << "        \"Icon\": \""
+        << GetIconPath(unit.id(), index, manifest) << "\",\n";
     out << "        \"RoundIcon\": \""
-        << GetRoundIconPath(unit.id(), game_config) << "\"\n";
+        << GetRoundIconPath(unit.id(), index, manifest) << "\"\n";
     out << "    }";
   }
   out << "\n]\n";
 
-  out.close();
-  return absl::OkStatus();
+  return WriteJsonOutput(path, out.str());
 }
 
 }  // namespace dataminer
@@ -3,14 +3,16 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
-#include "miner.pb.h"
+#include "asset_manifest.h"
+#include "game_config_index.h"
 
 namespace dataminer {
 
 // Creates the character data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateCharacterData(const absl::string_view path,
-                                 const GameConfig& game_config);
+                                 const GameConfigIndex& index,
+                                 const AssetManifest& manifest);
 
 }  // namespace dataminer
 
@@ -0,0 +1,95 @@
+#include "create_cost_data.h"
+
+#include <sstream>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "cost_rollup.h"
+#include "miner.pb.h"
+#include "output_writer.h"
+#include "recipe_graph.h"
+#include "trace.h"
+
+namespace dataminer {
+
+namespace {
+
+void EmitBadges(std::ostream& out, const absl::string_view name,
+                const absl::Span<const std::string> rarities,
+                const std::vector<int64_t>& amounts) {
+  out << ",\n            \"" << name << "\": {";
+  for (size_t i = 0; i < rarities.size(); ++i) {
+    if (i > 0) out << ",";
+    out << " \"" << rarities[i] << "\": " << amounts[i];
+  }
+  out << " }";
+}
+
+}  // namespace
+
+absl::Status CreateCostData(const absl::string_view path,
+                            const GameConfigIndex& index) {
+  TRACE_SCOPE("CreateCostData");
+  const ClientGameConfig& client_config = index.config().client_game_config();
+  absl::StatusOr<RecipeGraph> graph =
+      RecipeGraph::Build(client_config.upgrades());
+  if (!graph.ok()) return graph.status();
+  const CostRollup rollup = CostRollup::Build(client_config, *graph);
+
+  std::ostringstream out;
+  out << "{\n";
+  out << "    \"upgrades\": {";
+  for (int material = 0; material < graph->size(); ++material) {
+    if (material > 0) out << ",";
+    out << "\n";
+    out << "        \"" << graph->upgrade(material).id()
+        << "\": { \"craftGold\": " << rollup.CraftGold(material) << " }";
+  }
+  out << "\n    },\n";
+
+  out << "    \"items\": {";
+  bool first = true;
+  absl::flat_hash_set<absl::string_view> seen;
+  for (const Item& item : client_config.items().items()) {
+    // A repeated ID was only rolled up once, for its first item.
+    if (!seen.insert(item.id()).second) continue;
+    const absl::Span<const Cost> levels = rollup.ItemLevels(item.id());
+    if (!first) out << ",";
+    first = false;
+    out << "\n";
+    out << "        \"" << item.id() << "\": [";
+    for (size_t i = 0; i < levels.size(); ++i) {
+      if (i > 0) out << ",";
+      out << "\n";
+      out << "            { \"goldCost\": " << levels[i].gold
+          << ", \"salvageCost\": " << levels[i].salvage
+          << ", \"mythicSalvageCost\": " << levels[i].mythic_salvage << " }";
+    }
+    out << "\n        ]";
+  }
+  out << "\n    },\n";
+
+  out << "    \"mowAbilityLevels\": [";
+  first = true;
+  for (const Cost& level : rollup.MowAbilityLevels()) {
+    if (!first) out << ",";
+    first = false;
+    out << "\n";
+    out << "        {\n";
+    out << "            \"gold\": " << level.gold << ",\n";
+    out << "            \"salvage\": " << level.salvage << ",\n";
+    out << "            \"components\": " << level.components;
+    EmitBadges(out, "badges", rollup.badge_rarities(), level.badges);
+    EmitBadges(out, "forgeBadges", rollup.forge_badge_rarities(),
+               level.forge_badges);
+    out << "\n        }";
+  }
+  out << "\n    ]\n";
+  out << "}\n";
+
+  return WriteJsonOutput(path, out.str());
+}
+
+}  // namespace dataminer
@@ -0,0 +1,19 @@
+#ifndef __CREATE_COST_DATA_H__
+#define __CREATE_COST_DATA_H__
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "game_config_index.h"
+
+namespace dataminer {
+
+// Writes the cumulative cost tables from CostRollup to `path` as JSON: the
+// full crafting gold of each upgrade, and running totals over the levels of
+// each item and of MoW abilities, so that the cost between two levels is one
+// subtraction. Returns an error status if the creation fails.
+absl::Status CreateCostData(absl::string_view path,
+                            const GameConfigIndex& index);
+
+}  // namespace dataminer
+
+#endif  // __CREATE_COST_DATA_H__
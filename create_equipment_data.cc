@@ -1,12 +1,15 @@
 #ifndef __CREATE_EQUIPMENT_DATA_H__
 #define __CREATE_EQUIPMENT_DATA_H__
 
-#include <fstream>
+#include <sstream>
 #include <functional>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "game_config_index.h"
 #include "miner.pb.h"
+#include "output_writer.h"
+#include "trace.h"
 
 namespace dataminer {
 
@@ -104,8 +107,10 @@ void EmitItem(std::ostream& out, const Item& item) {
 // Creates the Equipment data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateEquipmentData(const absl::string_view path,
-                                 const GameConfig& game_config) {
-  std::ofstream out(std::string(path).c_str());
+                                 const GameConfigIndex& index) {
+  TRACE_SCOPE("CreateEquipmentData");
+  const GameConfig& game_config = index.config();
+  std::ostringstream out;
 
   out << "{";
   bool first = true;
@@ -117,8 +122,7 @@ absl::Status CreateEquipmentData(const absl::string_view path,
   }
   out << "\n}\n";
 
-  out.close();
-  return absl::OkStatus();
+  return WriteJsonOutput(path, out.str());
 }
 
 }  // namespace dataminer
@@ -0,0 +1,57 @@
+#include "create_material_drop_data.h"
+
+#include <sstream>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "material_drop_index.h"
+#include "miner.pb.h"
+#include "output_writer.h"
+#include "recipe_graph.h"
+#include "trace.h"
+
+namespace dataminer {
+
+absl::Status CreateMaterialDropData(const absl::string_view path,
+                                    const GameConfigIndex& index) {
+  TRACE_SCOPE("CreateMaterialDropData");
+  const ClientGameConfig& client_config = index.config().client_game_config();
+  absl::StatusOr<RecipeGraph> graph =
+      RecipeGraph::Build(client_config.upgrades());
+  if (!graph.ok()) return graph.status();
+  const MaterialDropIndex drop_index =
+      MaterialDropIndex::Build(client_config.battles(), *graph);
+
+  std::ostringstream out;
+  out << "{";
+  bool first = true;
+  for (int material = 0; material < graph->size(); ++material) {
+    const absl::Span<const MaterialDropIndex::Drop> drops =
+        drop_index.Drops(material);
+    if (drops.empty()) continue;
+    if (!first) out << ",";
+    first = false;
+    out << "\n";
+    out << "    \"" << graph->upgrade(material).id() << "\": [";
+    for (size_t i = 0; i < drops.size(); ++i) {
+      if (i > 0) out << ",";
+      out << "\n";
+      out << "        {\n";
+      out << "            \"battle\": \"" << drops[i].battle_id << "\",\n";
+      out << "            \"energyCost\": " << drops[i].energy_cost << ",\n";
+      out << "            \"effective_rate\": "
+          << absl::StrFormat("%.3f", drops[i].effective_rate) << ",\n";
+      out << "            \"energyPerDrop\": "
+          << absl::StrFormat("%.2f", drops[i].energy_per_drop) << "\n";
+      out << "        }";
+    }
+    out << "\n    ]";
+  }
+  out << "\n}\n";
+
+  return WriteJsonOutput(path, out.str());
+}
+
+}  // namespace dataminer
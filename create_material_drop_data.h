@@ -0,0 +1,18 @@
+#ifndef __CREATE_MATERIAL_DROP_DATA_H__
+#define __CREATE_MATERIAL_DROP_DATA_H__
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "game_config_index.h"
+
+namespace dataminer {
+
+// Writes the battles that drop each upgrade material, cheapest energy per
+// drop first, to `path` as JSON. Returns an error status if the creation
+// fails.
+absl::Status CreateMaterialDropData(absl::string_view path,
+                                    const GameConfigIndex& index);
+
+}  // namespace dataminer
+
+#endif  // __CREATE_MATERIAL_DROP_DATA_H__
@@ -1,68 +1,22 @@
-#include <sys/stat.h>
-
 #include <cstdio>
-#include <fstream>
+#include <sstream>
 
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "asset_manifest.h"
+#include "game_config_index.h"
+#include "icon_paths.h"
 #include "miner.pb.h"
+#include "output_writer.h"
+#include "trace.h"
 
 namespace dataminer {
 
 namespace {
 
-std::string GetIconPath(const absl::string_view id,
-                        const GameConfig& game_config) {
-  constexpr absl::string_view img_prefix = "ui_image_portrait_";
-  constexpr absl::string_view img_suffix = ".png";
-  std::string img = "";
-  for (const Avatars::Avatar& avatar :
-       game_config.client_game_config().avatars().avatars()) {
-    if (avatar.unit_id() == id) {
-      img = avatar.id();
-      break;
-    }
-  }
-
-  img = absl::StrCat(img_prefix, img, img_suffix);
-  const std::string full_path = absl::StrCat("assets/characters/", img);
-  struct stat sbuf;
-  const int res = stat(full_path.c_str(), &sbuf);
-  if (res != 0) {
-    LOG(ERROR) << "Couldn't find avatar icon for {\"" << id << "\", \"\"}";
-  }
-
-  return absl::StrCat("snowprint_assets/characters/", img);
-}
-
-// TODO: refactor this with GetIconPath and GetCharacterNumber.
-std::string GetRoundIconPath(const absl::string_view id,
-                             const GameConfig& game_config) {
-  constexpr absl::string_view img_prefix = "ui_image_RoundPortrait_";
-  constexpr absl::string_view img_suffix = ".png";
-  std::string img = "";
-  for (const Avatars::Avatar& avatar :
-       game_config.client_game_config().avatars().avatars()) {
-    if (avatar.unit_id() == id) {
-      img = avatar.id();
-      break;
-    }
-  }
-
-  img = absl::StrCat(img_prefix, img, img_suffix);
-  const std::string full_path = absl::StrCat("assets/characters/", img);
-  struct stat sbuf;
-  const int res = stat(full_path.c_str(), &sbuf);
-  if (res != 0) {
-    LOG(ERROR) << "Couldn't find avatar icon for {\"" << id << "\", \"\"}";
-  }
-
-  return absl::StrCat("snowprint_assets/characters/", img);
-}
-
 void EmitAbility(std::ostream& out, const MachineOfWar::Ability& ability,
                  const std::string& label) {
   if (ability.name().empty()) return;
@@ -86,8 +40,11 @@ void EmitAbility(std::ostream& out, const MachineOfWar::Ability& ability,
 }  // namespace
 
 absl::Status CreateMowData(const absl::string_view path,
-                           const GameConfig& game_config) {
-  std::ofstream out(std::string(path).c_str());
+                           const GameConfigIndex& index,
+                           const AssetManifest& manifest) {
+  TRACE_SCOPE("CreateMowData");
+  const GameConfig& game_config = index.config();
+  std::ostringstream out;
 
   out << "{\n";
   out << "    \"mows\": [\n";
@@ -103,10 +60,10 @@ absl::Status CreateMowData(const absl::string_view path,
     out << "            \"name\": \"" << mow.name() << "\",\n";
     out << "            \"factionId\": \"" << mow.faction_id() << "\",\n";
     out << "            \"alliance\": \"" << mow.alliance() << "\",\n";
-    out << "            \"icon\": \"" << GetIconPath(mow.id(), game_config)
-        << "\",\n";
+    out << "            \"icon\": \""
+        << GetIconPath(mow.id(), index, manifest) << "\",\n";
     out << "            \"roundIcon\": \""
-        << GetRoundIconPath(mow.id(), game_config) << "\",\n";
+        << GetRoundIconPath(mow.id(), index, manifest) << "\",\n";
     EmitAbility(out, mow.active_ability(), "primaryAbility");
     out << ",\n";
     EmitAbility(out, mow.passive_ability(), "secondaryAbility");
@@ -139,8 +96,7 @@ absl::Status CreateMowData(const absl::string_view path,
   out << "\n    ]\n";
   out << "}\n";
 
-  // out.close();
-  return absl::OkStatus();
+  return WriteJsonOutput(path, out.str());
 }
 
 }  // namespace dataminer
@@ -1,32 +1,23 @@
 #include "create_rank_up_data.h"
 
-#include <fstream>
+#include <sstream>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "campaign_tables.h"
 #include "miner.pb.h"
+#include "output_writer.h"
+#include "trace.h"
 
 namespace dataminer {
 
-namespace {
-
-constexpr absl::string_view kRanks[] = {
-    "Stone I",      "Stone II",      "Stone III",       //
-    "Iron I",       "Iron II",       "Iron III",        //
-    "Bronze I",     "Bronze II",     "Bronze III",      //
-    "Silver I",     "Silver II",     "Silver III",      //
-    "Gold I",       "Gold II",       "Gold III",        //
-    "Diamond I",    "Diamond II",    "Diamond III",     //
-    "Adamantine I", "Adamantine II", "Adamantine III",  //
-};
-
-}
-
 // Creates the rank-up data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateRankUpData(const absl::string_view path,
-                              const GameConfig& game_config) {
-  std::ofstream out(std::string(path).c_str());
+                              const GameConfigIndex& index) {
+  TRACE_SCOPE("CreateRankUpData");
+  const GameConfig& game_config = index.config();
+  std::ostringstream out;
 
   out << "{";
   bool first = true;
@@ -37,7 +28,7 @@ absl::Status CreateRankUpData(const absl::string_view path,
     out << "    \"" << unit.id() << "\": {\n";
     for (int i = 0; i < unit.rank_up_requirements_size(); ++i) {
       const Unit::RankUpRequirements& req = unit.rank_up_requirements(i);
-      out << "        \"" << kRanks[i] << "\": [\n";
+      out << "        \"" << kRomanRankNames[i] << "\": [\n";
       out << "            \"" << req.top_row_health() << "\",\n";
       out << "            \"" << req.bottom_row_health() << "\",\n";
       out << "            \"" << req.top_row_damage() << "\",\n";
@@ -52,8 +43,7 @@ absl::Status CreateRankUpData(const absl::string_view path,
   }
   out << "\n}\n";
 
-  out.close();
-  return absl::OkStatus();
+  return WriteJsonOutput(path, out.str());
 }
 
 }  // namespace dataminer
@@ -3,14 +3,14 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
-#include "miner.pb.h"
+#include "game_config_index.h"
 
 namespace dataminer {
 
 // Creates the rank-up data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateRankUpData(const absl::string_view path,
-                              const GameConfig& game_config);
+                              const GameConfigIndex& index);
 
 }  // namespace dataminer
 
@@ -1,12 +1,14 @@
 #include "create_recipe_data.h"
 
-#include <fstream>
+#include <sstream>
 #include <iostream>
 #include <map>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "miner.pb.h"
+#include "output_writer.h"
+#include "trace.h"
 
 namespace dataminer {
 
@@ -25,8 +27,10 @@ std::string ConvertStat(const absl::string_view stat_type) {
 // Creates the recipe data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateRecipeData(const absl::string_view path,
-                              const GameConfig& game_config) {
-  std::ofstream out(std::string(path).c_str());
+                              const GameConfigIndex& index) {
+  TRACE_SCOPE("CreateRecipeData");
+  const GameConfig& game_config = index.config();
+  std::ostringstream out;
 
   out << "{";
   bool first = true;
@@ -64,8 +68,7 @@ absl::Status CreateRecipeData(const absl::string_view path,
   }
   out << "\n}\n";
 
-  out.close();
-  return absl::OkStatus();
+  return WriteJsonOutput(path, out.str());
 }
 
 }  // namespace dataminer
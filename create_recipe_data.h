@@ -1,7 +1,7 @@
 #ifndef __CREATE_RECIPE_DATA_H__
 #define __CREATE_RECIPE_DATA_H__
 
-#include "miner.pb.h"
+#include "game_config_index.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 
@@ -10,7 +10,7 @@ namespace dataminer {
 // Creates the recipe data in the provided JSON root.
 // Returns an error status if the creation fails.
 absl::Status CreateRecipeData(const absl::string_view path,
-                              const GameConfig& game_config);
+                              const GameConfigIndex& index);
 
 }  // namespace dataminer
 
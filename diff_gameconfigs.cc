@@ -0,0 +1,86 @@
+// Diffs two versions of the gameconfig, field by field and keyed by entity
+// ID, as a starting point for patch notes, e.g.
+//
+// bazel run -c opt :diff_gameconfigs --
+//   --old_game_config=gameconfig_1_30.json
+//   --new_game_config=gameconfig_1_31.json
+//   --diff_json=/tmp/diff_1_30_1_31.json
+//
+// prints a summary of what was added, removed and changed, and writes the
+// whole diff as JSON to --diff_json. The i18n flags are optional; when they're
+// given, changes to the units' display strings are part of the diff too.
+// Pass --drop_rate_config_path as for :miner, so that loading doesn't
+// simulate the drop rates again.
+// See gameconfig_diff.h for what's compared.
+
+#include <iostream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "game_config_loader.h"
+#include "gameconfig_diff.h"
+#include "libjson/json/writer.h"
+#include "output_writer.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, old_game_config, "", "The older GameConfig.json.");
+ABSL_FLAG(std::string, new_game_config, "", "The newer GameConfig.json.");
+ABSL_FLAG(std::string, old_i18n_strings_json, "",
+          "The i18n strings file that goes with --old_game_config.");
+ABSL_FLAG(std::string, new_i18n_strings_json, "",
+          "The i18n strings file that goes with --new_game_config.");
+ABSL_FLAG(std::string, diff_json, "",
+          "If set, where to write the diff as JSON.");
+
+namespace dataminer {
+namespace {
+
+absl::Status Main() {
+  RET_CHECK(!absl::GetFlag(FLAGS_old_game_config).empty() &&
+            !absl::GetFlag(FLAGS_new_game_config).empty())
+      << "--old_game_config and --new_game_config are required.";
+
+  const absl::StatusOr<ArenaGameConfig> old_config =
+      LoadGameConfig(absl::GetFlag(FLAGS_old_game_config),
+                     absl::GetFlag(FLAGS_old_i18n_strings_json));
+  if (!old_config.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Error loading --old_game_config: ", old_config.status().message()));
+  }
+  const absl::StatusOr<ArenaGameConfig> new_config =
+      LoadGameConfig(absl::GetFlag(FLAGS_new_game_config),
+                     absl::GetFlag(FLAGS_new_i18n_strings_json));
+  if (!new_config.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Error loading --new_game_config: ", new_config.status().message()));
+  }
+
+  const GameConfigDiff diff =
+      DiffGameConfigs(old_config->config(), new_config->config());
+  std::cout << GameConfigDiffSummary(diff);
+  if (absl::GetFlag(FLAGS_diff_json).empty()) return absl::OkStatus();
+  return WriteOutput(
+      absl::GetFlag(FLAGS_diff_json),
+      Json::writeString(Json::StreamWriterBuilder(),
+                        GameConfigDiffToJson(diff)) +
+          "\n");
+}
+
+}  // namespace
+}  // namespace dataminer
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+  if (absl::Status status = dataminer::Main(); !status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,141 @@
+#include "farming_planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "covering_lp.h"
+
+namespace dataminer {
+
+namespace {
+
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+constexpr double kEpsilon = 1e-9;
+
+}  // namespace
+
+bool FarmingPlanner::CanRaid(const MaterialDropIndex::Drop& node,
+                             const absl::flat_hash_set<std::string>& factions,
+                             const Options& options) const {
+  if (options.roster.empty()) return true;
+  for (const std::string& unit : node.battle->required_units()) {
+    if (!options.roster.contains(unit)) return false;
+  }
+  if (node.campaign->allowed_factions().empty()) return true;
+  for (const std::string& faction : node.campaign->allowed_factions()) {
+    if (factions.contains(faction)) return true;
+  }
+  return false;
+}
+
+absl::StatusOr<FarmingPlanner::Plan> FarmingPlanner::PlanFarming(
+    const RecipeGraph::Materials& needs, const Options& options) const {
+  absl::flat_hash_set<std::string> factions;
+  for (const std::string& unit_id : options.roster) {
+    if (const Unit* unit = index_.FindUnit(unit_id); unit != nullptr) {
+      factions.insert(unit->faction_id());
+    }
+  }
+
+  const auto farmable = [&](const int material) {
+    for (const MaterialDropIndex::Drop& node : drops_.Drops(material)) {
+      if (CanRaid(node, factions, options)) return true;
+    }
+    return false;
+  };
+  // Materials no usable node drops are farmed as the base materials they're
+  // crafted from, if they're crafted at all.
+  const RecipeGraph& graph = drops_.graph();
+  RecipeGraph::Materials farmed;
+  for (const RecipeGraph::MaterialCount& need : needs) {
+    if (need.count <= 0) continue;
+    if (graph.Ingredients(need.material).empty() || farmable(need.material)) {
+      RecipeGraph::Accumulate({&need, 1}, 1, farmed);
+    } else {
+      graph.AddBaseMaterials(need.material, need.count, farmed);
+    }
+  }
+
+  // One column per usable node that drops something needed, and one row per
+  // needed material that some usable node drops.
+  Plan plan;
+  std::vector<const MaterialDropIndex::Drop*> nodes;
+  absl::flat_hash_map<const Campaign::Battle*, int> columns;
+  std::vector<std::vector<std::pair<int, double>>> row_entries;
+  std::vector<double> rhs;
+  std::vector<int> materials;
+  for (const RecipeGraph::MaterialCount& need : farmed) {
+    std::vector<std::pair<int, double>> entries;
+    for (const MaterialDropIndex::Drop& node : drops_.Drops(need.material)) {
+      if (!CanRaid(node, factions, options)) continue;
+      const auto [it, inserted] = columns.try_emplace(node.battle, nodes.size());
+      if (inserted) nodes.push_back(&node);
+      entries.push_back({it->second, node.effective_rate});
+    }
+    if (entries.empty()) {
+      plan.unfarmable.push_back(need);
+      continue;
+    }
+    row_entries.push_back(std::move(entries));
+    rhs.push_back(need.count);
+    materials.push_back(need.material);
+  }
+  if (nodes.empty()) return plan;
+
+  std::vector<double> costs(nodes.size());
+  std::vector<double> upper(nodes.size(), kInfinity);
+  for (size_t j = 0; j < nodes.size(); ++j) {
+    costs[j] = nodes[j]->energy_cost;
+    if (options.days > 0 && nodes[j]->battle->max_attempts() > 0) {
+      upper[j] =
+          static_cast<double>(options.days) * nodes[j]->battle->max_attempts();
+    }
+  }
+  std::vector<std::vector<double>> rows(rhs.size(),
+                                        std::vector<double>(nodes.size()));
+  for (size_t i = 0; i < rhs.size(); ++i) {
+    for (const auto& [column, rate] : row_entries[i]) rows[i][column] = rate;
+  }
+
+  CoveringLp lp(costs, upper, rows, rhs);
+  absl::StatusOr<std::vector<double>> solution = lp.Solve();
+  if (!solution.ok()) {
+    if (!lp.infeasible()) return solution.status();
+    std::vector<std::string> short_ids;
+    for (const int row : lp.short_constraints()) {
+      short_ids.push_back(drops_.graph().upgrade(materials[row]).id());
+    }
+    if (short_ids.empty()) {
+      return absl::ResourceExhaustedError(absl::StrCat(
+          "Can't farm everything in ", options.days,
+          " day(s); no drops cover the requested materials."));
+    }
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "Can't farm everything in ", options.days, " day(s); ran short of '",
+        absl::StrJoin(short_ids, "', '"), "'."));
+  }
+
+  for (size_t j = 0; j < nodes.size(); ++j) {
+    const double raids = (*solution)[j];
+    plan.fractional_energy += raids * costs[j];
+    // Bounds are whole numbers of raids, so rounding up stays within them.
+    const int64_t count = std::ceil(raids - kEpsilon);
+    if (count <= 0) continue;
+    plan.raids.push_back({nodes[j]->battle_id, nodes[j]->battle, count});
+    plan.energy += count * nodes[j]->energy_cost;
+  }
+  std::sort(plan.raids.begin(), plan.raids.end(),
+            [](const Raids& lhs, const Raids& rhs) {
+              return lhs.battle_id < rhs.battle_id;
+            });
+  return plan;
+}
+
+}  // namespace dataminer
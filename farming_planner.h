@@ -0,0 +1,84 @@
+#ifndef __FARMING_PLANNER_H__
+#define __FARMING_PLANNER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "game_config_index.h"
+#include "material_drop_index.h"
+#include "recipe_graph.h"
+
+namespace dataminer {
+
+// Works out how many times to raid each campaign node to farm a set of
+// materials for the least energy.
+//
+// This is a linear program: minimize the energy spent on raids, such that
+// the expected drops of every material cover what's needed, and no node is
+// raided more often than it allows. It's solved exactly over fractional raids
+// with a dual simplex, which starts from the all-zero plan (optimal, but
+// short of every material) and fixes one shortfall per pivot. Each node's
+// raids are then rounded up, so the plan still covers every need.
+//
+// Points into the MaterialDropIndex and GameConfigIndex it was built from,
+// which must outlive it. PlanFarming() doesn't modify the planner, so it can
+// be called from multiple threads.
+class FarmingPlanner {
+ public:
+  struct Options {
+    // The IDs of the units the player has. If not empty, battles that
+    // require a unit the player lacks are left out, as are campaigns
+    // limited to factions the player has no unit of.
+    absl::flat_hash_set<std::string> roster;
+    // How many days the farming can be spread over. Each node can be raided
+    // max_attempts times per day. Zero means there's no limit.
+    int days = 0;
+  };
+
+  struct Raids {
+    // The planner's name for the node, pointing into the drop index.
+    absl::string_view battle_id;
+    const Campaign::Battle* battle;
+    int64_t count;
+  };
+
+  struct Plan {
+    // The nodes to raid, sorted by battle ID.
+    std::vector<Raids> raids;
+    // The energy the rounded plan takes.
+    int64_t energy = 0;
+    // The energy the fractional optimum takes, which bounds how much the
+    // rounding costs.
+    double fractional_energy = 0;
+    // The needed base materials that no usable node drops, which the plan
+    // ignores.
+    RecipeGraph::Materials unfarmable;
+  };
+
+  FarmingPlanner(const MaterialDropIndex& drops, const GameConfigIndex& index)
+      : drops_(drops), index_(index) {}
+
+  // Plans the raids to farm `needs`, which is sorted by material, e.g. the
+  // output of RankUpQuery. A crafted material that no usable node drops is
+  // farmed as its base materials instead. Fails if the nodes can't be raided
+  // often enough to cover the needs in the time allowed.
+  absl::StatusOr<Plan> PlanFarming(const RecipeGraph::Materials& needs,
+                                   const Options& options) const;
+
+ private:
+  // Returns true if the player described by `options` can raid `node`.
+  bool CanRaid(const MaterialDropIndex::Drop& node,
+               const absl::flat_hash_set<std::string>& factions,
+               const Options& options) const;
+
+  const MaterialDropIndex& drops_;
+  const GameConfigIndex& index_;
+};
+
+}  // namespace dataminer
+
+#endif  // __FARMING_PLANNER_H__
@@ -0,0 +1,100 @@
+#include "game_config_index.h"
+
+namespace dataminer {
+
+namespace {
+
+// Indexes `entities` by `key`. When several share a key, the first wins.
+template <typename T, typename KeyFn>
+absl::flat_hash_map<absl::string_view, int> BuildIndex(
+    const google::protobuf::RepeatedPtrField<T>& entities, KeyFn key) {
+  absl::flat_hash_map<absl::string_view, int> index;
+  index.reserve(entities.size());
+  for (int i = 0; i < entities.size(); ++i) {
+    index.try_emplace(key(entities[i]), i);
+  }
+  return index;
+}
+
+template <typename T>
+absl::flat_hash_map<absl::string_view, int> BuildIdIndex(
+    const google::protobuf::RepeatedPtrField<T>& entities) {
+  return BuildIndex(entities, [](const T& entity) -> absl::string_view {
+    return entity.id();
+  });
+}
+
+int Lookup(const absl::flat_hash_map<absl::string_view, int>& index,
+           const absl::string_view key) {
+  const auto it = index.find(key);
+  return it == index.end() ? -1 : it->second;
+}
+
+template <typename T>
+const T* Get(const google::protobuf::RepeatedPtrField<T>& entities,
+             const int index) {
+  return index < 0 ? nullptr : &entities[index];
+}
+
+}  // namespace
+
+GameConfigIndex::GameConfigIndex(const GameConfig& config) : config_(config) {
+  const ClientGameConfig& client = config.client_game_config();
+  abilities_ = BuildIdIndex(client.units().abilities());
+  avatars_ = BuildIndex(client.avatars().avatars(),
+                        [](const Avatars::Avatar& avatar) -> absl::string_view {
+                          return avatar.unit_id();
+                        });
+  npcs_ = BuildIdIndex(client.units().npcs());
+  upgrades_ = BuildIdIndex(client.upgrades().upgrades());
+  items_ = BuildIdIndex(client.items().items());
+  units_ = BuildIdIndex(client.units().units());
+  mows_ = BuildIdIndex(client.units().mows());
+}
+
+const Units::Ability* GameConfigIndex::FindAbility(
+    const absl::string_view id) const {
+  return Get(config_.client_game_config().units().abilities(),
+             Lookup(abilities_, id));
+}
+
+const Avatars::Avatar* GameConfigIndex::FindAvatar(
+    const absl::string_view unit_id) const {
+  return Get(config_.client_game_config().avatars().avatars(),
+             AvatarIndex(unit_id));
+}
+
+const Npc* GameConfigIndex::FindNpc(const absl::string_view id) const {
+  return Get(config_.client_game_config().units().npcs(), Lookup(npcs_, id));
+}
+
+const Upgrades::Upgrade* GameConfigIndex::FindUpgrade(
+    const absl::string_view id) const {
+  return Get(config_.client_game_config().upgrades().upgrades(),
+             UpgradeIndex(id));
+}
+
+const Item* GameConfigIndex::FindItem(const absl::string_view id) const {
+  return Get(config_.client_game_config().items().items(),
+             Lookup(items_, id));
+}
+
+const Unit* GameConfigIndex::FindUnit(const absl::string_view id) const {
+  return Get(config_.client_game_config().units().units(),
+             Lookup(units_, id));
+}
+
+const MachineOfWar* GameConfigIndex::FindMow(
+    const absl::string_view id) const {
+  return Get(config_.client_game_config().units().mows(), Lookup(mows_, id));
+}
+
+int GameConfigIndex::AvatarIndex(const absl::string_view unit_id) const {
+  return Lookup(avatars_, unit_id);
+}
+
+int GameConfigIndex::UpgradeIndex(const absl::string_view id) const {
+  return Lookup(upgrades_, id);
+}
+
+}  // namespace dataminer
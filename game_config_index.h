@@ -0,0 +1,60 @@
+#ifndef __GAME_CONFIG_INDEX_H__
+#define __GAME_CONFIG_INDEX_H__
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "miner.pb.h"
+
+namespace dataminer {
+
+// Hash indexes over a parsed GameConfig, for the cross-entity lookups the
+// emitters do (a unit's abilities, its avatar, a battle's NPCs, a recipe's
+// ingredients). Built once after parsing and passed to every emitter, so
+// none of them has to scan a repeated field per lookup.
+//
+// The index points into the GameConfig it was built from, which must outlive
+// it and must not be modified while it exists. It's immutable once built, so
+// it can be shared between threads.
+class GameConfigIndex {
+ public:
+  explicit GameConfigIndex(const GameConfig& config);
+
+  GameConfigIndex(const GameConfigIndex&) = delete;
+  GameConfigIndex& operator=(const GameConfigIndex&) = delete;
+
+  const GameConfig& config() const { return config_; }
+
+  // Each Find* returns null if there's no entity with that ID. When IDs
+  // repeat, they resolve to the first entity, as parse_campaigns.cc's NPC
+  // lookup and RecipeGraph do.
+  const Units::Ability* FindAbility(absl::string_view id) const;
+  // Finds the avatar for a unit or MoW, by the unit's ID.
+  const Avatars::Avatar* FindAvatar(absl::string_view unit_id) const;
+  const Npc* FindNpc(absl::string_view id) const;
+  const Upgrades::Upgrade* FindUpgrade(absl::string_view id) const;
+  const Item* FindItem(absl::string_view id) const;
+  const Unit* FindUnit(absl::string_view id) const;
+  const MachineOfWar* FindMow(absl::string_view id) const;
+
+  // The position of a unit's avatar in the config's avatar list, which the
+  // planner uses as the character's number, or -1 if it has none.
+  int AvatarIndex(absl::string_view unit_id) const;
+  // The position of an upgrade in the config's upgrade list, or -1.
+  int UpgradeIndex(absl::string_view id) const;
+
+ private:
+  using IndexMap = absl::flat_hash_map<absl::string_view, int>;
+
+  const GameConfig& config_;
+  IndexMap abilities_;
+  IndexMap avatars_;
+  IndexMap npcs_;
+  IndexMap upgrades_;
+  IndexMap items_;
+  IndexMap units_;
+  IndexMap mows_;
+};
+
+}  // namespace dataminer
+
+#endif  // __GAME_CONFIG_INDEX_H__
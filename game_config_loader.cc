@@ -0,0 +1,278 @@
+#include "game_config_loader.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "libjson/json/reader.h"
+#include "metrics.h"
+#include "parse_avatars.h"
+#include "parse_campaigns.h"
+#include "parse_items.h"
+#include "parse_units.h"
+#include "parse_upgrades.h"
+#include "status_macros.h"
+#include "trace.h"
+
+namespace dataminer {
+
+namespace {
+
+// Counts the `count` entities parsed from the gameconfig's `section`.
+void CountParsed(const absl::string_view section, const int count) {
+  Metrics::Get()
+      .GetCounter("miner_entities_parsed_total",
+                  "Entities parsed from each gameconfig section.",
+                  {{"section", std::string(section)}})
+      .Increment(count);
+}
+
+// Reads the JSON file at `path` into `root`.
+absl::Status ReadJson(const absl::string_view path, Json::Value& root) {
+  std::string text;
+  return ReadJsonFile(path, text, root);
+}
+
+absl::Status ParseMilestones(const Json::Value& milestones,
+                             Achievement& achievement) {
+  if (!milestones.isArray()) {
+    return absl::InvalidArgumentError("Milestones must be an array.");
+  }
+  for (const Json::Value& milestone : milestones) {
+    if (!milestone.isObject()) {
+      return absl::InvalidArgumentError("Each milestone must be an object.");
+    }
+    Achievement::Milestone& m = *achievement.add_milestones();
+    if (milestone.isMember("goal")) {
+      m.set_goal(milestone.get("goal", {}).asInt());
+    }
+    if (milestone.isMember("reward")) {
+      m.set_reward(milestone.get("reward", {}).asString());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ParseAchievements(const Json::Value& achievements,
+                               ClientGameConfig& client_config) {
+  if (!achievements.isArray()) {
+    return absl::InvalidArgumentError("Achievements must be an array.");
+  }
+  for (const Json::Value& achievement : achievements) {
+    if (!achievement.isObject()) {
+      return absl::InvalidArgumentError("Each achievement must be an object.");
+    }
+    Achievement& a = *client_config.add_achievements();
+    if (!achievement.isMember("achievementId")) {
+      return absl::InvalidArgumentError(
+          "Each achievement must have an 'achievementId' field.");
+    }
+    a.set_id(achievement.get("achievementId", "").asString());
+    if (!achievement.isMember("taskId")) {
+      return absl::InvalidArgumentError(
+          "Each achievement must have a 'taskId' field.");
+    }
+    a.set_task_id(achievement.get("taskId", "").asString());
+    if (achievement.isMember("milestones")) {
+      const absl::Status milestones =
+          ParseMilestones(achievement["milestones"], a);
+      if (!milestones.ok()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Error parsing milestones: ", milestones.message()));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ParseClientGameConfig(const Json::Value& root,
+                                   const GameConfigSections& sections,
+                                   ClientGameConfig& client_config) {
+  TRACE_SCOPE("ParseClientGameConfig");
+  if (!root.isObject()) {
+    return absl::InvalidArgumentError("Parsed JSON is not an object.");
+  }
+  if (sections.achievements) {
+    if (!root.isMember("achievements")) {
+      return absl::InvalidArgumentError("Missing 'achievements' in JSON.");
+    }
+    const absl::Status achievements =
+        ParseAchievements(root["achievements"], client_config);
+    if (!achievements.ok()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Error parsing achievements: ", achievements.message()));
+    }
+  }
+
+  if (sections.upgrades) {
+    const absl::Status upgrades =
+        ParseUpgrades(root["upgrades"], *client_config.mutable_upgrades());
+    if (!upgrades.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Error parsing upgrades: ", upgrades.message()));
+    }
+  }
+
+  // The battles' enemies are resolved against the NPCs.
+  if (sections.units || sections.battles) {
+    const absl::Status units =
+        ParseUnits(root["units"], *client_config.mutable_units());
+    if (!units.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Error parsing units: ", units.message()));
+    }
+  }
+
+  if (sections.avatars) {
+    const absl::Status avatars =
+        ParseAvatars(root["avatars"], *client_config.mutable_avatars());
+    if (!avatars.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Error parsing avatars: ", avatars.message()));
+    }
+  }
+
+  if (sections.battles) {
+    RETURN_IF_ERROR(ParseCampaigns(root["battles"], client_config.units(),
+                                   *client_config.mutable_battles()));
+  }
+
+  if (sections.items) {
+    RETURN_IF_ERROR(
+        ParseItems(root["items"], *client_config.mutable_items()));
+  }
+
+  CountParsed("achievements", client_config.achievements_size());
+  CountParsed("upgrades", client_config.upgrades().upgrades_size());
+  CountParsed("units", client_config.units().units_size());
+  CountParsed("npcs", client_config.units().npcs_size());
+  CountParsed("avatars", client_config.avatars().avatars_size());
+  const Battles& battles = client_config.battles();
+  int num_battles = 0;
+  for (const google::protobuf::RepeatedPtrField<Campaign>* list :
+       {&battles.standard_campaigns(), &battles.mirror_campaigns(),
+        &battles.elite_campaigns(), &battles.mirror_elite_campaigns(),
+        &battles.campaign_events()}) {
+    for (const Campaign& campaign : *list) {
+      num_battles += campaign.battles_size();
+    }
+  }
+  CountParsed("battles", num_battles);
+  CountParsed("items", client_config.items().items_size());
+  return absl::OkStatus();
+}
+
+// Options for the arena a whole GameConfig goes on.
+google::protobuf::ArenaOptions GameConfigArenaOptions() {
+  google::protobuf::ArenaOptions options;
+  // A full config runs to megabytes, so let the blocks grow well past the
+  // default cap rather than allocating hundreds of small ones.
+  options.max_block_size = 1 << 20;
+  return options;
+}
+
+}  // namespace
+
+absl::Status ReadJsonFile(const absl::string_view path, std::string& text,
+                          Json::Value& root) {
+  TRACE_SCOPE("ReadJson");
+  std::ifstream in{std::string(path), std::ios::binary};
+  if (!in) {
+    return absl::NotFoundError(absl::StrCat("Couldn't open '", path, "'."));
+  }
+  text.assign(std::istreambuf_iterator<char>(in),
+              std::istreambuf_iterator<char>());
+  Json::Reader reader;
+  if (!reader.parse(text.data(), text.data() + text.size(), root)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Couldn't parse json file: '", path,
+                     "': ", reader.getFormattedErrorMessages()));
+  }
+  if (!root.isObject()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Parsed JSON in '", path, "' is not an object."));
+  }
+  return absl::OkStatus();
+}
+
+ArenaGameConfig::ArenaGameConfig()
+    : arena_(std::make_unique<google::protobuf::Arena>(
+          GameConfigArenaOptions())),
+      config_(google::protobuf::Arena::Create<GameConfig>(arena_.get())) {}
+
+absl::Status ParseGameConfig(const Json::Value& root, GameConfig& config) {
+  return ParseGameConfig(root, GameConfigSections(), config);
+}
+
+absl::Status ParseGameConfig(const Json::Value& root,
+                             const GameConfigSections& sections,
+                             GameConfig& config) {
+  TRACE_SCOPE("ParseGameConfig");
+  if (!root.isObject()) {
+    return absl::InvalidArgumentError("Parsed JSON is not an object.");
+  }
+  const absl::Status client_config =
+      ParseClientGameConfig(root["clientGameConfig"], sections,
+                            *config.mutable_client_game_config());
+  if (!client_config.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Error parsing ClientGameConfig: ", client_config.message()));
+  }
+
+  if (!root.isMember("clientGameConfigVersion")) {
+    return absl::InvalidArgumentError(
+        "Missing 'clientGameConfigVersion' in JSON.");
+  }
+  if (!root.isMember("fullConfig")) {
+    return absl::InvalidArgumentError("Missing 'fullConfig' in JSON.");
+  }
+  if (!root.isMember("fullConfigHash")) {
+    return absl::InvalidArgumentError("Missing 'fullConfigHash' in JSON.");
+  }
+  config.set_client_game_config_version(
+      root["clientGameConfigVersion"].asString());
+  config.set_full_config(root["fullConfig"].asBool());
+  config.set_full_config_hash(root["fullConfigHash"].asString());
+
+  return absl::OkStatus();
+}
+
+absl::StatusOr<ArenaGameConfig> LoadGameConfig(
+    const absl::string_view game_config_path,
+    const absl::string_view i18n_path) {
+  AllocationScope allocations("LoadGameConfig");
+  Json::Value root;
+  RETURN_IF_ERROR(ReadJson(game_config_path, root));
+  return LoadGameConfig(root, i18n_path, GameConfigSections());
+}
+
+absl::StatusOr<ArenaGameConfig> LoadGameConfig(
+    const Json::Value& game_config_root, const absl::string_view i18n_path,
+    const GameConfigSections& sections) {
+  TRACE_SCOPE("LoadGameConfig");
+  ArenaGameConfig config;
+  const absl::Status parsed =
+      ParseGameConfig(game_config_root, sections, *config.mutable_config());
+  if (!parsed.ok()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Error parsing GameConfig: ", parsed.message()));
+  }
+  if (i18n_path.empty() || !sections.units) return config;
+
+  Json::Value root;
+  RETURN_IF_ERROR(ReadJson(i18n_path, root));
+  absl::Status status = AmendUnitsWithDisplayStrings(
+      root, config.mutable_config()->mutable_client_game_config()
+                ->mutable_units());
+  if (!status.ok()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Error parsing i18n strings: ", status.message()));
+  }
+  return config;
+}
+
+}  // namespace dataminer
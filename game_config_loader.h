@@ -0,0 +1,82 @@
+#ifndef __GAME_CONFIG_LOADER_H__
+#define __GAME_CONFIG_LOADER_H__
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "libjson/json/value.h"
+#include "miner.pb.h"
+
+namespace dataminer {
+
+// A GameConfig allocated on its own protobuf arena. The parsers build every
+// message of the config in place on the arena, so loading one never copies a
+// submessage, and destroying it frees the whole config at once instead of
+// message by message.
+//
+// Moving an ArenaGameConfig doesn't move the config, so pointers into it, e.g.
+// a GameConfigIndex, stay valid.
+class ArenaGameConfig {
+ public:
+  // Creates an empty config.
+  ArenaGameConfig();
+
+  ArenaGameConfig(ArenaGameConfig&&) = default;
+  ArenaGameConfig& operator=(ArenaGameConfig&&) = default;
+
+  const GameConfig& config() const { return *config_; }
+  GameConfig* mutable_config() { return config_; }
+
+ private:
+  std::unique_ptr<google::protobuf::Arena> arena_;
+  // Owned by arena_.
+  GameConfig* config_;
+};
+
+// The sections of the clientGameConfig to parse. The ones left out stay
+// empty in the GameConfig, except that the units are always parsed along
+// with the battles, whose enemies refer to them.
+struct GameConfigSections {
+  bool achievements = true;
+  bool upgrades = true;
+  bool units = true;
+  bool avatars = true;
+  bool battles = true;
+  bool items = true;
+};
+
+// Reads the JSON file at `path` into `root`, and its text into `text`, which
+// the offsets of `root`'s values (getOffsetStart() and getOffsetLimit())
+// refer to. Fails with NotFound if the file can't be opened.
+absl::Status ReadJsonFile(absl::string_view path, std::string& text,
+                          Json::Value& root);
+
+// Parses the root of the gameconfig JSON into `config`, which should be empty.
+// The messages are built in place, so they end up on `config`'s arena, if it
+// has one.
+absl::Status ParseGameConfig(const Json::Value& root, GameConfig& config);
+
+// Like the above, but only parses `sections`.
+absl::Status ParseGameConfig(const Json::Value& root,
+                             const GameConfigSections& sections,
+                             GameConfig& config);
+
+// Reads and parses the gameconfig JSON at `game_config_path`. If `i18n_path`
+// isn't empty, also adds the English display strings from the i18n JSON
+// there to the units. Fails with NotFound if a file can't be opened.
+absl::StatusOr<ArenaGameConfig> LoadGameConfig(
+    absl::string_view game_config_path, absl::string_view i18n_path);
+
+// Like the above, but for a gameconfig that's already been read, and only
+// parses `sections`. The i18n JSON is only read if `sections.units` is set.
+absl::StatusOr<ArenaGameConfig> LoadGameConfig(
+    const Json::Value& game_config_root, absl::string_view i18n_path,
+    const GameConfigSections& sections);
+
+}  // namespace dataminer
+
+#endif  // __GAME_CONFIG_LOADER_H__
@@ -0,0 +1,424 @@
+#include "gameconfig_diff.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "libjson/json/writer.h"
+#include "material_drop_index.h"
+#include "trace.h"
+
+namespace dataminer {
+namespace {
+
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+
+// The fields of ClientGameConfig and its submessages that hold the entities
+// Sections() lists. Nothing else holds them, so skipping them everywhere
+// leaves them out of the "other" section and nothing more.
+bool IsEntityList(const FieldDescriptor* field) {
+  static const auto* const kLists = new std::vector<const FieldDescriptor*>{
+      ClientGameConfig::descriptor()->FindFieldByNumber(
+          ClientGameConfig::kAchievementsFieldNumber),
+      ClientGameConfig::descriptor()->FindFieldByNumber(
+          ClientGameConfig::kBattlesFieldNumber),
+      Units::descriptor()->FindFieldByNumber(Units::kUnitsFieldNumber),
+      Units::descriptor()->FindFieldByNumber(Units::kMowsFieldNumber),
+      Units::descriptor()->FindFieldByNumber(Units::kNpcsFieldNumber),
+      Units::descriptor()->FindFieldByNumber(Units::kAbilitiesFieldNumber),
+      Upgrades::descriptor()->FindFieldByNumber(Upgrades::kUpgradesFieldNumber),
+      Items::descriptor()->FindFieldByNumber(Items::kItemsFieldNumber),
+      Avatars::descriptor()->FindFieldByNumber(Avatars::kAvatarsFieldNumber),
+  };
+  return std::find(kLists->begin(), kLists->end(), field) != kLists->end();
+}
+
+// Fields that DiffMessages doesn't look at: battles and the other entity
+// lists have their own sections, and the rest are derived (see the header).
+bool IsSkipped(const FieldDescriptor* field) {
+  if (IsEntityList(field)) return true;
+  static const FieldDescriptor* const kBattles =
+      Campaign::descriptor()->FindFieldByNumber(Campaign::kBattlesFieldNumber);
+  static const FieldDescriptor* const kEnemyRefs =
+      Campaign::Battle::descriptor()->FindFieldByNumber(
+          Campaign::Battle::kEnemyRefsFieldNumber);
+  static const FieldDescriptor* const kEffectiveRate =
+      Campaign::Battle::PotentialRewardItem::descriptor()->FindFieldByNumber(
+          Campaign::Battle::PotentialRewardItem::kEffectiveRateFieldNumber);
+  return field == kBattles || field == kEnemyRefs || field == kEffectiveRate;
+}
+
+Json::Value MessageToJson(const Message& message);
+
+// The `index`th value of a repeated field, or the value of a singular one if
+// `index` is -1.
+Json::Value FieldValueToJson(const Message& message,
+                             const FieldDescriptor* field, const int index) {
+  const Reflection* reflection = message.GetReflection();
+  const bool repeated = index >= 0;
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return repeated ? reflection->GetRepeatedInt32(message, field, index)
+                      : reflection->GetInt32(message, field);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return Json::Int64{
+          repeated ? reflection->GetRepeatedInt64(message, field, index)
+                   : reflection->GetInt64(message, field)};
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return repeated ? reflection->GetRepeatedUInt32(message, field, index)
+                      : reflection->GetUInt32(message, field);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return Json::UInt64{
+          repeated ? reflection->GetRepeatedUInt64(message, field, index)
+                   : reflection->GetUInt64(message, field)};
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return repeated ? reflection->GetRepeatedDouble(message, field, index)
+                      : reflection->GetDouble(message, field);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return repeated ? reflection->GetRepeatedFloat(message, field, index)
+                      : reflection->GetFloat(message, field);
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return repeated ? reflection->GetRepeatedBool(message, field, index)
+                      : reflection->GetBool(message, field);
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return std::string(
+          (repeated ? reflection->GetRepeatedEnum(message, field, index)
+                    : reflection->GetEnum(message, field))
+              ->name());
+    case FieldDescriptor::CPPTYPE_STRING:
+      return repeated ? reflection->GetRepeatedString(message, field, index)
+                      : reflection->GetString(message, field);
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return MessageToJson(
+          repeated ? reflection->GetRepeatedMessage(message, field, index)
+                   : reflection->GetMessage(message, field));
+  }
+  return Json::Value();
+}
+
+// The whole of a field: an array for a repeated field, and null for a
+// singular one that isn't set.
+Json::Value FieldToJson(const Message& message, const FieldDescriptor* field) {
+  const Reflection* reflection = message.GetReflection();
+  if (!field->is_repeated()) {
+    if (!reflection->HasField(message, field)) return Json::Value();
+    return FieldValueToJson(message, field, -1);
+  }
+  Json::Value array(Json::arrayValue);
+  const int size = reflection->FieldSize(message, field);
+  for (int i = 0; i < size; ++i) {
+    array.append(FieldValueToJson(message, field, i));
+  }
+  return array;
+}
+
+// The set fields of `message`, by their proto names.
+Json::Value MessageToJson(const Message& message) {
+  Json::Value json(Json::objectValue);
+  const auto* descriptor = message.GetDescriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (IsSkipped(field)) continue;
+    Json::Value value = FieldToJson(message, field);
+    if (value.isNull() || (value.isArray() && value.empty())) continue;
+    json[std::string(field->name())] = std::move(value);
+  }
+  return json;
+}
+
+void DiffMessages(const Message& old_message, const Message& new_message,
+                  const std::string& prefix,
+                  std::vector<FieldChange>& changes);
+
+// Repeated messages are compared element by element, so that a changed stat
+// in one level is one change rather than the whole list. Other repeated
+// fields are too if their length didn't change, e.g. a changed XP level, and
+// are reported whole if it did.
+void DiffRepeatedField(const Message& old_message, const Message& new_message,
+                       const FieldDescriptor* field, const std::string& path,
+                       std::vector<FieldChange>& changes) {
+  const Reflection* old_reflection = old_message.GetReflection();
+  const Reflection* new_reflection = new_message.GetReflection();
+  const int old_size = old_reflection->FieldSize(old_message, field);
+  const int new_size = new_reflection->FieldSize(new_message, field);
+  if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    if (old_size == new_size) {
+      for (int i = 0; i < old_size; ++i) {
+        Json::Value old_value = FieldValueToJson(old_message, field, i);
+        Json::Value new_value = FieldValueToJson(new_message, field, i);
+        if (old_value != new_value) {
+          changes.push_back({absl::StrCat(path, "[", i, "]"),
+                             std::move(old_value), std::move(new_value)});
+        }
+      }
+      return;
+    }
+    changes.push_back({path, FieldToJson(old_message, field),
+                       FieldToJson(new_message, field)});
+    return;
+  }
+  for (int i = 0; i < std::max(old_size, new_size); ++i) {
+    const std::string element = absl::StrCat(path, "[", i, "]");
+    if (i >= old_size) {
+      changes.push_back({element, Json::Value(),
+                         FieldValueToJson(new_message, field, i)});
+    } else if (i >= new_size) {
+      changes.push_back({element, FieldValueToJson(old_message, field, i),
+                         Json::Value()});
+    } else {
+      DiffMessages(old_reflection->GetRepeatedMessage(old_message, field, i),
+                   new_reflection->GetRepeatedMessage(new_message, field, i),
+                   element, changes);
+    }
+  }
+}
+
+// Appends a change for each leaf field that differs between the messages,
+// which must be of the same type. Unset submessages compare like empty ones,
+// so a new submessage shows up as its set fields.
+void DiffMessages(const Message& old_message, const Message& new_message,
+                  const std::string& prefix,
+                  std::vector<FieldChange>& changes) {
+  const auto* descriptor = old_message.GetDescriptor();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (IsSkipped(field)) continue;
+    const std::string path =
+        prefix.empty() ? std::string(field->name())
+                       : absl::StrCat(prefix, ".", field->name());
+    if (field->is_repeated()) {
+      DiffRepeatedField(old_message, new_message, field, path, changes);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      DiffMessages(old_message.GetReflection()->GetMessage(old_message, field),
+                   new_message.GetReflection()->GetMessage(new_message, field),
+                   path, changes);
+    } else {
+      Json::Value old_value = FieldToJson(old_message, field);
+      Json::Value new_value = FieldToJson(new_message, field);
+      if (old_value != new_value) {
+        changes.push_back({path, std::move(old_value), std::move(new_value)});
+      }
+    }
+  }
+}
+
+// The entities of one section of one config, in config order.
+class Entities {
+ public:
+  // Entities whose id was already added are dropped.
+  void Add(const std::string& id, const Message& message) {
+    if (index_.try_emplace(id, entities_.size()).second) {
+      entities_.push_back({id, &message});
+    }
+  }
+
+  const Message* Find(const std::string& id) const {
+    const auto it = index_.find(id);
+    return it == index_.end() ? nullptr : entities_[it->second].second;
+  }
+
+  const std::vector<std::pair<std::string, const Message*>>& entities() const {
+    return entities_;
+  }
+
+ private:
+  std::vector<std::pair<std::string, const Message*>> entities_;
+  absl::flat_hash_map<std::string, size_t> index_;
+};
+
+template <typename T>
+void AddAll(const google::protobuf::RepeatedPtrField<T>& messages,
+            Entities& entities) {
+  for (const T& message : messages) entities.Add(message.id(), message);
+}
+
+// One Entities per section, in the order they're reported.
+std::vector<std::pair<std::string, Entities>> Sections(
+    const GameConfig& config) {
+  const ClientGameConfig& client = config.client_game_config();
+  std::vector<std::pair<std::string, Entities>> sections(10);
+  sections[0].first = "units";
+  AddAll(client.units().units(), sections[0].second);
+  sections[1].first = "mows";
+  AddAll(client.units().mows(), sections[1].second);
+  sections[2].first = "npcs";
+  AddAll(client.units().npcs(), sections[2].second);
+  sections[3].first = "abilities";
+  AddAll(client.units().abilities(), sections[3].second);
+  sections[4].first = "upgrades";
+  AddAll(client.upgrades().upgrades(), sections[4].second);
+  sections[5].first = "items";
+  AddAll(client.items().items(), sections[5].second);
+  sections[6].first = "avatars";
+  AddAll(client.avatars().avatars(), sections[6].second);
+  sections[7].first = "campaigns";
+  sections[8].first = "battles";
+  for (const Campaign* campaign :
+       MaterialDropIndex::Campaigns(client.battles())) {
+    sections[7].second.Add(campaign->id(), *campaign);
+    for (const Campaign::Battle& battle : campaign->battles()) {
+      sections[8].second.Add(absl::StrCat(campaign->id(), "/", battle.id()),
+                             battle);
+    }
+  }
+  sections[9].first = "achievements";
+  AddAll(client.achievements(), sections[9].second);
+  return sections;
+}
+
+// Writes the message's wire format to `buffer`, which is reused between
+// calls to save reallocating it. Nothing in the config is a proto map, so
+// the serialization is deterministic.
+void Serialize(const Message& message, std::string& buffer) {
+  buffer.clear();
+  message.AppendToString(&buffer);
+}
+
+SectionDiff DiffSection(const std::string& name, const Entities& old_entities,
+                        const Entities& new_entities) {
+  SectionDiff diff;
+  diff.name = name;
+  std::string old_buffer;
+  std::string new_buffer;
+  for (const auto& [id, old_message] : old_entities.entities()) {
+    if (new_entities.Find(id) == nullptr) diff.removed.push_back(id);
+  }
+  for (const auto& [id, new_message] : new_entities.entities()) {
+    const Message* old_message = old_entities.Find(id);
+    if (old_message == nullptr) {
+      diff.added.push_back(id);
+      continue;
+    }
+    Serialize(*old_message, old_buffer);
+    Serialize(*new_message, new_buffer);
+    if (old_buffer == new_buffer) {
+      ++diff.unchanged;
+      continue;
+    }
+    // The serializations also cover the fields DiffMessages skips, so they can
+    // differ with no changes to report.
+    EntityChange change{id, {}};
+    DiffMessages(*old_message, *new_message, "", change.fields);
+    if (change.fields.empty()) {
+      ++diff.unchanged;
+    } else {
+      diff.changed.push_back(std::move(change));
+    }
+  }
+  return diff;
+}
+
+// Everything in the configs outside the entity lists, such as the MoW
+// upgrade costs and the XP levels, as one entity. Serializing it would take
+// the entity lists with it, so its fields are walked directly.
+SectionDiff DiffOther(const ClientGameConfig& old_client,
+                      const ClientGameConfig& new_client) {
+  SectionDiff diff;
+  diff.name = "other";
+  EntityChange change{"clientGameConfig", {}};
+  DiffMessages(old_client, new_client, "", change.fields);
+  if (change.fields.empty()) {
+    ++diff.unchanged;
+  } else {
+    diff.changed.push_back(std::move(change));
+  }
+  return diff;
+}
+
+Json::Value StringsToJson(const std::vector<std::string>& strings) {
+  Json::Value array(Json::arrayValue);
+  for (const std::string& s : strings) array.append(s);
+  return array;
+}
+
+// A value on one line, e.g. 12, "foo", [1,2] or null.
+std::string CompactJson(const Json::Value& value) {
+  static const Json::StreamWriterBuilder* const kBuilder = [] {
+    auto* builder = new Json::StreamWriterBuilder();
+    (*builder)["indentation"] = "";
+    return builder;
+  }();
+  return Json::writeString(*kBuilder, value);
+}
+
+}  // namespace
+
+GameConfigDiff DiffGameConfigs(const GameConfig& old_config,
+                               const GameConfig& new_config) {
+  TRACE_SCOPE("DiffGameConfigs");
+  GameConfigDiff diff;
+  diff.old_version = old_config.client_game_config_version();
+  diff.new_version = new_config.client_game_config_version();
+  const auto old_sections = Sections(old_config);
+  const auto new_sections = Sections(new_config);
+  for (size_t i = 0; i < old_sections.size(); ++i) {
+    diff.sections.push_back(DiffSection(
+        old_sections[i].first, old_sections[i].second, new_sections[i].second));
+  }
+  diff.sections.push_back(DiffOther(old_config.client_game_config(),
+                                    new_config.client_game_config()));
+  return diff;
+}
+
+Json::Value GameConfigDiffToJson(const GameConfigDiff& diff) {
+  Json::Value json(Json::objectValue);
+  json["old_version"] = diff.old_version;
+  json["new_version"] = diff.new_version;
+  Json::Value& sections = json["sections"] = Json::Value(Json::objectValue);
+  for (const SectionDiff& section : diff.sections) {
+    Json::Value& s = sections[section.name] = Json::Value(Json::objectValue);
+    s["added"] = StringsToJson(section.added);
+    s["removed"] = StringsToJson(section.removed);
+    s["unchanged"] = section.unchanged;
+    Json::Value& changed = s["changed"] = Json::Value(Json::arrayValue);
+    for (const EntityChange& entity : section.changed) {
+      Json::Value& e = changed.append(Json::Value(Json::objectValue));
+      e["id"] = entity.id;
+      Json::Value& fields = e["fields"] = Json::Value(Json::arrayValue);
+      for (const FieldChange& field : entity.fields) {
+        Json::Value& f = fields.append(Json::Value(Json::objectValue));
+        f["path"] = field.path;
+        f["old"] = field.old_value;
+        f["new"] = field.new_value;
+      }
+    }
+  }
+  return json;
+}
+
+std::string GameConfigDiffSummary(const GameConfigDiff& diff) {
+  std::string summary =
+      absl::StrCat("gameconfig ", diff.old_version, " -> ", diff.new_version,
+                   "\n");
+  for (const SectionDiff& section : diff.sections) {
+    absl::StrAppend(&summary, section.name, ": ", section.added.size(),
+                    " added, ", section.removed.size(), " removed, ",
+                    section.changed.size(), " changed, ", section.unchanged,
+                    " unchanged\n");
+    for (const std::string& id : section.added) {
+      absl::StrAppend(&summary, "  + ", id, "\n");
+    }
+    for (const std::string& id : section.removed) {
+      absl::StrAppend(&summary, "  - ", id, "\n");
+    }
+    for (const EntityChange& entity : section.changed) {
+      absl::StrAppend(&summary, "  ~ ", entity.id, "\n");
+      for (const FieldChange& field : entity.fields) {
+        absl::StrAppend(&summary, "      ", field.path, ": ",
+                        CompactJson(field.old_value), " -> ",
+                        CompactJson(field.new_value), "\n");
+      }
+    }
+  }
+  return summary;
+}
+
+}  // namespace dataminer
@@ -0,0 +1,70 @@
+#ifndef __GAMECONFIG_DIFF_H__
+#define __GAMECONFIG_DIFF_H__
+
+#include <string>
+#include <vector>
+
+#include "libjson/json/value.h"
+#include "miner.pb.h"
+
+namespace dataminer {
+
+// A field that differs between two versions of an entity.
+struct FieldChange {
+  // Where the field is in the entity, e.g. "stats.health" or
+  // "recipe.ingredients[1].amount".
+  std::string path;
+  // The field's value in each version, or null where it isn't set.
+  Json::Value old_value;
+  Json::Value new_value;
+};
+
+// An entity that's in both versions, with the fields that differ.
+struct EntityChange {
+  std::string id;
+  std::vector<FieldChange> fields;
+};
+
+// How one kind of entity (units, NPCs, upgrades, ...) changed, keyed by id.
+struct SectionDiff {
+  std::string name;
+  std::vector<std::string> added;
+  std::vector<std::string> removed;
+  std::vector<EntityChange> changed;
+  int unchanged = 0;
+};
+
+struct GameConfigDiff {
+  std::string old_version;
+  std::string new_version;
+  std::vector<SectionDiff> sections;
+};
+
+// Diffs the units, MoWs, NPCs, abilities, upgrades, items, avatars, campaigns,
+// battles and achievements of two configs. Battles are keyed by
+// "<campaign>/<battle>". Everything else in the ClientGameConfig, such as the
+// MoW upgrade costs, is diffed as one "clientGameConfig" entity in a last
+// "other" section, with list elements keyed by index, e.g.
+// "units.mow_upgrade_costs[3].gold".
+// Each entity is serialized in both versions first, so the ones that didn't
+// change are skipped without walking their fields. Entities and fields are
+// listed in the order the configs hold them.
+//
+// Two derived fields are left out. Battle.enemy_refs holds NPC indices, which
+// shift whenever an NPC is added, and Battle.enemies already says the same
+// thing by id. Effective drop rates come from a simulation, so they can
+// differ between loads, and the chances they're simulated from are compared.
+GameConfigDiff DiffGameConfigs(const GameConfig& old_config,
+                               const GameConfig& new_config);
+
+// The diff as JSON, with one object per section.
+Json::Value GameConfigDiffToJson(const GameConfigDiff& diff);
+
+// The diff as text for people: a count line per section, then a line per
+// added (+), removed (-) and changed (~) entity, with one line per changed
+// field under the changed ones.
+std::string GameConfigDiffSummary(const GameConfigDiff& diff);
+
+}  // namespace dataminer
+
+#endif  // __GAMECONFIG_DIFF_H__
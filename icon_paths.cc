@@ -0,0 +1,57 @@
+#include "icon_paths.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace dataminer {
+
+namespace {
+
+// Portraits whose file name doesn't follow from the avatar ID.
+struct IconOverride {
+  absl::string_view unit_id;
+  absl::string_view file;
+};
+constexpr IconOverride kRoundIconOverrides[] = {
+    {"spaceStormcaller", "ui_image_RoundPortrait_space_stormcaller_01.png"},
+};
+
+std::string GetCharacterAsset(const absl::string_view file,
+                              const AssetManifest& manifest) {
+  manifest.Reference(absl::StrCat("characters/", file));
+  return absl::StrCat("snowprint_assets/characters/", file);
+}
+
+// The avatar ID appears to be <faction>_<lowername>_01, making the icon path
+// ui_image_portrait_<faction>_<lowername>_01.png. The _01 is because some units
+// appear multiple times with different color schemes (tyranids and TSons
+// horrors), but we can take the first one for our purpose.
+std::string GetAvatarId(const absl::string_view unit_id,
+                        const GameConfigIndex& index) {
+  const Avatars::Avatar* avatar = index.FindAvatar(unit_id);
+  return avatar == nullptr ? "" : avatar->id();
+}
+
+}  // namespace
+
+std::string GetIconPath(const absl::string_view unit_id,
+                        const GameConfigIndex& index,
+                        const AssetManifest& manifest) {
+  return GetCharacterAsset(
+      absl::StrCat("ui_image_portrait_", GetAvatarId(unit_id, index), ".png"),
+      manifest);
+}
+
+std::string GetRoundIconPath(const absl::string_view unit_id,
+                             const GameConfigIndex& index,
+                             const AssetManifest& manifest) {
+  for (const IconOverride& icon_override : kRoundIconOverrides) {
+    if (icon_override.unit_id == unit_id) {
+      return GetCharacterAsset(icon_override.file, manifest);
+    }
+  }
+  return GetCharacterAsset(absl::StrCat("ui_image_RoundPortrait_",
+                                        GetAvatarId(unit_id, index), ".png"),
+                           manifest);
+}
+
+}  // namespace dataminer
@@ -0,0 +1,27 @@
+#ifndef __ICON_PATHS_H__
+#define __ICON_PATHS_H__
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "asset_manifest.h"
+#include "game_config_index.h"
+
+namespace dataminer {
+
+// Returns the planner's path to the square portrait of the character or MoW
+// `unit_id`, e.g. "snowprint_assets/characters/ui_image_portrait_X.png".
+// The portrait is referenced in `manifest`, so a missing file shows up in
+// its report.
+std::string GetIconPath(absl::string_view unit_id,
+                        const GameConfigIndex& index,
+                        const AssetManifest& manifest);
+
+// Like GetIconPath, but for the round portrait.
+std::string GetRoundIconPath(absl::string_view unit_id,
+                             const GameConfigIndex& index,
+                             const AssetManifest& manifest);
+
+}  // namespace dataminer
+
+#endif  // __ICON_PATHS_H__
@@ -0,0 +1,119 @@
+#include "incremental_build.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "content_hash.h"
+#include "libjson/json/reader.h"
+#include "libjson/json/writer.h"
+#include "metrics.h"
+#include "output_writer.h"
+
+namespace dataminer {
+
+absl::flat_hash_map<std::string, std::string> HashMembers(
+    const Json::Value& object, const absl::string_view text) {
+  absl::flat_hash_map<std::string, std::string> hashes;
+  if (!object.isObject()) return hashes;
+  for (auto it = object.begin(); it != object.end(); ++it) {
+    const size_t start = static_cast<size_t>(it->getOffsetStart());
+    const size_t limit = static_cast<size_t>(it->getOffsetLimit());
+    hashes[it.name()] =
+        ContentHashString(text.substr(start, limit - start));
+  }
+  return hashes;
+}
+
+std::string HashFile(const absl::string_view path) {
+  std::ifstream in{std::string(path), std::ios::binary};
+  if (!in) return "missing";
+  const std::string contents{std::istreambuf_iterator<char>(in),
+                             std::istreambuf_iterator<char>()};
+  return ContentHashString(contents);
+}
+
+absl::StatusOr<std::string> InputHashes::Key(
+    const std::vector<absl::string_view>& inputs) const {
+  std::string all = absl::StrCat("version=", kBuildStateVersion, "\n");
+  for (const absl::string_view input : inputs) {
+    const auto it = hashes_.find(input);
+    if (it == hashes_.end()) {
+      return absl::InternalError(
+          absl::StrCat("No hash for the input '", input, "'."));
+    }
+    absl::StrAppend(&all, input, "=", it->second, "\n");
+  }
+  return ContentHashString(all);
+}
+
+absl::StatusOr<BuildState> BuildState::Load(const absl::string_view path) {
+  BuildState state;
+  std::ifstream in{std::string(path)};
+  if (!in) return state;
+  Json::Value root;
+  Json::Reader reader;
+  if (!reader.parse(in, root) || !root["outputs"].isObject()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Couldn't parse the build state in '", path,
+        "'; delete it to rebuild everything: ",
+        reader.getFormattedErrorMessages()));
+  }
+  const Json::Value& outputs = root["outputs"];
+  for (auto it = outputs.begin(); it != outputs.end(); ++it) {
+    Entry& entry = state.outputs_[it.name()];
+    entry.path = (*it)["path"].asString();
+    entry.key = (*it)["key"].asString();
+    for (const Json::Value& file : (*it)["files"]) {
+      entry.files.push_back(file.asString());
+    }
+  }
+  return state;
+}
+
+bool BuildState::IsFresh(const absl::string_view output,
+                         const absl::string_view path,
+                         const absl::string_view key) const {
+  const auto it = outputs_.find(output);
+  if (it == outputs_.end() || it->second.path != path ||
+      it->second.key != key || it->second.files.empty()) {
+    return false;
+  }
+  static Counter& stat_calls = Metrics::Get().GetCounter(
+      "miner_stat_calls_total", "stat() calls made to check outputs.");
+  for (const std::string& file : it->second.files) {
+    stat_calls.Increment();
+    std::error_code error;
+    if (!std::filesystem::exists(file, error)) return false;
+  }
+  return true;
+}
+
+void BuildState::Record(const absl::string_view output,
+                        const absl::string_view path,
+                        const absl::string_view key,
+                        std::vector<std::string> files) {
+  outputs_[output] = {std::string(path), std::string(key), std::move(files)};
+}
+
+absl::Status BuildState::Save(const absl::string_view path) const {
+  Json::Value root(Json::objectValue);
+  Json::Value& outputs = root["outputs"] = Json::Value(Json::objectValue);
+  for (const auto& [output, entry] : outputs_) {
+    Json::Value& json = outputs[output] = Json::Value(Json::objectValue);
+    json["path"] = entry.path;
+    json["key"] = entry.key;
+    Json::Value& files = json["files"] = Json::Value(Json::arrayValue);
+    for (const std::string& file : entry.files) files.append(file);
+  }
+  return WriteOutput(
+      path, Json::writeString(Json::StreamWriterBuilder(), root) + "\n");
+}
+
+}  // namespace dataminer
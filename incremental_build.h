@@ -0,0 +1,85 @@
+#ifndef __INCREMENTAL_BUILD_H__
+#define __INCREMENTAL_BUILD_H__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "libjson/json/value.h"
+
+namespace dataminer {
+
+// Part of every InputHashes::Key(), so that outputs built by an older miner
+// are stale. Bump it whenever an emitter's output changes for the same
+// inputs.
+inline constexpr int kBuildStateVersion = 1;
+
+// The ContentHashString of the raw text of each member of `object`, keyed by
+// member name. `object` must have been parsed from `text`, so that its
+// members' offsets point into it. Hashing the text instead of the parsed
+// value means nothing has to be parsed into messages, or written back out,
+// to tell whether a section changed.
+absl::flat_hash_map<std::string, std::string> HashMembers(
+    const Json::Value& object, absl::string_view text);
+
+// The ContentHashString of the file at `path`, or "missing" if it can't be
+// read.
+std::string HashFile(absl::string_view path);
+
+// Hashes of everything the outputs are built from, by name: the gameconfig's
+// sections, and other inputs such as the i18n strings or the drop rates.
+class InputHashes {
+ public:
+  void Set(absl::string_view name, std::string hash) {
+    hashes_[name] = std::move(hash);
+  }
+
+  // One hash over kBuildStateVersion and the named inputs, in the given
+  // order. Fails if one of them was never Set().
+  absl::StatusOr<std::string> Key(
+      const std::vector<absl::string_view>& inputs) const;
+
+ private:
+  absl::flat_hash_map<std::string, std::string> hashes_;
+};
+
+// What the miner last built: for each output, the path it was written to and
+// the Key() of the inputs it was built from. Kept in a small JSON file
+// between runs, so that the next run only rebuilds the outputs whose inputs
+// changed.
+class BuildState {
+ public:
+  // Reads the state saved at `path`. A missing file is an empty state, so
+  // the first run builds everything.
+  static absl::StatusOr<BuildState> Load(absl::string_view path);
+
+  // True if `output` was last built at `path` from inputs with `key`, and
+  // every file it was written to is still there.
+  bool IsFresh(absl::string_view output, absl::string_view path,
+               absl::string_view key) const;
+
+  // Records that `output` was just built at `path` from inputs with `key`,
+  // into `files`: `path` and any siblings, such as a gzipped copy.
+  void Record(absl::string_view output, absl::string_view path,
+              absl::string_view key, std::vector<std::string> files);
+
+  // Writes the state to `path`, with WriteOutput.
+  absl::Status Save(absl::string_view path) const;
+
+ private:
+  struct Entry {
+    std::string path;
+    std::string key;
+    std::vector<std::string> files;
+  };
+
+  absl::flat_hash_map<std::string, Entry> outputs_;
+};
+
+}  // namespace dataminer
+
+#endif  // __INCREMENTAL_BUILD_H__
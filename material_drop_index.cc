@@ -0,0 +1,83 @@
+#include "material_drop_index.h"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+#include "absl/container/flat_hash_map.h"
+#include "campaign_tables.h"
+
+namespace dataminer {
+
+std::vector<const Campaign*> MaterialDropIndex::Campaigns(
+    const Battles& battles) {
+  std::vector<const Campaign*> campaigns;
+  for (const google::protobuf::RepeatedPtrField<Campaign>* list :
+       {&battles.standard_campaigns(), &battles.mirror_campaigns(),
+        &battles.elite_campaigns(), &battles.mirror_elite_campaigns(),
+        &battles.campaign_events()}) {
+    for (const Campaign& campaign : *list) campaigns.push_back(&campaign);
+  }
+  return campaigns;
+}
+
+MaterialDropIndex MaterialDropIndex::Build(const Battles& battles,
+                                           const RecipeGraph& graph) {
+  MaterialDropIndex index;
+  index.graph_ = &graph;
+
+  std::vector<std::vector<Drop>> drops(graph.size());
+  for (const Campaign* campaign : Campaigns(battles)) {
+    for (const Campaign::Battle& battle : campaign->battles()) {
+      // A battle can drop the same material more than one way, so its
+      // rewards are added up per material first.
+      absl::flat_hash_map<int, double> rates;
+      const Campaign::Battle::Reward& reward = battle.reward();
+      for (const Campaign::Battle::GuaranteedRewardItem& item : reward.base()) {
+        const int material = graph.Find(item.id());
+        if (material < 0) continue;
+        rates[material] += (item.min() + item.max()) / 2.0;
+      }
+      if (reward.has_chance_of()) {
+        const int material = graph.Find(reward.chance_of().id());
+        if (material >= 0) {
+          rates[material] += reward.chance_of().effective_rate();
+        }
+      }
+      for (const auto& [material, rate] : rates) {
+        if (rate <= 0) continue;
+        drops[material].push_back({
+            .campaign = campaign,
+            .battle = &battle,
+            .battle_id = GetPlannerBattleId(campaign->id(), battle.id()),
+            .energy_cost = battle.energy_cost(),
+            .effective_rate = rate,
+            .energy_per_drop = battle.energy_cost() / rate,
+        });
+      }
+    }
+  }
+
+  index.offsets_.reserve(graph.size() + 1);
+  index.offsets_.push_back(0);
+  for (std::vector<Drop>& material_drops : drops) {
+    std::sort(material_drops.begin(), material_drops.end(),
+              [](const Drop& lhs, const Drop& rhs) {
+                return std::tie(lhs.energy_per_drop, lhs.battle_id) <
+                       std::tie(rhs.energy_per_drop, rhs.battle_id);
+              });
+    std::move(material_drops.begin(), material_drops.end(),
+              std::back_inserter(index.drops_));
+    index.offsets_.push_back(index.drops_.size());
+  }
+  return index;
+}
+
+absl::Span<const MaterialDropIndex::Drop> MaterialDropIndex::Drops(
+    const absl::string_view upgrade_id) const {
+  const int material = graph_->Find(upgrade_id);
+  if (material < 0) return {};
+  return Drops(material);
+}
+
+}  // namespace dataminer
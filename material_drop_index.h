@@ -0,0 +1,69 @@
+#ifndef __MATERIAL_DROP_INDEX_H__
+#define __MATERIAL_DROP_INDEX_H__
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "miner.pb.h"
+#include "recipe_graph.h"
+
+namespace dataminer {
+
+// For every upgrade material, the battles that drop it, cheapest first. This
+// answers "where do I farm X" with one lookup, instead of a scan over every
+// campaign node.
+//
+// Points into the Battles and RecipeGraph it was built from, which must
+// outlive it. It's immutable once built, so it can be shared between threads.
+class MaterialDropIndex {
+ public:
+  struct Drop {
+    const Campaign* campaign;
+    const Campaign::Battle* battle;
+    // The planner's name for the battle, e.g. "FoCE12".
+    std::string battle_id;
+    int energy_cost;
+    // How many of the material one raid yields on average: the mean of the
+    // guaranteed reward's range, plus the chanceOf reward's effective rate.
+    double effective_rate;
+    double energy_per_drop;
+  };
+
+  // Indexes the guaranteed and chanceOf rewards of every battle in
+  // `battles`. Rewards that aren't in `graph` (e.g. gold or XP) and rewards
+  // that never drop are left out.
+  static MaterialDropIndex Build(const Battles& battles,
+                                 const RecipeGraph& graph);
+
+  MaterialDropIndex(MaterialDropIndex&&) = default;
+  MaterialDropIndex& operator=(MaterialDropIndex&&) = default;
+
+  const RecipeGraph& graph() const { return *graph_; }
+
+  // The battles that drop `material`, sorted by energy per drop and then by
+  // battle ID. Empty if nothing drops it.
+  absl::Span<const Drop> Drops(int material) const {
+    return absl::MakeConstSpan(drops_.data() + offsets_[material],
+                               offsets_[material + 1] - offsets_[material]);
+  }
+  // Like above, by Snowprint ID.
+  absl::Span<const Drop> Drops(absl::string_view upgrade_id) const;
+
+  // Every campaign in `battles`, in the order the planner's campaign data
+  // lists them.
+  static std::vector<const Campaign*> Campaigns(const Battles& battles);
+
+ private:
+  MaterialDropIndex() = default;
+
+  const RecipeGraph* graph_ = nullptr;
+  // Drops(m) is drops_[offsets_[m], offsets_[m + 1]).
+  std::vector<int> offsets_;
+  std::vector<Drop> drops_;
+};
+
+}  // namespace dataminer
+
+#endif  // __MATERIAL_DROP_INDEX_H__
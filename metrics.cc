@@ -0,0 +1,329 @@
+#include "metrics.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+
+namespace dataminer {
+
+namespace metrics_internal {
+thread_local AllocationCounts allocation_counts = {0, 0};
+}  // namespace metrics_internal
+
+namespace {
+
+// The innermost AllocationScope open on this thread.
+thread_local const AllocationScope* current_scope = nullptr;
+
+// Escapes `text` for the Prometheus text format, where a backslash and a
+// newline are escaped in HELP lines and label values, and a double quote in
+// label values too.
+std::string EscapePrometheus(const absl::string_view text,
+                             const bool quoted) {
+  std::string out;
+  out.reserve(text.size());
+  for (const char c : text) {
+    if (c == '\\') {
+      out += "\\\\";
+    } else if (c == '\n') {
+      out += "\\n";
+    } else if (c == '"' && quoted) {
+      out += "\\\"";
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+// Returns `text` as a quoted JSON string.
+std::string QuoteJson(const absl::string_view text) {
+  std::string out = "\"";
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppendFormat(&out, "\\u%04x", c);
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+  return out;
+}
+
+// Renders `labels` as Prometheus does, e.g. {section="units"}, or as nothing
+// if there are none.
+std::string RenderLabels(const Metrics::Labels& labels) {
+  if (labels.empty()) return "";
+  return absl::StrCat(
+      "{",
+      absl::StrJoin(labels, ",",
+                    [](std::string* out,
+                       const std::pair<std::string, std::string>& label) {
+                      absl::StrAppend(out, label.first, "=\"",
+                                      EscapePrometheus(label.second, true),
+                                      "\"");
+                    }),
+      "}");
+}
+
+// Like RenderLabels, with one more label added at the end.
+std::string RenderLabelsWith(Metrics::Labels labels, std::string name,
+                             std::string value) {
+  labels.emplace_back(std::move(name), std::move(value));
+  return RenderLabels(labels);
+}
+
+std::string JsonLabels(const Metrics::Labels& labels) {
+  return absl::StrCat(
+      "{",
+      absl::StrJoin(labels, ", ",
+                    [](std::string* out,
+                       const std::pair<std::string, std::string>& label) {
+                      absl::StrAppend(out, QuoteJson(label.first), ": ",
+                                      QuoteJson(label.second));
+                    }),
+      "}");
+}
+
+}  // namespace
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)),
+      buckets_(new std::atomic<int64_t>[bounds_.size() + 1]) {
+  for (size_t i = 0; i <= bounds_.size(); ++i) buckets_[i] = 0;
+}
+
+void Histogram::Observe(const double value) {
+  const size_t bucket =
+      std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  double sum = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(sum, sum + value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+std::vector<int64_t> Histogram::BucketCounts() const {
+  std::vector<int64_t> counts(bounds_.size() + 1);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+int64_t Histogram::count() const {
+  int64_t count = 0;
+  for (const int64_t bucket : BucketCounts()) count += bucket;
+  return count;
+}
+
+double Histogram::sum() const { return sum_.load(std::memory_order_relaxed); }
+
+std::vector<double> ExponentialBuckets(double start, const double factor,
+                                       const int count) {
+  std::vector<double> bounds;
+  bounds.reserve(count);
+  for (int i = 0; i < count; ++i, start *= factor) bounds.push_back(start);
+  return bounds;
+}
+
+Metrics& Metrics::Get() {
+  static Metrics* const metrics = new Metrics();
+  return *metrics;
+}
+
+Metrics::Series& Metrics::GetSeries(const absl::string_view name,
+                                    const absl::string_view help,
+                                    const Type type, const Labels& labels) {
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_
+             .emplace(std::string(name), Family{type, std::string(help), {}})
+             .first;
+  }
+  Series& series = it->second.series[RenderLabels(labels)];
+  if (series.labels.empty()) series.labels = labels;
+  return series;
+}
+
+Counter& Metrics::GetCounter(const absl::string_view name,
+                             const absl::string_view help,
+                             const Labels& labels) {
+  absl::MutexLock lock(&mu_);
+  Series& series = GetSeries(name, help, Type::kCounter, labels);
+  if (series.counter == nullptr) series.counter = std::make_unique<Counter>();
+  return *series.counter;
+}
+
+Gauge& Metrics::GetGauge(const absl::string_view name,
+                         const absl::string_view help, const Labels& labels) {
+  absl::MutexLock lock(&mu_);
+  Series& series = GetSeries(name, help, Type::kGauge, labels);
+  if (series.gauge == nullptr) series.gauge = std::make_unique<Gauge>();
+  return *series.gauge;
+}
+
+Histogram& Metrics::GetHistogram(const absl::string_view name,
+                                 const absl::string_view help,
+                                 const std::vector<double>& bounds,
+                                 const Labels& labels) {
+  absl::MutexLock lock(&mu_);
+  Series& series = GetSeries(name, help, Type::kHistogram, labels);
+  if (series.histogram == nullptr) {
+    series.histogram = std::make_unique<Histogram>(bounds);
+  }
+  return *series.histogram;
+}
+
+void Metrics::Sample() {
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // Linux reports the peak RSS in kilobytes.
+    GetGauge("miner_peak_rss_bytes", "The most memory the run had resident.")
+        .Set(int64_t{usage.ru_maxrss} * 1024);
+  }
+}
+
+std::string Metrics::ToPrometheus() const {
+  absl::MutexLock lock(&mu_);
+  std::string out;
+  for (const auto& [name, family] : families_) {
+    absl::StrAppend(&out, "# HELP ", name, " ",
+                    EscapePrometheus(family.help, false), "\n", "# TYPE ",
+                    name, " ",
+                    family.type == Type::kCounter   ? "counter"
+                    : family.type == Type::kGauge   ? "gauge"
+                                                    : "histogram",
+                    "\n");
+    for (const auto& [labels, series] : family.series) {
+      switch (family.type) {
+        case Type::kCounter:
+          absl::StrAppend(&out, name, labels, " ", series.counter->value(),
+                          "\n");
+          break;
+        case Type::kGauge:
+          absl::StrAppend(&out, name, labels, " ", series.gauge->value(),
+                          "\n");
+          break;
+        case Type::kHistogram: {
+          const Histogram& histogram = *series.histogram;
+          const std::vector<int64_t> counts = histogram.BucketCounts();
+          int64_t cumulative = 0;
+          for (size_t i = 0; i < counts.size(); ++i) {
+            cumulative += counts[i];
+            const std::string bound =
+                i < histogram.bounds().size()
+                    ? absl::StrFormat("%.15g", histogram.bounds()[i])
+                    : "+Inf";
+            absl::StrAppend(&out, name, "_bucket",
+                            RenderLabelsWith(series.labels, "le", bound), " ",
+                            cumulative, "\n");
+          }
+          absl::StrAppend(&out, name, "_sum", labels, " ",
+                          absl::StrFormat("%.15g", histogram.sum()), "\n");
+          absl::StrAppend(&out, name, "_count", labels, " ", cumulative, "\n");
+          break;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+std::string Metrics::ToJson() const {
+  absl::MutexLock lock(&mu_);
+  std::string out = "{";
+  bool first_family = true;
+  for (const auto& [name, family] : families_) {
+    absl::StrAppend(&out, first_family ? "\n" : ",\n", "  ", QuoteJson(name),
+                    ": [");
+    first_family = false;
+    bool first_series = true;
+    for (const auto& [labels, series] : family.series) {
+      absl::StrAppend(&out, first_series ? "\n" : ",\n",
+                      "    {\"labels\": ", JsonLabels(series.labels));
+      first_series = false;
+      switch (family.type) {
+        case Type::kCounter:
+          absl::StrAppend(&out, ", \"value\": ", series.counter->value());
+          break;
+        case Type::kGauge:
+          absl::StrAppend(&out, ", \"value\": ", series.gauge->value());
+          break;
+        case Type::kHistogram: {
+          const Histogram& histogram = *series.histogram;
+          absl::StrAppend(
+              &out, ", \"bounds\": [",
+              absl::StrJoin(histogram.bounds(), ", ",
+                            [](std::string* out, const double bound) {
+                              absl::StrAppendFormat(out, "%.15g", bound);
+                            }),
+              "], \"buckets\": [",
+              absl::StrJoin(histogram.BucketCounts(), ", "),
+              "], \"count\": ", histogram.count(), ", \"sum\": ",
+              absl::StrFormat("%.15g", histogram.sum()));
+          break;
+        }
+      }
+      absl::StrAppend(&out, "}");
+    }
+    absl::StrAppend(&out, "\n  ]");
+  }
+  absl::StrAppend(&out, "\n}\n");
+  return out;
+}
+
+absl::StatusOr<std::string> DumpMetrics(const absl::string_view format) {
+  Metrics& metrics = Metrics::Get();
+  metrics.Sample();
+  if (format == "prometheus") return metrics.ToPrometheus();
+  if (format == "json") return metrics.ToJson();
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown metrics format: '", format, "'."));
+}
+
+AllocationScope::AllocationScope(const absl::string_view stage)
+    : AllocationScope(
+          Metrics::Get().GetCounter("miner_allocations_total",
+                                    "Allocations made by each stage.",
+                                    {{"stage", std::string(stage)}}),
+          Metrics::Get().GetCounter("miner_allocated_bytes_total",
+                                    "Bytes allocated by each stage.",
+                                    {{"stage", std::string(stage)}})) {}
+
+AllocationScope::AllocationScope(Counter& allocations, Counter& bytes)
+    : allocations_(allocations),
+      bytes_(bytes),
+      start_(metrics_internal::allocation_counts),
+      outer_(current_scope) {
+  current_scope = this;
+}
+
+AllocationScope::~AllocationScope() {
+  const AllocationCounts& now = metrics_internal::allocation_counts;
+  allocations_.Increment(now.allocations - start_.allocations);
+  bytes_.Increment(now.bytes - start_.bytes);
+  current_scope = outer_;
+}
+
+std::function<void()> AllocationScope::Carry(std::function<void()> fn) {
+  if (current_scope == nullptr) return fn;
+  // The counters live forever, unlike the scope.
+  Counter* const allocations = &current_scope->allocations_;
+  Counter* const bytes = &current_scope->bytes_;
+  return [allocations, bytes, fn = std::move(fn)] {
+    AllocationScope scope(*allocations, *bytes);
+    fn();
+  };
+}
+
+}  // namespace dataminer
@@ -0,0 +1,179 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace dataminer {
+
+// Counters, gauges and histograms that a run accumulates and dumps at exit,
+// so unattended runs can be compared between gameconfig versions for
+// slowdowns and data growth without a profiler.
+//
+// Metrics are created on first use and live forever, so hot call sites can
+// look one up once and keep the reference:
+//
+//   static Counter& hits = Metrics::Get().GetCounter(
+//       "miner_drop_rate_cache_hits_total", "Drop rates found in the cache.");
+//   hits.Increment();
+//
+// Updating a metric is one relaxed atomic add. Everything is safe to use from
+// multiple threads.
+class Counter {
+ public:
+  void Increment(const int64_t by = 1) {
+    value_.fetch_add(by, std::memory_order_relaxed);
+  }
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+class Gauge {
+ public:
+  void Set(const int64_t value) {
+    value_.store(value, std::memory_order_relaxed);
+  }
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+// Counts observations into buckets with fixed upper bounds, like a
+// Prometheus histogram.
+class Histogram {
+ public:
+  // `bounds` are the buckets' inclusive upper bounds, ascending. There's an
+  // implicit last bucket for everything above them.
+  explicit Histogram(std::vector<double> bounds);
+
+  void Observe(double value);
+
+  const std::vector<double>& bounds() const { return bounds_; }
+  // The number of observations in each bucket, not cumulative, with the
+  // overflow bucket last.
+  std::vector<int64_t> BucketCounts() const;
+  int64_t count() const;
+  double sum() const;
+
+ private:
+  const std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<int64_t>[]> buckets_;
+  std::atomic<double> sum_{0};
+};
+
+// Buckets that grow by `factor`, starting at `start`, e.g. for sizes.
+std::vector<double> ExponentialBuckets(double start, double factor, int count);
+
+class Metrics {
+ public:
+  // Label names and values, e.g. {{"section", "units"}}.
+  using Labels = std::vector<std::pair<std::string, std::string>>;
+
+  static Metrics& Get();
+
+  // Each Get* returns the metric called `name` with `labels`, creating it if
+  // it doesn't exist yet. `help` describes the metric, and only the first
+  // call's is kept.
+  Counter& GetCounter(absl::string_view name, absl::string_view help,
+                      const Labels& labels = {});
+  Gauge& GetGauge(absl::string_view name, absl::string_view help,
+                  const Labels& labels = {});
+  // `bounds` are only used when the histogram is created.
+  Histogram& GetHistogram(absl::string_view name, absl::string_view help,
+                          const std::vector<double>& bounds,
+                          const Labels& labels = {});
+
+  // Sets the gauges that are sampled rather than updated, like peak RSS.
+  void Sample();
+
+  // Renders every metric in the Prometheus text exposition format, for the
+  // node exporter's textfile collector.
+  std::string ToPrometheus() const;
+  // Renders every metric as a JSON object keyed by metric name.
+  std::string ToJson() const;
+
+ private:
+  enum class Type { kCounter, kGauge, kHistogram };
+
+  struct Series {
+    Labels labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+  };
+
+  struct Family {
+    Type type;
+    std::string help;
+    // Keyed by the rendered labels, so the output is sorted and stable.
+    std::map<std::string, Series> series;
+  };
+
+  Metrics() = default;
+
+  Series& GetSeries(absl::string_view name, absl::string_view help, Type type,
+                    const Labels& labels) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable absl::Mutex mu_;
+  std::map<std::string, Family, std::less<>> families_ ABSL_GUARDED_BY(mu_);
+};
+
+// Samples the metrics and returns them formatted as "prometheus" or "json".
+absl::StatusOr<std::string> DumpMetrics(absl::string_view format);
+
+// How many allocations, and how many bytes, the current thread has made
+// through operator new. These stay zero unless :counting_allocator is linked
+// in.
+struct AllocationCounts {
+  int64_t allocations;
+  int64_t bytes;
+};
+
+namespace metrics_internal {
+extern thread_local AllocationCounts allocation_counts;
+}  // namespace metrics_internal
+
+// Adds the allocations this thread makes during the scope's lifetime to
+// miner_allocations_total and miner_allocated_bytes_total, labeled with
+// `stage`. Work the scope hands to a ThreadPool is counted too, through
+// Carry(), but work handed to other threads isn't.
+class AllocationScope {
+ public:
+  explicit AllocationScope(absl::string_view stage);
+  ~AllocationScope();
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+
+  // Wraps `fn` so that, on whichever thread it runs, its allocations count
+  // towards the innermost scope open on this thread, if there is one.
+  static std::function<void()> Carry(std::function<void()> fn);
+
+ private:
+  AllocationScope(Counter& allocations, Counter& bytes);
+
+  Counter& allocations_;
+  Counter& bytes_;
+  const AllocationCounts start_;
+  // The scope this one is nested in on this thread, if any.
+  const AllocationScope* const outer_;
+};
+
+}  // namespace dataminer
+
+#endif  // __METRICS_H__
@@ -37,13 +37,80 @@
 // want to calculate effective rates for a different amount, you can change the
 // numver of sims per chanceOf with --effective_rate_simulation_runs.
 //
+// For distribution, --output_format=compact strips the indentation from the
+// JSON outputs, and --gzip_outputs writes a precompressed .gz next to each of
+// them.
+//
+// The emitters check icon paths against one scan of assets/ made at startup.
+// Missing icons, and portraits no character or MoW uses, are logged together
+// at the end. --asset_manifest writes the size and content hash of every
+// asset, which is handy for diffing assets between game versions. If assets/
+// can't be scanned, every icon is reported missing and --asset_manifest is
+// skipped.
+//
+// --binary_data=$MINING_OUTPUT/newPlannerData.bin writes the same data as one
+// binary file that can be memory-mapped and read in place, without parsing;
+// see binary_data_format.h. :binary_data_validator checks such a file.
+//
+// --cost_data=$MINING_OUTPUT/newCostData.json writes cost tables the planner
+// can answer questions from without adding up per-level costs: the total gold
+// to craft each upgrade, and running totals over item and MoW ability levels.
+//
+// --material_drop_data=$MINING_OUTPUT/newMaterialDropData.json lists, for every
+// upgrade material, the nodes that drop it sorted by expected energy per drop,
+// so the planner can find where to farm something without scanning every
+// battle.
+//
+// --query_rank_up=ultramarinesTitus:STONE_1:GOLD_1 skips the outputs and
+// prints the base materials it takes to rank a unit up between two ranks. It
+// takes a comma-separated list, and also prints the total, so you can price a
+// whole roster in one go.
+//
+// --batch_queries=queries.jsonl answers a file of JSON queries, one per line,
+// such as rank-up ranges, farming plans and craftability checks, and writes
+// one JSON response per line to stdout, in the same order. The GameConfig is
+// parsed once and the queries are answered in parallel, so this is the way to
+// run analytics over many rosters. See query_handler.h for the queries.
+//
+// --trace_out=/tmp/miner_trace.json records how long reading the JSON, each
+// Parse* section, the i18n amendment, the drop-rate simulations and each
+// Create*Data took, on which thread, and writes it as a trace you can open in
+// chrome://tracing or ui.perfetto.dev.
+//
+// --metrics_out=/var/lib/node_exporter/miner.prom writes counters for the run
+// when it exits: entities parsed per gameconfig section, allocations and bytes
+// allocated per stage, drop-rate cache hits and misses, stat() calls, the
+// bytes written to each output, and peak RSS. Comparing them between
+// gameconfig versions catches slowdowns and data growth without a profiler.
+// --metrics_format=json writes them as JSON instead.
+//
+// Outputs whose contents haven't changed since the last run are left alone,
+// so their mtimes only move when the data does. The miner logs a summary of
+// which outputs actually changed.
+//
+// --incremental_state=$MINING_OUTPUT/miner_state.json goes further and skips
+// building outputs whose inputs haven't changed. The miner hashes the raw text
+// of each gameconfig section, the i18n file, the drop-rate config and the
+// list of assets, and the state file records which of those hashes each
+// output was last built from; see the inputs in Main(). Only the stale
+// outputs are rebuilt, and only the sections they need are parsed, so a patch
+// that only touches equipment only rebuilds the outputs that read items. The
+// state can't see changes to the miner itself, so bump kBuildStateVersion in
+// incremental_build.h when you change what an emitter writes.
+//
 // When you're done, you just need to copy the new files into the planner
 // directory, overwriting the previous files (don't worry, we use version
 // control for a reason).
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/log/log.h"
@@ -51,21 +118,34 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "asset_manifest.h"
+#include "batch_queries.h"
+#include "calculate_effective_drop_rate.h"
+#include "create_binary_data.h"
 #include "create_campaign_data.h"
 #include "create_character_data.h"
+#include "create_cost_data.h"
 #include "create_equipment_data.h"
+#include "create_material_drop_data.h"
 #include "create_mow_data.h"
 #include "create_rank_up_data.h"
 #include "create_recipe_data.h"
-#include "libjson/json/reader.h"
+#include "game_config_index.h"
+#include "game_config_loader.h"
+#include "incremental_build.h"
 #include "libjson/json/value.h"
+#include "metrics.h"
 #include "miner.pb.h"
-#include "parse_avatars.h"
-#include "parse_campaigns.h"
-#include "parse_items.h"
-#include "parse_units.h"
-#include "parse_upgrades.h"
+#include "miner_snapshot.h"
+#include "output_writer.h"
+#include "rank_up_csv.h"
+#include "rank_up_query.h"
+#include "recipe_graph.h"
 #include "status_macros.h"
+#include "thread_pool.h"
+#include "trace.h"
 
 ABSL_FLAG(std::string, game_config, "", "The GameConfig.json file to parse");
 ABSL_FLAG(std::string, i18n_strings_json, "",
@@ -85,354 +165,467 @@ ABSL_FLAG(std::string, mow_data, "",
           "If not empty, writes all mow data to the specified file.");
 ABSL_FLAG(std::string, equipment_data, "",
           "If not empty, writes all equipment data to the specified file.");
+ABSL_FLAG(std::string, cost_data, "",
+          "If not empty, writes the cumulative crafting, item-level and MoW "
+          "ability costs to the specified file.");
+ABSL_FLAG(std::string, material_drop_data, "",
+          "If not empty, writes the battles that drop each upgrade material, "
+          "cheapest first, to the specified file.");
+ABSL_FLAG(std::string, assets_dir, "assets",
+          "The directory holding the extracted game assets, which the "
+          "emitters check their icon paths against.");
+ABSL_FLAG(std::string, asset_manifest, "",
+          "If not empty, writes the path, size and content hash of every "
+          "asset to the specified file.");
+ABSL_FLAG(std::string, binary_data, "",
+          "If not empty, writes the planner data as a single memory-mappable "
+          "binary file to the specified path.");
+ABSL_FLAG(std::vector<std::string>, query_rank_up, {},
+          "If not empty, prints the base materials for each "
+          "<unit>:<from rank>:<to rank> in the list, e.g. "
+          "ultramarinesTitus:STONE_1:GOLD_1, and their total, instead of "
+          "writing any files.");
+ABSL_FLAG(std::string, batch_queries, "",
+          "If not empty, answers the JSON queries, one per line, in the "
+          "specified file (- for stdin) and writes the responses to stdout, "
+          "instead of writing the outputs. See query_handler.h.");
+ABSL_FLAG(int, batch_threads, 0,
+          "The number of threads to answer --batch_queries on. 0 picks a "
+          "default from the number of cores.");
+ABSL_FLAG(std::string, trace_out, "",
+          "If not empty, writes how long each stage of the run took to the "
+          "specified file, as Chrome trace-event JSON.");
+ABSL_FLAG(std::string, metrics_out, "",
+          "If not empty, writes the run's metrics to the specified file when "
+          "it exits.");
+ABSL_FLAG(std::string, metrics_format, "prometheus",
+          "How to write --metrics_out: 'prometheus' for the node exporter's "
+          "textfile collector, or 'json'.");
+ABSL_FLAG(std::string, incremental_state, "",
+          "If not empty, the file that records what each output was built "
+          "from, so that outputs whose inputs haven't changed since the last "
+          "run are skipped.");
 
 namespace dataminer {
 namespace {
 
-absl::StatusOr<std::vector<Achievement::Milestone>> ParseMilestones(
-    const Json::Value& milestones) {
-  std::vector<Achievement::Milestone> result;
-  if (!milestones.isArray()) {
-    return absl::InvalidArgumentError("Milestones must be an array.");
-  }
-  for (const Json::Value& milestone : milestones) {
-    if (!milestone.isObject()) {
-      return absl::InvalidArgumentError("Each milestone must be an object.");
-    }
-    Achievement::Milestone m;
-    if (milestone.isMember("goal")) {
-      m.set_goal(milestone.get("goal", {}).asInt());
-    }
-    if (milestone.isMember("reward")) {
-      m.set_reward(milestone.get("reward", {}).asString());
-    }
-    result.push_back(std::move(m));
+// Parses a --query_rank_up entry.
+absl::StatusOr<RankUpQuery::Request> ParseRankUpRequest(
+    const absl::string_view spec) {
+  const std::vector<absl::string_view> parts = absl::StrSplit(spec, ':');
+  Rank::Enum from;
+  Rank::Enum to;
+  if (parts.size() != 3 || !Rank::Enum_Parse(std::string(parts[1]), &from) ||
+      !Rank::Enum_Parse(std::string(parts[2]), &to)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected <unit>:<from rank>:<to rank>, got '", spec, "'."));
   }
-  return result;
+  return RankUpQuery::Request{parts[0], from, to};
 }
 
-absl::StatusOr<std::vector<Achievement>> ParseAchievements(
-    const Json::Value& achievements) {
-  std::vector<Achievement> result;
-  if (!achievements.isArray()) {
-    return absl::InvalidArgumentError("Achievements must be an array.");
-  }
-  for (const Json::Value& achievement : achievements) {
-    if (!achievement.isObject()) {
-      return absl::InvalidArgumentError("Each achievement must be an object.");
-    }
-    Achievement a;
-    if (!achievement.isMember("achievementId")) {
-      return absl::InvalidArgumentError(
-          "Each achievement must have an 'achievementId' field.");
-    }
-    a.set_id(achievement.get("achievementId", "").asString());
-    if (!achievement.isMember("taskId")) {
-      return absl::InvalidArgumentError(
-          "Each achievement must have a 'taskId' field.");
-    }
-    a.set_task_id(achievement.get("taskId", "").asString());
-    if (achievement.isMember("milestones")) {
-      auto milestones = ParseMilestones(achievement["milestones"]);
-      if (!milestones.ok()) {
-        return absl::InvalidArgumentError(absl::StrCat(
-            "Error parsing milestones: ", milestones.status().message()));
-      }
-      for (Achievement::Milestone& milestone : *milestones) {
-        *a.add_milestones() = std::move(milestone);
-      }
-    }
-    result.push_back(std::move(a));
+void PrintMaterials(const absl::string_view label, const RecipeGraph& graph,
+                    const RecipeGraph::Materials& mats) {
+  for (const RecipeGraph::MaterialCount& mat : mats) {
+    const Upgrades::Upgrade& upgrade = graph.upgrade(mat.material);
+    std::cout << label << "," << mat.count << "," << upgrade.id() << ","
+              << upgrade.rarity() << "\n";
   }
-  return result;
 }
 
-absl::StatusOr<ClientGameConfig> ParseClientGameConfig(
-    const Json::Value& root) {
-  std::vector<ClientGameConfig> config;
-  if (!root.isObject()) {
-    return absl::InvalidArgumentError("Parsed JSON is not an object.");
-  }
-  if (!root.isMember("achievements")) {
-    return absl::InvalidArgumentError("Missing 'achievements' in JSON.");
-  }
-  auto achievements = ParseAchievements(root.get("achievements", {}));
-  if (!achievements.ok()) {
-    return absl::InvalidArgumentError(absl::StrCat(
-        "Error parsing achievements: ", achievements.status().message()));
-  }
+// Prints the materials for every --query_rank_up entry as CSV, followed by
+// their total when there's more than one.
+absl::Status AnswerRankUpQueries(const std::vector<std::string>& specs,
+                                 const GameConfigIndex& index) {
+  const ClientGameConfig& client_config = index.config().client_game_config();
+  absl::StatusOr<RecipeGraph> graph =
+      RecipeGraph::Build(client_config.upgrades());
+  if (!graph.ok()) return graph.status();
+  const RankUpQuery query = RankUpQuery::Build(client_config.units(), *graph);
+
+  std::vector<RankUpQuery::Request> requests;
+  for (const std::string& spec : specs) {
+    RankUpQuery::Request request;
+    ASSIGN_OR_RETURN(request, ParseRankUpRequest(spec));
+    requests.push_back(request);
+  }
+  std::cout << "query,quantity,upgrade_material,rarity\n";
+  for (size_t i = 0; i < requests.size(); ++i) {
+    RecipeGraph::Materials mats;
+    ASSIGN_OR_RETURN(mats, query.Query(requests[i].unit_id, requests[i].from,
+                                       requests[i].to));
+    PrintMaterials(specs[i], *graph, mats);
+  }
+  if (requests.size() > 1) {
+    RecipeGraph::Materials total;
+    ASSIGN_OR_RETURN(total, query.QueryBatch(requests));
+    PrintMaterials("total", *graph, total);
+  }
+  return absl::OkStatus();
+}
 
-  ClientGameConfig client_config;
-  for (const Achievement& achievement : *achievements) {
-    *client_config.add_achievements() = std::move(achievement);
+// Answers the --batch_queries in `path`, or on stdin if it's "-".
+absl::Status AnswerBatchQueries(const std::string& path,
+                                ArenaGameConfig config) {
+  TRACE_SCOPE("AnswerBatchQueries");
+  std::unique_ptr<const MinerSnapshot> snapshot;
+  ASSIGN_OR_RETURN(snapshot, MinerSnapshot::Create(std::move(config)));
+  std::ifstream file;
+  if (path != "-") {
+    file.open(path);
+    if (!file) {
+      return absl::NotFoundError(absl::StrCat("Can't open '", path, "'."));
+    }
   }
+  int threads = absl::GetFlag(FLAGS_batch_threads);
+  if (threads <= 0) threads = ThreadPool::DefaultThreadCount();
+  const absl::Time start = absl::Now();
+  int64_t answered;
+  ASSIGN_OR_RETURN(answered,
+                   RunBatchQueries(*snapshot, path == "-" ? std::cin : file,
+                                   std::cout, threads));
+  LOG(INFO) << "Answered " << answered << " queries in "
+            << absl::Now() - start << ".";
+  return absl::OkStatus();
+}
 
-  absl::StatusOr<Upgrades> upgrades = ParseUpgrades(root.get("upgrades", {}));
-  if (!upgrades.ok()) {
-    return absl::InvalidArgumentError(
-        absl::StrCat("Error parsing upgrades: ", upgrades.status().message()));
-  }
-  *client_config.mutable_upgrades() = std::move(*upgrades);
+// An output file the miner knows how to produce. Every generator only reads
+// the GameConfig and its index, so they can all run at the same time.
+struct Generator {
+  absl::string_view name;
+  std::string path;
+  // What the output is built from, for --incremental_state: the
+  // clientGameConfig sections it reads, and "i18n", "drop_rates" or "assets"
+  // if it uses those. An output with no inputs is always rebuilt.
+  std::vector<absl::string_view> inputs;
+  std::function<absl::Status(absl::string_view, const GameConfigIndex&)>
+      create;
+};
 
-  absl::StatusOr<Units> units = ParseUnits(root.get("units", {}));
-  if (!units.ok()) {
-    return absl::InvalidArgumentError(
-        absl::StrCat("Error parsing units: ", units.status().message()));
+// Runs every generator that has an output path in parallel, leaving each
+// one's status in `statuses`, and returns an error describing every generator
+// that failed, if any.
+absl::Status RunGenerators(const std::vector<Generator>& generators,
+                           const GameConfigIndex& index,
+                           std::vector<absl::Status>& statuses) {
+  TRACE_SCOPE("RunGenerators");
+  statuses.assign(generators.size(), absl::OkStatus());
+  {
+    ThreadPool pool(std::min<int>(generators.size(),
+                                  ThreadPool::DefaultThreadCount()));
+    for (size_t i = 0; i < generators.size(); ++i) {
+      const Generator& generator = generators[i];
+      if (generator.path.empty()) continue;
+      LOG(INFO) << "Writing " << generator.name << " to: " << generator.path;
+      pool.Schedule([&generator, &index, &status = statuses[i]] {
+        AllocationScope allocations(generator.name);
+        status = generator.create(generator.path, index);
+      });
+    }
   }
-  *client_config.mutable_units() = std::move(*units);
-
-  absl::StatusOr<Avatars> avatars = ParseAvatars(root.get("avatars", {}));
-  if (!avatars.ok()) {
-    return absl::InvalidArgumentError(
-        absl::StrCat("Error parsing avatars: ", avatars.status().message()));
+  std::vector<std::string> errors;
+  for (size_t i = 0; i < generators.size(); ++i) {
+    if (statuses[i].ok()) continue;
+    errors.push_back(
+        absl::StrCat(generators[i].name, ": ", statuses[i].message()));
   }
-  *client_config.mutable_avatars() = std::move(*avatars);
+  if (errors.empty()) return absl::OkStatus();
+  return absl::InternalError(absl::StrCat(
+      errors.size(), " generator(s) failed: ", absl::StrJoin(errors, "; ")));
+}
 
-  ASSIGN_OR_RETURN(*client_config.mutable_battles(),
-                   ParseCampaigns(root.get("battles", {})));
+// The gameconfig sections Generator::inputs can name.
+constexpr absl::string_view kSections[] = {"upgrades", "units", "avatars",
+                                           "battles", "items"};
+
+// Simulating new drop rates adds them to the drop-rate config, so this is
+// hashed again once the outputs are built.
+void HashDropRates(InputHashes& hashes) {
+  const DropRateSource source = GetDropRateSource();
+  hashes.Set("drop_rates",
+             absl::StrCat(source.simulation_runs, ":",
+                          source.config_path.empty()
+                              ? "none"
+                              : HashFile(source.config_path)));
+}
 
-  ASSIGN_OR_RETURN(*client_config.mutable_items(),
-                   ParseItems(root.get("items", {})));
+// Hashes everything Generator::inputs can name, plus the output options,
+// which every output depends on. `root` must have been read from `text`.
+InputHashes HashInputs(const Json::Value& root, const absl::string_view text,
+                       const AssetManifest& assets) {
+  TRACE_SCOPE("HashInputs");
+  InputHashes hashes;
+  const absl::flat_hash_map<std::string, std::string> sections =
+      HashMembers(root["clientGameConfig"], text);
+  for (const absl::string_view section : kSections) {
+    const auto it = sections.find(section);
+    hashes.Set(section, it == sections.end() ? "missing" : it->second);
+  }
+  const std::string i18n = absl::GetFlag(FLAGS_i18n_strings_json);
+  hashes.Set("i18n", i18n.empty() ? "none" : HashFile(i18n));
+  HashDropRates(hashes);
+  hashes.Set("assets", assets.PathsHash());
+  hashes.Set("options", OutputOptions());
+  return hashes;
+}
 
-  return client_config;
+absl::StatusOr<std::string> GeneratorKey(const Generator& generator,
+                                         const InputHashes& hashes) {
+  std::vector<absl::string_view> inputs = generator.inputs;
+  inputs.push_back("options");
+  return hashes.Key(inputs);
 }
 
-absl::StatusOr<GameConfig> ParseGameConfig(Json::Value& root) {
-  GameConfig config;
-  auto client_config = ParseClientGameConfig(root["clientGameConfig"]);
-  if (!client_config.ok()) {
-    return absl::InvalidArgumentError(absl::StrCat(
-        "Error parsing ClientGameConfig: ", client_config.status().message()));
+// Clears the path of every generator whose output is up to date, so that
+// RunGenerators skips it.
+absl::Status SkipFreshOutputs(const BuildState& state,
+                              const InputHashes& hashes,
+                              std::vector<Generator>& generators) {
+  std::vector<absl::string_view> fresh;
+  for (Generator& generator : generators) {
+    if (generator.path.empty() || generator.inputs.empty()) continue;
+    std::string key;
+    ASSIGN_OR_RETURN(key, GeneratorKey(generator, hashes));
+    if (state.IsFresh(generator.name, generator.path, key)) {
+      fresh.push_back(generator.name);
+      generator.path.clear();
+    }
   }
-  *config.mutable_client_game_config() = std::move(*client_config);
-  if (!root.isObject()) {
-    return absl::InvalidArgumentError("Parsed JSON is not an object.");
+  if (!fresh.empty()) {
+    LOG(INFO) << "Skipping " << fresh.size() << " up-to-date output(s): "
+              << absl::StrJoin(fresh, ", ");
   }
+  return absl::OkStatus();
+}
 
-  if (!root.isMember("clientGameConfigVersion")) {
-    return absl::InvalidArgumentError(
-        "Missing 'clientGameConfigVersion' in JSON.");
-  }
-  if (!root.isMember("fullConfig")) {
-    return absl::InvalidArgumentError("Missing 'fullConfig' in JSON.");
-  }
-  if (!root.isMember("fullConfigHash")) {
-    return absl::InvalidArgumentError("Missing 'fullConfigHash' in JSON.");
+// The sections the generators that will run need.
+GameConfigSections SectionsFor(const std::vector<Generator>& generators) {
+  // Nothing, until a generator asks for it.
+  GameConfigSections sections{false, false, false, false, false, false};
+  for (const Generator& generator : generators) {
+    if (generator.path.empty()) continue;
+    for (const absl::string_view input : generator.inputs) {
+      sections.upgrades |= input == "upgrades";
+      sections.units |= input == "units";
+      sections.avatars |= input == "avatars";
+      sections.battles |= input == "battles";
+      sections.items |= input == "items";
+    }
   }
-  config.set_client_game_config_version(
-      root["clientGameConfigVersion"].asString());
-  config.set_full_config(root["fullConfig"].asBool());
-  config.set_full_config_hash(root["fullConfigHash"].asString());
-
-  return config;
+  return sections;
 }
 
-struct UpgradePtrLess {
-  bool operator()(const Upgrades::Upgrade* lhs,
-                  const Upgrades::Upgrade* rhs) const {
-    if (lhs->rarity() != rhs->rarity()) return lhs->rarity() < rhs->rarity();
-    return lhs->id() < rhs->id();
-  }
-};
+// Records the outputs that were just built successfully, and saves the state.
+absl::Status SaveBuildState(const absl::string_view path,
+                            const std::vector<Generator>& generators,
+                            const std::vector<absl::Status>& statuses,
+                            InputHashes& hashes, BuildState& state) {
+  HashDropRates(hashes);
+  for (size_t i = 0; i < generators.size(); ++i) {
+    if (generators[i].path.empty() || !statuses[i].ok()) continue;
+    std::string key;
+    ASSIGN_OR_RETURN(key, GeneratorKey(generators[i], hashes));
+    state.Record(generators[i].name, generators[i].path, key,
+                 OutputFiles(generators[i].path));
+  }
+  return state.Save(path);
+}
 
-// Expands the materials required for upgrading a unit, recursively expanded
-// recipes if necessary. `upgrade_material` is the snowprint ID of the material
-// to expand.
-void ExpandMats(
-    const std::map<std::string, const Upgrades::Upgrade*>& upgrades_map,
-    std::map<const Upgrades::Upgrade*, int, UpgradePtrLess>& total_mats,
-    const absl::string_view upgrade_material) {
-  const auto it = upgrades_map.find(std::string(upgrade_material));
-  if (it == upgrades_map.end()) {
-    LOG(ERROR) << "Material '" << upgrade_material
-               << "' not found in upgrades_map.\n";
-    return;
-  }
-  const Upgrades::Upgrade* mat = it->second;
-  if (!mat->has_recipe()) {
-    total_mats[mat]++;
-    return;
-  }
-  for (const Upgrades::Upgrade::Recipe::Ingredient& mat_item :
-       mat->recipe().ingredients()) {
-    for (int i = 0; i < mat_item.amount(); ++i) {
-      ExpandMats(upgrades_map, total_mats, mat_item.id());
-    }
+// Logs every icon the emitters referenced that doesn't exist. Character and
+// MoW portraits share a directory, so unused portraits are only reported when
+// both were emitted in this run.
+void ReportAssets(const AssetManifest& assets, const bool both_portraits) {
+  if (const std::vector<std::string> missing = assets.Missing();
+      !missing.empty()) {
+    LOG(ERROR) << "Couldn't find " << missing.size()
+               << " referenced asset(s): " << absl::StrJoin(missing, ", ");
+  }
+  if (!both_portraits) return;
+  if (const std::vector<std::string> orphaned =
+          assets.Orphaned("characters/");
+      !orphaned.empty()) {
+    LOG(WARNING) << orphaned.size() << " portrait(s) aren't used by any "
+                 << "character or MoW: " << absl::StrJoin(orphaned, ", ");
   }
 }
 
-// Returns a map from the snowprint ID of the upgrade material to the Upgrade
-// object.
-std::map<std::string, const Upgrades::Upgrade*> BuildUpgradesMap(
-    const GameConfig& config) {
-  std::map<std::string, const Upgrades::Upgrade*> upgrades_map;
-  for (const auto& upgrade :
-       config.client_game_config().upgrades().upgrades()) {
-    upgrades_map[upgrade.id()] = &upgrade;
+// Logs why the gameconfig couldn't be loaded.
+void LogLoadError(const absl::Status& status) {
+  LOG(ERROR) << "Error loading GameConfig: " << status.message();
+  if (absl::IsNotFound(status)) {
+    LOG(ERROR)
+        << "It's quite likely that you added a new gameconfig.json file. If "
+           "so, you need to go to the cc_binary rule in the BUILD file and "
+           "add the json file to the data array. Sorry, it's a bazel thing.";
   }
-  return upgrades_map;
 }
 
-void EmitRankUp(const GameConfig& config, const absl::string_view output_path) {
-  std::ostream* out;
-  std::unique_ptr<std::ofstream> file_out;
-  if (output_path.empty()) {
-    out = &std::cout;
-  } else {
-    file_out =
-        std::make_unique<std::ofstream>(std::string(output_path).c_str());
-    out = file_out.get();
-  }
-  *out << "unit,target_rank,quantity,upgrade_material,rarity\n";
-  for (const Unit& unit : config.client_game_config().units().units()) {
-    const std::map<std::string, const Upgrades::Upgrade*> upgrades_map =
-        BuildUpgradesMap(config);
-    std::map<const Upgrades::Upgrade*, int, UpgradePtrLess> total_mats;
-    std::map<int, std::map<const Upgrades::Upgrade*, int, UpgradePtrLess>>
-        per_rank_mats;
-    for (int rank = Rank::STONE_1; rank < Rank::ADAMANTINE_1; ++rank) {
-      int i = rank - 1;
-      if (i >= unit.rank_up_requirements_size()) {
-        LOG(ERROR) << "No rank up requirements for " << unit.id() << ":"
-                   << Rank::Enum_Name(rank) << ".\n";
-        continue;
-      }
-      ExpandMats(upgrades_map, per_rank_mats[i],
-                 unit.rank_up_requirements(i).top_row_health());
-      ExpandMats(upgrades_map, per_rank_mats[i],
-                 unit.rank_up_requirements(i).bottom_row_health());
-      ExpandMats(upgrades_map, per_rank_mats[i],
-                 unit.rank_up_requirements(i).top_row_armor());
-      ExpandMats(upgrades_map, per_rank_mats[i],
-                 unit.rank_up_requirements(i).bottom_row_armor());
-      ExpandMats(upgrades_map, per_rank_mats[i],
-                 unit.rank_up_requirements(i).top_row_damage());
-      ExpandMats(upgrades_map, per_rank_mats[i],
-                 unit.rank_up_requirements(i).bottom_row_damage());
-    }
-    for (int i = Rank::STONE_1; i < Rank::ADAMANTINE_1; ++i) {
-      for (const auto& mat : per_rank_mats[i - 1]) {
-        *out << unit.id() << "," << Rank::Enum_Name(i + 1) << "," << mat.second
-             << "," << mat.first->id() << "," << mat.first->rarity() << "\n";
-      }
-    }
-  }
-  if (file_out != nullptr) file_out->close();
+// Writes the metrics to `path`, as "prometheus" or "json".
+absl::Status WriteMetrics(const absl::string_view path,
+                          const absl::string_view format) {
+  std::string metrics;
+  ASSIGN_OR_RETURN(metrics, DumpMetrics(format));
+  return WriteOutput(path, metrics);
 }
 
 void Main() {
-  GameConfig config;
+  // The text is kept so that --incremental_state can hash the sections.
+  std::string text;
+  Json::Value root;
   {
-    Json::Value root;
-    Json::Reader reader;
-
-    const std::string input_file = absl::GetFlag(FLAGS_game_config);
-    std::ifstream in(input_file);
-    if (!reader.parse(in, root)) {
-      LOG(ERROR) << "Couldn't parse json file: '" << input_file << "'.";
-      LOG(ERROR) << reader.getFormattedErrorMessages();
-      LOG(ERROR)
-          << "It's quite likely that you added a new gameconfig.json file. If "
-             "so, you need to go to the cc_binary rule in the BUILD file and "
-             "add the json file to the data array. Sorry, it's a bazel thing.";
-      return;
-    }
-    if (!root.isObject()) {
-      LOG(ERROR) << "Parsed JSON is not an object.";
-      return;
-    }
-    auto parsed_config = ParseGameConfig(root);
-    if (!parsed_config.ok()) {
-      LOG(ERROR) << "Error parsing GameConfig: "
-                 << parsed_config.status().message();
+    AllocationScope allocations("LoadGameConfig");
+    if (const absl::Status status =
+            ReadJsonFile(absl::GetFlag(FLAGS_game_config), text, root);
+        !status.ok()) {
+      LogLoadError(status);
       return;
     }
-    config = std::move(*parsed_config);
   }
-
-  {
-    Json::Value root;
-    Json::Reader reader;
-
-    const std::string input_file = absl::GetFlag(FLAGS_i18n_strings_json);
-    std::ifstream in(input_file);
-    if (!reader.parse(in, root)) {
-      LOG(ERROR) << "Couldn't parse json file: '" << input_file << "'.";
-    }
-    if (!root.isObject()) {
-      LOG(ERROR) << "Parsed JSON is not an object.";
+  const std::string i18n_path = absl::GetFlag(FLAGS_i18n_strings_json);
+
+  const std::string batch_queries = absl::GetFlag(FLAGS_batch_queries);
+  const std::vector<std::string> queries = absl::GetFlag(FLAGS_query_rank_up);
+  if (!batch_queries.empty() || !queries.empty()) {
+    // Rank-up queries only need the upgrades and units, which saves parsing
+    // the battles and simulating their drop rates. They print IDs, so they
+    // don't need the i18n strings either.
+    const GameConfigSections sections =
+        batch_queries.empty()
+            ? GameConfigSections{false, true, true, false, false, false}
+            : GameConfigSections();
+    absl::StatusOr<ArenaGameConfig> loaded = LoadGameConfig(
+        root, batch_queries.empty() ? "" : i18n_path, sections);
+    if (!loaded.ok()) {
+      LogLoadError(loaded.status());
       return;
     }
-    absl::Status status = AmendUnitsWithDisplayStrings(
-        root, config.mutable_client_game_config()->mutable_units());
-    if (!status.ok()) {
-      LOG(ERROR) << "Error parsing i18n strings: " << status.message() << "\n";
+    if (!batch_queries.empty()) {
+      if (const absl::Status status =
+              AnswerBatchQueries(batch_queries, *std::move(loaded));
+          !status.ok()) {
+        LOG(ERROR) << "Error answering batch queries: " << status.message();
+      }
       return;
     }
-  }
-
-  const std::string rank_up_file = absl::GetFlag(FLAGS_rank_up_file);
-  if (!rank_up_file.empty()) {
-    LOG(INFO) << "Writing rank up CSV: " << rank_up_file;
-    EmitRankUp(config, rank_up_file);
-  }
-
-  const std::string recipe_data_file = absl::GetFlag(FLAGS_recipe_data);
-  if (!recipe_data_file.empty()) {
-    LOG(INFO) << "Writing recipe data to: " << recipe_data_file;
-    if (const absl::Status status = CreateRecipeData(recipe_data_file, config);
+    const GameConfigIndex index(loaded->config());
+    if (const absl::Status status = AnswerRankUpQueries(queries, index);
         !status.ok()) {
-      LOG(ERROR) << "Error adjusting recipe data: " << status.message();
+      LOG(ERROR) << "Error answering rank-up queries: " << status.message();
     }
+    return;
   }
 
-  const std::string rank_up_data_file = absl::GetFlag(FLAGS_rank_up_data);
-  if (!rank_up_data_file.empty()) {
-    LOG(INFO) << "Writing rank up data to: " << rank_up_data_file;
-    if (const absl::Status status = CreateRankUpData(rank_up_data_file, config);
-        !status.ok()) {
-      LOG(ERROR) << "Error creating rank up data: " << status.message();
+  absl::StatusOr<std::unique_ptr<AssetManifest>> manifest =
+      AssetManifest::Scan(absl::GetFlag(FLAGS_assets_dir));
+  const bool scanned = manifest.ok();
+  if (scanned) {
+    LOG(INFO) << "Found " << (*manifest)->size() << " assets.";
+  } else {
+    LOG(WARNING) << "Error scanning assets, so every icon will be reported "
+                 << "missing and there's no asset manifest: "
+                 << manifest.status().message();
+    manifest = AssetManifest::Empty(absl::GetFlag(FLAGS_assets_dir));
+  }
+  const AssetManifest& assets = **manifest;
+
+  std::vector<Generator> generators = {
+      {"rank up CSV", absl::GetFlag(FLAGS_rank_up_file),
+       {"upgrades", "units", "i18n"}, EmitRankUp},
+      {"recipe data", absl::GetFlag(FLAGS_recipe_data), {"upgrades"},
+       CreateRecipeData},
+      {"rank up data", absl::GetFlag(FLAGS_rank_up_data), {"units", "i18n"},
+       CreateRankUpData},
+      {"character data", absl::GetFlag(FLAGS_character_data),
+       {"units", "avatars", "i18n", "assets"},
+       [&assets](const absl::string_view path, const GameConfigIndex& index) {
+         return CreateCharacterData(path, index, assets);
+       }},
+      {"campaign data", absl::GetFlag(FLAGS_campaign_data),
+       {"battles", "units", "drop_rates"}, CreateCampaignData},
+      {"equipment data", absl::GetFlag(FLAGS_equipment_data), {"items"},
+       CreateEquipmentData},
+      {"MoW data", absl::GetFlag(FLAGS_mow_data),
+       {"units", "avatars", "i18n", "assets"},
+       [&assets](const absl::string_view path, const GameConfigIndex& index) {
+         return CreateMowData(path, index, assets);
+       }},
+      // Depends on the assets' contents, which aren't hashed.
+      {"asset manifest", absl::GetFlag(FLAGS_asset_manifest), {},
+       [&assets](const absl::string_view path, const GameConfigIndex&) {
+         return assets.Save(path);
+       }},
+      {"binary data", absl::GetFlag(FLAGS_binary_data),
+       {"upgrades", "units", "avatars", "battles", "items", "i18n",
+        "drop_rates", "assets"},
+       [&assets](const absl::string_view path, const GameConfigIndex& index) {
+         return CreateBinaryData(path, index, assets);
+       }},
+      {"cost data", absl::GetFlag(FLAGS_cost_data),
+       {"upgrades", "items", "units"}, CreateCostData},
+      {"material drop data", absl::GetFlag(FLAGS_material_drop_data),
+       {"upgrades", "battles", "units", "drop_rates"}, CreateMaterialDropData},
+  };
+
+  if (!scanned) {
+    for (Generator& generator : generators) {
+      if (generator.name == "asset manifest") generator.path.clear();
     }
   }
 
-  const std::string character_data_file = absl::GetFlag(FLAGS_character_data);
-  if (!character_data_file.empty()) {
-    LOG(INFO) << "Writing character data to: " << character_data_file;
-    if (const absl::Status status =
-            CreateCharacterData(character_data_file, config);
-        !status.ok()) {
-      LOG(ERROR) << "Error creating character data: " << status.message();
+  const std::string state_path = absl::GetFlag(FLAGS_incremental_state);
+  BuildState state;
+  InputHashes hashes;
+  GameConfigSections sections;
+  if (!state_path.empty()) {
+    absl::StatusOr<BuildState> loaded_state = BuildState::Load(state_path);
+    if (!loaded_state.ok()) {
+      LOG(ERROR) << "Error loading the build state: "
+                 << loaded_state.status().message();
+      return;
     }
-  }
-
-  const std::string campaign_data_file = absl::GetFlag(FLAGS_campaign_data);
-  if (!campaign_data_file.empty()) {
-    LOG(INFO) << "Writing campaign data to: " << campaign_data_file;
+    state = *std::move(loaded_state);
+    hashes = HashInputs(root, text, assets);
     if (const absl::Status status =
-            CreateCampaignData(campaign_data_file, config);
+            SkipFreshOutputs(state, hashes, generators);
         !status.ok()) {
-      LOG(ERROR) << "Error creating campaign data: " << status.message();
+      LOG(ERROR) << "Error checking the build state: " << status.message();
+      return;
     }
+    sections = SectionsFor(generators);
   }
 
-  const std::string equipment_data_file = absl::GetFlag(FLAGS_equipment_data);
-  if (!equipment_data_file.empty()) {
-    LOG(INFO) << "Writing equipment data to: " << equipment_data_file;
-    if (const absl::Status status =
-            CreateEquipmentData(equipment_data_file, config);
-        !status.ok()) {
-      LOG(ERROR) << "Error creating equipment data: " << status.message();
-    }
+  absl::StatusOr<ArenaGameConfig> loaded;
+  {
+    AllocationScope allocations("LoadGameConfig");
+    loaded = LoadGameConfig(root, i18n_path, sections);
   }
-
-  const std::string mow_data_file = absl::GetFlag(FLAGS_mow_data);
-  if (!mow_data_file.empty()) {
-    LOG(INFO) << "Writing MoW data to: " << mow_data_file;
-    if (const absl::Status status = CreateMowData(mow_data_file, config);
+  if (!loaded.ok()) {
+    LogLoadError(loaded.status());
+    return;
+  }
+  const GameConfigIndex index(loaded->config());
+  std::vector<absl::Status> statuses;
+  if (const absl::Status status = RunGenerators(generators, index, statuses);
+      !status.ok()) {
+    LOG(ERROR) << "Error creating data: " << status.message();
+  }
+  // Taken before the build state is saved, since that isn't an output.
+  const std::string summary = OutputSummary();
+  if (!state_path.empty()) {
+    if (const absl::Status status =
+            SaveBuildState(state_path, generators, statuses, hashes, state);
         !status.ok()) {
-      LOG(ERROR) << "Error creating MoW data: " << status.message();
+      LOG(ERROR) << "Error saving the build state: " << status.message();
     }
   }
+  const auto ran = [&generators](const absl::string_view name) {
+    return std::any_of(generators.begin(), generators.end(),
+                       [name](const Generator& generator) {
+                         return generator.name == name &&
+                                !generator.path.empty();
+                       });
+  };
+  ReportAssets(assets, ran("character data") && ran("MoW data"));
+  LOG(INFO) << summary;
 }
 
 }  // namespace
@@ -440,7 +633,23 @@ void Main() {
 
 int main(int argc, char** argv) {
   absl::ParseCommandLine(argc, argv);
+  const std::string trace_out = absl::GetFlag(FLAGS_trace_out);
+  if (!trace_out.empty()) dataminer::StartTracing();
   dataminer::Main();
+  if (!trace_out.empty()) {
+    if (const absl::Status status = dataminer::WriteTrace(trace_out);
+        !status.ok()) {
+      LOG(ERROR) << "Error writing the trace: " << status.message();
+    }
+  }
+  if (const std::string metrics_out = absl::GetFlag(FLAGS_metrics_out);
+      !metrics_out.empty()) {
+    if (const absl::Status status = dataminer::WriteMetrics(
+            metrics_out, absl::GetFlag(FLAGS_metrics_format));
+        !status.ok()) {
+      LOG(ERROR) << "Error writing the metrics: " << status.message();
+    }
+  }
 
   return 0;
 }
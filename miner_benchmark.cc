@@ -0,0 +1,636 @@
+// Benchmarks each phase of the miner separately: parsing the JSON, turning it
+// into a GameConfig, amending the units with display strings, and every
+// output generator. Each phase runs over every fixture, and reports its
+// throughput in bytes of gameconfig JSON and in entities per second.
+//
+// The fixtures default to the synthetic gameconfig checked into testdata/, so
+// this runs without network access or the game's assets:
+//
+// bazel run -c opt :miner_benchmark
+//
+// --fixtures takes a comma-separated list of gameconfig JSON files, each
+// optionally followed by ':' and the i18n JSON to amend it with, so trimmed
+// real configs can be benchmarked next to the synthetic one:
+//
+// FIXTURES=testdata/synthetic_gameconfig.json:testdata/synthetic_i18n.json
+// FIXTURES+=,$PWD/gameconfig_1_31.json:$PWD/I2Languages_en.json
+// bazel run -c opt :miner_benchmark -- --fixtures=$FIXTURES
+//
+// To catch regressions, --write_baseline saves each benchmark's time per
+// iteration, and --baseline fails the run if any benchmark got more than
+// --max_regression slower than the saved time:
+//
+// bazel run -c opt :miner_benchmark --
+//   --write_baseline=$PWD/testdata/benchmark_baseline.json
+// bazel run -c opt :miner_benchmark --
+//   --baseline=testdata/benchmark_baseline.json --max_regression=0.2
+//
+// The usual --benchmark_* flags, like --benchmark_filter=Create, also work.
+//
+// BM_PlanFarming plans the rank-ups of a 40-unit roster from Stone I to each
+// unit's last rank, which the planner should answer in well under 100 ms.
+// The synthetic config only has 12 units, so to plan for the full roster, add
+// a config scaled up with scale_gameconfig --scale=4 or more to --fixtures.
+//
+// Before benchmarking, --covering_lp_checks random LPs with up to 4 variables
+// and 4 constraints are solved with CoveringLp and by enumerating every
+// vertex of their feasible region, and the run fails if the two disagree.
+//
+// Parsing simulates the effective drop rate of every chanceOf the fixture
+// hasn't seen, so the BUILD rule passes a small
+// --effective_rate_simulation_runs. The rates are memoized in memory while
+// the fixtures load, before anything is timed.
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "asset_manifest.h"
+#include "benchmark/benchmark.h"
+#include "covering_lp.h"
+#include "create_binary_data.h"
+#include "create_campaign_data.h"
+#include "create_character_data.h"
+#include "create_cost_data.h"
+#include "create_equipment_data.h"
+#include "create_material_drop_data.h"
+#include "create_mow_data.h"
+#include "create_rank_up_data.h"
+#include "create_recipe_data.h"
+#include "farming_planner.h"
+#include "game_config_index.h"
+#include "game_config_loader.h"
+#include "libjson/json/reader.h"
+#include "libjson/json/writer.h"
+#include "miner.pb.h"
+#include "miner_snapshot.h"
+#include "parse_units.h"
+#include "rank_up_csv.h"
+#include "rank_up_query.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::vector<std::string>, fixtures,
+          {"testdata/synthetic_gameconfig.json:testdata/synthetic_i18n.json"},
+          "The gameconfigs to benchmark, each as <gameconfig JSON> or "
+          "<gameconfig JSON>:<i18n JSON>.");
+ABSL_FLAG(std::string, baseline, "",
+          "If not empty, fails the run if any benchmark in this baseline file "
+          "got more than --max_regression slower.");
+ABSL_FLAG(double, max_regression, 0.25,
+          "How much slower than --baseline a benchmark may get, as a "
+          "fraction of the baseline time.");
+ABSL_FLAG(std::string, write_baseline, "",
+          "If not empty, writes each benchmark's time per iteration to this "
+          "file, for use with --baseline.");
+ABSL_FLAG(int, covering_lp_checks, 1000,
+          "How many random LPs to check CoveringLp against brute force on "
+          "before benchmarking.");
+
+namespace dataminer {
+namespace {
+
+// One gameconfig, loaded once and shared by every benchmark over it.
+struct Fixture {
+  std::string name;
+  std::string game_config_json;
+  std::string i18n_json;
+  Json::Value game_config_root;
+  Json::Value i18n_root;
+  ArenaGameConfig config;
+  std::unique_ptr<GameConfigIndex> index;
+  std::unique_ptr<AssetManifest> assets;
+  // For the query engines, over a copy of `config`.
+  std::unique_ptr<const MinerSnapshot> snapshot;
+  // Where the generators write their outputs.
+  std::filesystem::path output_dir;
+  // The units, NPCs, upgrades, battles, items and avatars in the config.
+  int64_t entities = 0;
+};
+
+// Set if any benchmark's work failed, since its timing is then meaningless.
+bool benchmark_failed = false;
+
+absl::StatusOr<std::string> ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return absl::NotFoundError(absl::StrCat("Couldn't open '", path, "'."));
+  }
+  return std::string((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+}
+
+absl::Status ParseJson(const std::string& json, Json::Value& root) {
+  Json::Reader reader;
+  if (!reader.parse(json, root)) {
+    return absl::InvalidArgumentError(reader.getFormattedErrorMessages());
+  }
+  return absl::OkStatus();
+}
+
+int64_t CountEntities(const ClientGameConfig& config) {
+  int64_t entities = config.units().units_size() +
+                     config.units().npcs_size() +
+                     config.units().mows_size() +
+                     config.upgrades().upgrades_size() +
+                     config.items().items_size() +
+                     config.avatars().avatars_size();
+  const Battles& battles = config.battles();
+  for (const google::protobuf::RepeatedPtrField<Campaign>* list :
+       {&battles.standard_campaigns(), &battles.mirror_campaigns(),
+        &battles.elite_campaigns(), &battles.mirror_elite_campaigns(),
+        &battles.campaign_events()}) {
+    for (const Campaign& campaign : *list) {
+      entities += campaign.battles_size();
+    }
+  }
+  return entities;
+}
+
+// Loads the fixture described by a --fixtures entry.
+absl::StatusOr<std::unique_ptr<Fixture>> LoadFixture(
+    const std::string& spec) {
+  const std::vector<std::string> paths = absl::StrSplit(spec, ':');
+  RET_CHECK(paths.size() == 1 || paths.size() == 2)
+      << "Expected <gameconfig JSON>[:<i18n JSON>], got '" << spec << "'.";
+  auto fixture = std::make_unique<Fixture>();
+  fixture->name = std::filesystem::path(paths[0]).stem().string();
+  ASSIGN_OR_RETURN(fixture->game_config_json, ReadFile(paths[0]));
+  RETURN_IF_ERROR(
+      ParseJson(fixture->game_config_json, fixture->game_config_root));
+  RETURN_IF_ERROR(ParseGameConfig(fixture->game_config_root,
+                                  *fixture->config.mutable_config()));
+  if (paths.size() == 2) {
+    ASSIGN_OR_RETURN(fixture->i18n_json, ReadFile(paths[1]));
+    RETURN_IF_ERROR(ParseJson(fixture->i18n_json, fixture->i18n_root));
+    RETURN_IF_ERROR(AmendUnitsWithDisplayStrings(
+        fixture->i18n_root,
+        fixture->config.mutable_config()
+            ->mutable_client_game_config()
+            ->mutable_units()));
+  }
+  const GameConfig& config = fixture->config.config();
+  fixture->entities = CountEntities(config.client_game_config());
+  fixture->index = std::make_unique<GameConfigIndex>(config);
+  ArenaGameConfig snapshot_config;
+  snapshot_config.mutable_config()->CopyFrom(config);
+  ASSIGN_OR_RETURN(fixture->snapshot,
+                   MinerSnapshot::Create(std::move(snapshot_config)));
+
+  fixture->output_dir = std::filesystem::temp_directory_path() /
+                        "miner_benchmark" / fixture->name;
+  // The benchmarks don't use the game's assets, so icons resolve against an
+  // empty directory.
+  std::error_code error;
+  std::filesystem::create_directories(fixture->output_dir / "assets", error);
+  if (error) {
+    return absl::UnavailableError(
+        absl::StrCat("Couldn't create '", fixture->output_dir.string(),
+                     "': ", error.message()));
+  }
+  ASSIGN_OR_RETURN(
+      fixture->assets,
+      AssetManifest::Scan((fixture->output_dir / "assets").string()));
+  return fixture;
+}
+
+// The most units BM_PlanFarming puts on its roster.
+constexpr int kFarmingRosterSize = 40;
+
+// Reports the throughput of `state`'s iterations over `fixture`, counting
+// `bytes` per iteration.
+void SetThroughput(benchmark::State& state, const Fixture& fixture,
+                   const size_t bytes) {
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.counters["entities"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * fixture.entities),
+      benchmark::Counter::kIsRate);
+}
+
+void Fail(benchmark::State& state, const absl::Status& status) {
+  benchmark_failed = true;
+  state.SkipWithError(std::string(status.message()).c_str());
+}
+
+void BM_JsonParse(benchmark::State& state, const Fixture* fixture) {
+  for (auto _ : state) {
+    Json::Value root;
+    if (const absl::Status status =
+            ParseJson(fixture->game_config_json, root);
+        !status.ok()) {
+      Fail(state, status);
+      return;
+    }
+    benchmark::DoNotOptimize(root);
+  }
+  SetThroughput(state, *fixture, fixture->game_config_json.size());
+}
+
+// Plans the rank-ups of the fixture's first kFarmingRosterSize units, as a
+// "farm" query with a roster would, from the rank-up totals to the raids.
+void BM_PlanFarming(benchmark::State& state, const Fixture* fixture) {
+  const MinerSnapshot& snapshot = *fixture->snapshot;
+  FarmingPlanner::Options options;
+  std::vector<RankUpQuery::Request> requests;
+  for (const Unit& unit :
+       snapshot.config().client_game_config().units().units()) {
+    if (requests.size() == kFarmingRosterSize) break;
+    options.roster.insert(unit.id());
+    requests.push_back(
+        {unit.id(), Rank::STONE_1,
+         static_cast<Rank::Enum>(Rank::STONE_1 +
+                                 unit.rank_up_requirements_size())});
+  }
+  int64_t energy = 0;
+  for (auto _ : state) {
+    absl::StatusOr<RecipeGraph::Materials> needs =
+        snapshot.rank_ups().QueryBatch(requests);
+    absl::StatusOr<FarmingPlanner::Plan> plan =
+        needs.ok() ? snapshot.farming().PlanFarming(*needs, options)
+                   : needs.status();
+    if (!plan.ok()) {
+      Fail(state, plan.status());
+      return;
+    }
+    energy = plan->energy;
+  }
+  state.counters["units"] = requests.size();
+  state.counters["energy"] = energy;
+}
+
+// Includes building the config's arena and freeing it again.
+void BM_ParseGameConfig(benchmark::State& state, Fixture* fixture) {
+  for (auto _ : state) {
+    ArenaGameConfig config;
+    if (const absl::Status status =
+            ParseGameConfig(fixture->game_config_root,
+                            *config.mutable_config());
+        !status.ok()) {
+      Fail(state, status);
+      return;
+    }
+    benchmark::DoNotOptimize(config.config());
+  }
+  SetThroughput(state, *fixture, fixture->game_config_json.size());
+}
+
+void BM_AmendUnitsWithDisplayStrings(benchmark::State& state,
+                                     const Fixture* fixture) {
+  Units units = fixture->config.config().client_game_config().units();
+  for (auto _ : state) {
+    if (const absl::Status status =
+            AmendUnitsWithDisplayStrings(fixture->i18n_root, &units);
+        !status.ok()) {
+      Fail(state, status);
+      return;
+    }
+  }
+  SetThroughput(state, *fixture, fixture->i18n_json.size());
+}
+
+// Benchmarks a generator. Its output is rewritten on every iteration, but
+// after the first one WriteOutput finds it unchanged and skips the write, as
+// on a re-run of the miner.
+void BM_Generator(
+    benchmark::State& state, const Fixture* fixture,
+    const std::function<absl::Status(absl::string_view,
+                                     const GameConfigIndex&)>& create,
+    const std::string& output_name) {
+  const std::string path = (fixture->output_dir / output_name).string();
+  for (auto _ : state) {
+    if (const absl::Status status = create(path, *fixture->index);
+        !status.ok()) {
+      Fail(state, status);
+      return;
+    }
+  }
+  SetThroughput(state, *fixture, fixture->game_config_json.size());
+}
+
+void RegisterBenchmarks(Fixture* fixture) {
+  const auto name = [fixture](const absl::string_view benchmark) {
+    return absl::StrCat(benchmark, "/", fixture->name);
+  };
+  benchmark::RegisterBenchmark(name("BM_JsonParse").c_str(), BM_JsonParse,
+                               fixture);
+  benchmark::RegisterBenchmark(name("BM_ParseGameConfig").c_str(),
+                               BM_ParseGameConfig, fixture);
+  if (!fixture->i18n_json.empty()) {
+    benchmark::RegisterBenchmark(
+        name("BM_AmendUnitsWithDisplayStrings").c_str(),
+        BM_AmendUnitsWithDisplayStrings, fixture);
+  }
+
+  const AssetManifest& assets = *fixture->assets;
+  const std::vector<std::pair<std::string,
+                              std::function<absl::Status(
+                                  absl::string_view, const GameConfigIndex&)>>>
+      generators = {
+          {"EmitRankUp", EmitRankUp},
+          {"CreateRecipeData", CreateRecipeData},
+          {"CreateRankUpData", CreateRankUpData},
+          {"CreateCharacterData",
+           [&assets](const absl::string_view path,
+                     const GameConfigIndex& index) {
+             return CreateCharacterData(path, index, assets);
+           }},
+          {"CreateCampaignData", CreateCampaignData},
+          {"CreateEquipmentData", CreateEquipmentData},
+          {"CreateMowData",
+           [&assets](const absl::string_view path,
+                     const GameConfigIndex& index) {
+             return CreateMowData(path, index, assets);
+           }},
+          {"CreateBinaryData",
+           [&assets](const absl::string_view path,
+                     const GameConfigIndex& index) {
+             return CreateBinaryData(path, index, assets);
+           }},
+          {"CreateCostData", CreateCostData},
+          {"CreateMaterialDropData", CreateMaterialDropData},
+      };
+  for (const auto& [generator, create] : generators) {
+    benchmark::RegisterBenchmark(name(absl::StrCat("BM_", generator)).c_str(),
+                                 BM_Generator, fixture, create, generator);
+  }
+  benchmark::RegisterBenchmark(name("BM_PlanFarming").c_str(), BM_PlanFarming,
+                               fixture)
+      ->Unit(benchmark::kMillisecond);
+}
+
+// One LP for CoveringLp, in its constructor's terms.
+struct RandomLp {
+  std::vector<double> costs;
+  std::vector<double> upper;
+  std::vector<std::vector<double>> rows;
+  std::vector<double> rhs;
+};
+
+// Draws a small LP shaped like the farming ones: non-negative energy costs,
+// sparse drop rates, positive needs, and raid limits on some of the nodes.
+RandomLp MakeRandomLp(std::mt19937& random) {
+  std::uniform_int_distribution<int> size(1, 4);
+  std::uniform_int_distribution<int> small(0, 10);
+  std::uniform_real_distribution<double> rate(0, 2);
+  std::uniform_real_distribution<double> need(0.5, 10);
+  std::bernoulli_distribution coin(0.5);
+  RandomLp lp;
+  const int variables = size(random);
+  const int constraints = size(random);
+  for (int j = 0; j < variables; ++j) {
+    lp.costs.push_back(small(random));
+    lp.upper.push_back(coin(random)
+                           ? std::numeric_limits<double>::infinity()
+                           : small(random));
+  }
+  for (int i = 0; i < constraints; ++i) {
+    std::vector<double>& row = lp.rows.emplace_back();
+    for (int j = 0; j < variables; ++j) {
+      row.push_back(coin(random) ? 0 : rate(random));
+    }
+    lp.rhs.push_back(need(random));
+  }
+  return lp;
+}
+
+// Returns true if `x` satisfies `lp`'s constraints, to within `tolerance`.
+bool IsFeasible(const RandomLp& lp, const std::vector<double>& x,
+                const double tolerance) {
+  for (size_t j = 0; j < x.size(); ++j) {
+    if (x[j] < -tolerance || x[j] > lp.upper[j] + tolerance) return false;
+  }
+  for (size_t i = 0; i < lp.rows.size(); ++i) {
+    double total = 0;
+    for (size_t j = 0; j < x.size(); ++j) total += lp.rows[i][j] * x[j];
+    if (total < lp.rhs[i] - tolerance) return false;
+  }
+  return true;
+}
+
+// Solves the square system `a` x = `b` by Gaussian elimination with partial
+// pivoting. Returns false if it's singular.
+bool SolveSquare(std::vector<std::vector<double>> a, std::vector<double> b,
+                 std::vector<double>& x) {
+  const int n = b.size();
+  for (int k = 0; k < n; ++k) {
+    int best = k;
+    for (int i = k + 1; i < n; ++i) {
+      if (std::abs(a[i][k]) > std::abs(a[best][k])) best = i;
+    }
+    if (std::abs(a[best][k]) < 1e-9) return false;
+    std::swap(a[k], a[best]);
+    std::swap(b[k], b[best]);
+    for (int i = k + 1; i < n; ++i) {
+      const double factor = a[i][k] / a[k][k];
+      for (int j = k; j < n; ++j) a[i][j] -= factor * a[k][j];
+      b[i] -= factor * b[k];
+    }
+  }
+  x.assign(n, 0);
+  for (int k = n - 1; k >= 0; --k) {
+    double total = b[k];
+    for (int j = k + 1; j < n; ++j) total -= a[k][j] * x[j];
+    x[k] = total / a[k][k];
+  }
+  return true;
+}
+
+// The optimal cost of `lp`, found by trying every vertex of its feasible
+// region, or infinity if it's infeasible. Every x is bounded below, so a
+// feasible region has a vertex, and with c >= 0 one of them is optimal.
+double BruteForceOptimum(const RandomLp& lp) {
+  const int variables = lp.costs.size();
+  // Every constraint as a row of a.x >= b: the LP's rows, then x_j >= 0,
+  // then -x_j >= -upper_j for the finite bounds.
+  std::vector<std::vector<double>> a = lp.rows;
+  std::vector<double> b = lp.rhs;
+  for (int j = 0; j < variables; ++j) {
+    a.emplace_back(variables, 0)[j] = 1;
+    b.push_back(0);
+    if (std::isfinite(lp.upper[j])) {
+      a.emplace_back(variables, 0)[j] = -1;
+      b.push_back(-lp.upper[j]);
+    }
+  }
+  // A vertex is where `variables` of the constraints are tight. Each choice
+  // of them is a bitmask over the constraints.
+  double best = std::numeric_limits<double>::infinity();
+  const int constraints = a.size();
+  for (uint32_t tight = 0; tight < (1u << constraints); ++tight) {
+    if (__builtin_popcount(tight) != variables) continue;
+    std::vector<std::vector<double>> square;
+    std::vector<double> values;
+    for (int i = 0; i < constraints; ++i) {
+      if ((tight >> i) & 1) {
+        square.push_back(a[i]);
+        values.push_back(b[i]);
+      }
+    }
+    std::vector<double> x;
+    if (!SolveSquare(square, values, x) || !IsFeasible(lp, x, 1e-7)) continue;
+    double cost = 0;
+    for (int j = 0; j < variables; ++j) cost += lp.costs[j] * x[j];
+    best = std::min(best, cost);
+  }
+  return best;
+}
+
+// Checks CoveringLp against BruteForceOptimum on `checks` random LPs.
+absl::Status CheckCoveringLp(const int checks) {
+  // A fixed seed, so a failure reproduces.
+  std::mt19937 random(1);
+  for (int check = 0; check < checks; ++check) {
+    const RandomLp lp = MakeRandomLp(random);
+    const double expected = BruteForceOptimum(lp);
+    CoveringLp solver(lp.costs, lp.upper, lp.rows, lp.rhs);
+    absl::StatusOr<std::vector<double>> x = solver.Solve();
+    if (!x.ok()) {
+      RET_CHECK(solver.infeasible() && std::isinf(expected))
+          << "Random LP " << check << ": CoveringLp failed with "
+          << x.status().message() << ", but brute force found an optimum of "
+          << expected << ".";
+      continue;
+    }
+    RET_CHECK(IsFeasible(lp, *x, 1e-6))
+        << "Random LP " << check << ": CoveringLp's solution is infeasible.";
+    double cost = 0;
+    for (size_t j = 0; j < x->size(); ++j) cost += lp.costs[j] * (*x)[j];
+    RET_CHECK(std::abs(cost - expected) <= 1e-6 * std::max(1.0, expected))
+        << "Random LP " << check << ": CoveringLp found a cost of " << cost
+        << ", but brute force found " << expected << ".";
+  }
+  return absl::OkStatus();
+}
+
+// Reports like the console reporter, and keeps every benchmark's time per
+// iteration, in nanoseconds, for the baseline.
+class BaselineReporter : public benchmark::ConsoleReporter {
+ public:
+  BaselineReporter() : ConsoleReporter(OO_Tabular) {}
+
+  void ReportRuns(const std::vector<Run>& runs) override {
+    ConsoleReporter::ReportRuns(runs);
+    for (const Run& run : runs) {
+      if (run.run_type != Run::RT_Iteration || run.iterations == 0) continue;
+      times_ns_[run.benchmark_name()] =
+          run.GetAdjustedRealTime() /
+          benchmark::GetTimeUnitMultiplier(run.time_unit) * 1e9;
+    }
+  }
+
+  const std::map<std::string, double>& times_ns() const { return times_ns_; }
+
+ private:
+  std::map<std::string, double> times_ns_;
+};
+
+absl::Status WriteBaseline(const std::string& path,
+                           const std::map<std::string, double>& times_ns) {
+  Json::Value root(Json::objectValue);
+  for (const auto& [name, time_ns] : times_ns) root[name] = time_ns;
+  std::ofstream out(path);
+  out << Json::writeString(Json::StreamWriterBuilder(), root) << "\n";
+  out.close();
+  if (!out) {
+    return absl::InternalError(
+        absl::StrCat("Couldn't write the baseline to '", path, "'."));
+  }
+  return absl::OkStatus();
+}
+
+// Fails if any benchmark in the baseline at `path` got more than
+// `max_regression` slower. Benchmarks missing from either side are ignored,
+// so fixtures can be added without updating the baseline.
+absl::Status CheckBaseline(const std::string& path,
+                           const std::map<std::string, double>& times_ns,
+                           const double max_regression) {
+  std::string json;
+  ASSIGN_OR_RETURN(json, ReadFile(path));
+  Json::Value root;
+  RETURN_IF_ERROR(ParseJson(json, root));
+  RET_CHECK(root.isObject()) << "The baseline must be a JSON object.";
+  std::vector<std::string> regressions;
+  for (const std::string& name : root.getMemberNames()) {
+    const auto it = times_ns.find(name);
+    if (it == times_ns.end()) continue;
+    const double baseline_ns = root[name].asDouble();
+    if (it->second > baseline_ns * (1 + max_regression)) {
+      regressions.push_back(absl::StrFormat("%s: %.0f ns, was %.0f ns", name,
+                                            it->second, baseline_ns));
+    }
+  }
+  if (regressions.empty()) return absl::OkStatus();
+  return absl::FailedPreconditionError(
+      absl::StrCat(regressions.size(), " benchmark(s) regressed: ",
+                   absl::StrJoin(regressions, "; ")));
+}
+
+absl::Status Main() {
+  const int checks = absl::GetFlag(FLAGS_covering_lp_checks);
+  RETURN_IF_ERROR(CheckCoveringLp(checks));
+  LOG(INFO) << "CoveringLp matched brute force on " << checks
+            << " random LPs.";
+
+  std::vector<std::unique_ptr<Fixture>> fixtures;
+  for (const std::string& spec : absl::GetFlag(FLAGS_fixtures)) {
+    std::unique_ptr<Fixture> fixture;
+    ASSIGN_OR_RETURN(fixture, LoadFixture(spec));
+    LOG(INFO) << "Loaded fixture '" << fixture->name << "': "
+              << fixture->game_config_json.size() << " bytes, "
+              << fixture->entities << " entities.";
+    RegisterBenchmarks(fixture.get());
+    fixtures.push_back(std::move(fixture));
+  }
+
+  BaselineReporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::Shutdown();
+  if (benchmark_failed) {
+    return absl::InternalError("At least one benchmark failed.");
+  }
+
+  if (const std::string path = absl::GetFlag(FLAGS_write_baseline);
+      !path.empty()) {
+    RETURN_IF_ERROR(WriteBaseline(path, reporter.times_ns()));
+  }
+  if (const std::string path = absl::GetFlag(FLAGS_baseline); !path.empty()) {
+    RETURN_IF_ERROR(CheckBaseline(path, reporter.times_ns(),
+                                  absl::GetFlag(FLAGS_max_regression)));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace dataminer
+
+int main(int argc, char** argv) {
+  // The benchmark library takes its --benchmark_* flags out of argv, and
+  // leaves the rest for absl.
+  benchmark::Initialize(&argc, argv);
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+  if (absl::Status status = dataminer::Main(); !status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,228 @@
+#include "miner_c_api.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "craft_solver.h"
+#include "miner_snapshot.h"
+
+struct dataminer_snapshot {
+  std::unique_ptr<const dataminer::MinerSnapshot> snapshot;
+};
+
+namespace dataminer {
+
+namespace {
+
+// Each thread's last error, in a fixed buffer so that reporting one doesn't
+// allocate something the caller would have to free.
+thread_local char last_error[512];
+
+dataminer_status Fail(const absl::Status& status) {
+  const size_t size =
+      std::min(status.message().size(), sizeof(last_error) - 1);
+  std::memcpy(last_error, status.message().data(), size);
+  last_error[size] = '\0';
+  return static_cast<dataminer_status>(status.code());
+}
+
+dataminer_status Ok() {
+  last_error[0] = '\0';
+  return DATAMINER_OK;
+}
+
+dataminer_status BufferTooSmall(const size_t needed, const size_t capacity) {
+  Fail(absl::OutOfRangeError(absl::StrCat("Need room for ", needed,
+                                          " results, but there's only room "
+                                          "for ",
+                                          capacity, ".")));
+  return DATAMINER_BUFFER_TOO_SMALL;
+}
+
+absl::Status CheckMaterial(const RecipeGraph& graph, const int32_t material) {
+  if (material < 0 || material >= graph.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("There's no material ", material, "."));
+  }
+  return absl::OkStatus();
+}
+
+// Counts the solvers take, which keeps their arithmetic in range.
+absl::Status CheckCount(const int32_t material, const int64_t count) {
+  if (count < 0 || count > CraftSolver::kMaxCount) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected a count of material ", material,
+                     " between 0 and ", CraftSolver::kMaxCount, "."));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+}  // namespace dataminer
+
+using dataminer::Fail;
+using dataminer::Ok;
+
+int32_t dataminer_api_version(void) { return DATAMINER_C_API_VERSION; }
+
+const char* dataminer_last_error(void) { return dataminer::last_error; }
+
+dataminer_status dataminer_load(const char* game_config_path,
+                                const char* i18n_path,
+                                dataminer_snapshot** snapshot) {
+  if (game_config_path == nullptr || snapshot == nullptr) {
+    return Fail(absl::InvalidArgumentError("No gameconfig or snapshot."));
+  }
+  absl::StatusOr<std::unique_ptr<const dataminer::MinerSnapshot>> loaded =
+      dataminer::MinerSnapshot::Load(game_config_path,
+                                     i18n_path == nullptr ? "" : i18n_path);
+  if (!loaded.ok()) return Fail(loaded.status());
+  *snapshot = new dataminer_snapshot{*std::move(loaded)};
+  return Ok();
+}
+
+void dataminer_free(dataminer_snapshot* snapshot) { delete snapshot; }
+
+int32_t dataminer_num_materials(const dataminer_snapshot* snapshot) {
+  return snapshot->snapshot->graph().size();
+}
+
+int32_t dataminer_find_material(const dataminer_snapshot* snapshot,
+                                const char* id) {
+  return snapshot->snapshot->graph().Find(id);
+}
+
+const char* dataminer_material_id(const dataminer_snapshot* snapshot,
+                                  const int32_t material) {
+  const dataminer::RecipeGraph& graph = snapshot->snapshot->graph();
+  if (!dataminer::CheckMaterial(graph, material).ok()) return nullptr;
+  return graph.upgrade(material).id().c_str();
+}
+
+dataminer_status dataminer_rank_up(const dataminer_snapshot* snapshot,
+                                   const dataminer_rank_up_request* requests,
+                                   const size_t num_requests,
+                                   int64_t* totals) {
+  const dataminer::RankUpQuery& rank_ups = snapshot->snapshot->rank_ups();
+  const absl::Span<int64_t> dense(totals, rank_ups.graph().size());
+  const auto to_query = [&requests](const size_t i) {
+    return dataminer::RankUpQuery::Request{
+        requests[i].unit_id,
+        static_cast<dataminer::Rank::Enum>(requests[i].from_rank),
+        static_cast<dataminer::Rank::Enum>(requests[i].to_rank)};
+  };
+  // Every request is checked before any is added, so that a bad one leaves
+  // `totals` alone.
+  for (size_t i = 0; i < num_requests; ++i) {
+    const dataminer_rank_up_request& request = requests[i];
+    if (request.unit_id == nullptr ||
+        !dataminer::Rank::Enum_IsValid(request.from_rank) ||
+        !dataminer::Rank::Enum_IsValid(request.to_rank)) {
+      return Fail(absl::InvalidArgumentError(
+          absl::StrCat("Rank-up request ", i, " isn't valid.")));
+    }
+    const absl::Status status = rank_ups.Check(to_query(i));
+    if (!status.ok()) return Fail(status);
+  }
+  for (size_t i = 0; i < num_requests; ++i) {
+    const dataminer::RankUpQuery::Request query = to_query(i);
+    const absl::Status status = rank_ups.AddTo({&query, 1}, dense);
+    if (!status.ok()) return Fail(status);
+  }
+  return Ok();
+}
+
+dataminer_status dataminer_expand_recipes(
+    const dataminer_snapshot* snapshot,
+    const dataminer_material_count* materials, const size_t num_materials,
+    int64_t* totals) {
+  const dataminer::RecipeGraph& graph = snapshot->snapshot->graph();
+  for (size_t i = 0; i < num_materials; ++i) {
+    absl::Status status =
+        dataminer::CheckMaterial(graph, materials[i].material);
+    if (status.ok()) {
+      status = dataminer::CheckCount(materials[i].material, materials[i].count);
+    }
+    if (!status.ok()) return Fail(status);
+  }
+  for (size_t i = 0; i < num_materials; ++i) {
+    for (const dataminer::RecipeGraph::MaterialCount& base :
+         graph.BaseMaterials(materials[i].material)) {
+      totals[base.material] += base.count * materials[i].count;
+    }
+  }
+  return Ok();
+}
+
+dataminer_status dataminer_drops(const dataminer_snapshot* snapshot,
+                                 const int32_t* materials,
+                                 const size_t num_materials,
+                                 dataminer_drop* drops,
+                                 const size_t drops_capacity,
+                                 size_t* offsets) {
+  const dataminer::MaterialDropIndex& index = snapshot->snapshot->drops();
+  offsets[0] = 0;
+  for (size_t i = 0; i < num_materials; ++i) {
+    const absl::Status status =
+        dataminer::CheckMaterial(index.graph(), materials[i]);
+    if (!status.ok()) return Fail(status);
+    offsets[i + 1] = offsets[i] + index.Drops(materials[i]).size();
+  }
+  if (offsets[num_materials] > drops_capacity) {
+    return dataminer::BufferTooSmall(offsets[num_materials], drops_capacity);
+  }
+  for (size_t i = 0; i < num_materials; ++i) {
+    dataminer_drop* out = drops + offsets[i];
+    for (const dataminer::MaterialDropIndex::Drop& drop :
+         index.Drops(materials[i])) {
+      *out++ = {drop.battle_id.c_str(), drop.energy_cost, drop.effective_rate,
+                drop.energy_per_drop};
+    }
+  }
+  return Ok();
+}
+
+dataminer_status dataminer_plan_farming(
+    const dataminer_snapshot* snapshot, const dataminer_material_count* needs,
+    const size_t num_needs, const char* const* roster,
+    const size_t roster_size, const int32_t days, dataminer_raid* raids,
+    const size_t raids_capacity, size_t* num_raids, int64_t* energy) {
+  const dataminer::MinerSnapshot& miner = *snapshot->snapshot;
+  // The planner wants the needs sorted and merged.
+  dataminer::RecipeGraph::Materials sorted;
+  for (size_t i = 0; i < num_needs; ++i) {
+    absl::Status status =
+        dataminer::CheckMaterial(miner.graph(), needs[i].material);
+    if (status.ok()) {
+      status = dataminer::CheckCount(needs[i].material, needs[i].count);
+    }
+    if (!status.ok()) return Fail(status);
+    const dataminer::RecipeGraph::MaterialCount need = {needs[i].material,
+                                                        needs[i].count};
+    dataminer::RecipeGraph::Accumulate({&need, 1}, 1, sorted);
+  }
+  dataminer::FarmingPlanner::Options options;
+  options.roster.insert(roster, roster + roster_size);
+  options.days = days;
+  absl::StatusOr<dataminer::FarmingPlanner::Plan> plan =
+      miner.farming().PlanFarming(sorted, options);
+  if (!plan.ok()) return Fail(plan.status());
+  *num_raids = plan->raids.size();
+  if (plan->raids.size() > raids_capacity) {
+    return dataminer::BufferTooSmall(plan->raids.size(), raids_capacity);
+  }
+  for (size_t i = 0; i < plan->raids.size(); ++i) {
+    // The battle ID is a view of a whole std::string in the drop index, so
+    // it's null terminated.
+    raids[i] = {plan->raids[i].battle_id.data(), plan->raids[i].count};
+  }
+  *energy = plan->energy;
+  return Ok();
+}
@@ -0,0 +1,160 @@
+#ifndef __MINER_C_API_H__
+#define __MINER_C_API_H__
+
+// A C interface to the mined data, for embedding it in another process
+// (e.g. the planner backend) instead of running :miner or talking to
+// :miner_server. Build it as a shared library with
+//
+//   bazel build -c opt :libdataminer.so
+//
+// Everything goes through an opaque dataminer_snapshot, which holds one
+// parsed GameConfig and every index over it. A snapshot is immutable, so
+// any number of threads can query the same one at once. To move to a new
+// gameconfig, load a new snapshot, point new queries at it, and free the old
+// one once the queries on it are done. Snapshots can also be loaded from
+// several threads at once.
+//
+// Queries write into buffers the caller provides and don't allocate, except
+// where noted. Strings they return point into the snapshot and live as long
+// as it does.
+//
+// Functions that can fail return a dataminer_status. On failure,
+// dataminer_last_error() describes what went wrong.
+//
+// The library only exports the functions below. Everything else in it,
+// including the absl and protobuf it's linked with, is hidden, so it can be
+// loaded into a process that uses its own versions of those.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Marks the functions libdataminer.so exports.
+#if defined(__GNUC__)
+#define DATAMINER_EXPORT __attribute__((visibility("default")))
+#else
+#define DATAMINER_EXPORT
+#endif
+
+// Bumped whenever a signature or struct below changes incompatibly.
+#define DATAMINER_C_API_VERSION 1
+
+// The status codes are absl::StatusCode's, plus one of our own.
+typedef int32_t dataminer_status;
+#define DATAMINER_OK 0
+#define DATAMINER_INVALID_ARGUMENT 3
+#define DATAMINER_NOT_FOUND 5
+#define DATAMINER_RESOURCE_EXHAUSTED 8
+#define DATAMINER_FAILED_PRECONDITION 9
+#define DATAMINER_OUT_OF_RANGE 11
+#define DATAMINER_INTERNAL 13
+// An output buffer is too small. The call reports how big it needs to be.
+#define DATAMINER_BUFFER_TOO_SMALL 100
+
+typedef struct dataminer_snapshot dataminer_snapshot;
+
+// An amount of an upgrade material. Materials are numbered
+// [0, dataminer_num_materials()), by rarity and then by ID.
+typedef struct {
+  int32_t material;
+  int64_t count;
+} dataminer_material_count;
+
+typedef struct {
+  const char* unit_id;
+  // Rank::Enum values from miner.proto, e.g. 1 for STONE_1.
+  int32_t from_rank;
+  int32_t to_rank;
+} dataminer_rank_up_request;
+
+typedef struct {
+  // The planner's name for the node, e.g. "FoCE12".
+  const char* battle_id;
+  int32_t energy_cost;
+  // How many of the material one raid yields on average.
+  double effective_rate;
+  double energy_per_drop;
+} dataminer_drop;
+
+typedef struct {
+  const char* battle_id;
+  int64_t count;
+} dataminer_raid;
+
+DATAMINER_EXPORT int32_t dataminer_api_version(void);
+
+// The message of the last failure on this thread. Empty if there was none.
+DATAMINER_EXPORT const char* dataminer_last_error(void);
+
+// Loads the gameconfig JSON at `game_config_path`. `i18n_path` may be null
+// or empty. On success, *snapshot must be freed with dataminer_free.
+DATAMINER_EXPORT dataminer_status dataminer_load(
+    const char* game_config_path, const char* i18n_path,
+    dataminer_snapshot** snapshot);
+
+DATAMINER_EXPORT void dataminer_free(dataminer_snapshot* snapshot);
+
+DATAMINER_EXPORT int32_t
+dataminer_num_materials(const dataminer_snapshot* snapshot);
+
+// The material with Snowprint ID `id`, or -1.
+DATAMINER_EXPORT int32_t dataminer_find_material(
+    const dataminer_snapshot* snapshot, const char* id);
+
+// The Snowprint ID of `material`, or null if it's out of range.
+DATAMINER_EXPORT const char* dataminer_material_id(
+    const dataminer_snapshot* snapshot, int32_t material);
+
+// Adds the base materials it takes to do all of `requests` to `totals`,
+// which has dataminer_num_materials() entries. If any request is bad,
+// `totals` is left as it was.
+DATAMINER_EXPORT dataminer_status dataminer_rank_up(
+    const dataminer_snapshot* snapshot,
+    const dataminer_rank_up_request* requests, size_t num_requests,
+    int64_t* totals);
+
+// Adds the base materials it takes to craft all of `materials` to `totals`,
+// which has dataminer_num_materials() entries. Each count must be between 0
+// and 2^30. If any material or count is out of range, `totals` is left as it
+// was.
+DATAMINER_EXPORT dataminer_status dataminer_expand_recipes(
+    const dataminer_snapshot* snapshot,
+    const dataminer_material_count* materials, size_t num_materials,
+    int64_t* totals);
+
+// Writes the nodes that drop each of `materials`, cheapest first. The drops
+// of materials[i] are drops[offsets[i], offsets[i + 1]), so `offsets` has
+// num_materials + 1 entries. If there are more than `drops_capacity` drops,
+// only `offsets` is written and this returns DATAMINER_BUFFER_TOO_SMALL.
+DATAMINER_EXPORT dataminer_status dataminer_drops(
+    const dataminer_snapshot* snapshot, const int32_t* materials,
+    size_t num_materials, dataminer_drop* drops, size_t drops_capacity,
+    size_t* offsets);
+
+// Plans the cheapest raids to farm `needs`; see farming_planner.h. If
+// `roster` isn't empty, it's the IDs of the units the player has, and nodes
+// they can't raid are left out. `days` limits the raids to that many days'
+// worth of attempts, or is 0 for no limit. Each need's count must be between
+// 0 and 2^30. Crafted needs that no node drops are farmed as their base
+// materials, and base materials that no node drops are ignored.
+//
+// Writes the raids, sorted by battle ID, to `raids`, their number to
+// *num_raids and their energy to *energy. If there are more than
+// `raids_capacity` raids, only *num_raids is written and this returns
+// DATAMINER_BUFFER_TOO_SMALL.
+//
+// Unlike the other queries, this allocates the solver's working memory.
+DATAMINER_EXPORT dataminer_status dataminer_plan_farming(
+    const dataminer_snapshot* snapshot, const dataminer_material_count* needs,
+    size_t num_needs, const char* const* roster, size_t roster_size,
+    int32_t days, dataminer_raid* raids, size_t raids_capacity,
+    size_t* num_raids, int64_t* energy);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // __MINER_C_API_H__
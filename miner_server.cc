@@ -0,0 +1,306 @@
+// A resident version of the miner, for answering planner questions without
+// re-running :miner or re-parsing its outputs. It loads the GameConfig once,
+// builds every index over it, and then answers queries over a Unix domain
+// socket, one line of JSON per query and one line of JSON per response. See
+// query_handler.h for the queries.
+//
+// bazel run -c opt :miner_server --
+//   --game_config=gameconfig_1_31.json
+//   --i18n_strings_json=I2Languages_en.json
+//   --socket=/tmp/miner.sock
+//
+// and then, e.g.
+//
+// echo '{"type":"drops","material":"upgArmC001"}' | nc -U /tmp/miner.sock
+//
+// Every --reload_interval, the server checks whether the gameconfig or i18n
+// file has changed. If either has, it loads both into a new snapshot and
+// swaps that in once it's ready. Queries that already started finish against
+// the old snapshot, and the old one goes away with the last of them. If the
+// new files don't load, the old snapshot stays and the error is logged.
+// Replace the files with a rename, so the server never sees one half written.
+//
+// Every connection is served on its own thread, so a client that stays
+// connected never keeps the others waiting.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "miner_snapshot.h"
+#include "query_handler.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, game_config, "", "The GameConfig.json file to serve.");
+ABSL_FLAG(std::string, i18n_strings_json, "",
+          "The json file with the i18n'd display strings for things like the "
+          "characters' names and titles.");
+ABSL_FLAG(std::string, socket, "/tmp/miner.sock",
+          "The path of the Unix domain socket to listen on. An existing file "
+          "there is replaced.");
+ABSL_FLAG(absl::Duration, reload_interval, absl::Seconds(5),
+          "How often to check the gameconfig and i18n files for changes.");
+ABSL_FLAG(int, max_query_bytes, 1 << 20,
+          "The longest query line to accept. A connection that sends a "
+          "longer one gets an error response and is closed.");
+
+namespace dataminer {
+
+namespace {
+
+// The snapshot queries are answered from. Readers take their own reference,
+// so swapping in a new one never pulls the old one out from under them.
+class SnapshotHolder {
+ public:
+  explicit SnapshotHolder(std::shared_ptr<const MinerSnapshot> snapshot)
+      : snapshot_(std::move(snapshot)) {}
+
+  std::shared_ptr<const MinerSnapshot> Get() const {
+    absl::MutexLock lock(&mu_);
+    return snapshot_;
+  }
+
+  void Set(std::shared_ptr<const MinerSnapshot> snapshot) {
+    {
+      absl::MutexLock lock(&mu_);
+      snapshot_.swap(snapshot);
+    }
+    // If no query holds the old snapshot, it's destroyed here, outside the
+    // lock.
+  }
+
+ private:
+  mutable absl::Mutex mu_;
+  std::shared_ptr<const MinerSnapshot> snapshot_ ABSL_GUARDED_BY(mu_);
+};
+
+// Counts the connections being served, so that Main can wait for them before
+// the snapshot goes away.
+class OpenConnections {
+ public:
+  void Add() {
+    absl::MutexLock lock(&mu_);
+    ++open_;
+  }
+
+  void Done() {
+    absl::MutexLock lock(&mu_);
+    --open_;
+  }
+
+  void WaitForAll() {
+    absl::MutexLock lock(&mu_);
+    mu_.Await(absl::Condition(
+        +[](int* open) { return *open == 0; }, &open_));
+  }
+
+ private:
+  absl::Mutex mu_;
+  int open_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+absl::StatusOr<std::filesystem::file_time_type> ModifiedTime(
+    const std::string& path) {
+  std::error_code error;
+  const std::filesystem::file_time_type time =
+      std::filesystem::last_write_time(path, error);
+  if (error) {
+    return absl::NotFoundError(
+        absl::StrCat("Can't stat '", path, "': ", error.message()));
+  }
+  return time;
+}
+
+// The mtimes of the files a snapshot is loaded from. Without an i18n file,
+// its time stays at the default.
+struct InputTimes {
+  std::filesystem::file_time_type game_config;
+  std::filesystem::file_time_type i18n;
+
+  bool operator==(const InputTimes& other) const {
+    return game_config == other.game_config && i18n == other.i18n;
+  }
+};
+
+absl::StatusOr<InputTimes> ModifiedTimes(const std::string& game_config_path,
+                                         const std::string& i18n_path) {
+  InputTimes times;
+  ASSIGN_OR_RETURN(times.game_config, ModifiedTime(game_config_path));
+  if (!i18n_path.empty()) {
+    ASSIGN_OR_RETURN(times.i18n, ModifiedTime(i18n_path));
+  }
+  return times;
+}
+
+// Swaps in a new snapshot whenever the gameconfig or i18n file's mtime moves,
+// until `stop` is notified.
+void WatchGameConfig(const std::string& game_config_path,
+                     const std::string& i18n_path, InputTimes loaded_times,
+                     const absl::Duration interval,
+                     const absl::Notification& stop, SnapshotHolder& holder) {
+  while (!stop.WaitForNotificationWithTimeout(interval)) {
+    const absl::StatusOr<InputTimes> times =
+        ModifiedTimes(game_config_path, i18n_path);
+    if (!times.ok() || *times == loaded_times) continue;
+    // Files that fail to load are only tried again once one changes.
+    loaded_times = *times;
+    LOG(INFO) << "The gameconfig or i18n file changed; reloading.";
+    absl::StatusOr<std::unique_ptr<const MinerSnapshot>> snapshot =
+        MinerSnapshot::Load(game_config_path, i18n_path);
+    if (!snapshot.ok()) {
+      LOG(ERROR) << "Error reloading GameConfig, still serving the old one: "
+                 << snapshot.status().message();
+      continue;
+    }
+    holder.Set(*std::move(snapshot));
+    LOG(INFO) << "Now serving the new GameConfig.";
+  }
+}
+
+bool WriteAll(const int fd, absl::string_view data) {
+  while (!data.empty()) {
+    const ssize_t written = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data.remove_prefix(written);
+  }
+  return true;
+}
+
+// Answers the queries on one connection until the client closes it. Every
+// complete line read is answered before reading more, and responses go out
+// in the order the queries came in. A line longer than `max_query_bytes`
+// gets an error response and closes the connection, so a client that never
+// sends a newline can't grow the buffer without limit.
+void ServeConnection(const int fd, const size_t max_query_bytes,
+                     const SnapshotHolder& holder) {
+  std::string pending;
+  std::string responses;
+  char buffer[1 << 16];
+  while (true) {
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    pending.append(buffer, n);
+    responses.clear();
+    size_t start = 0;
+    for (size_t end = pending.find('\n'); end != std::string::npos;
+         start = end + 1, end = pending.find('\n', start)) {
+      const absl::string_view line = absl::StripTrailingAsciiWhitespace(
+          absl::string_view(pending).substr(start, end - start));
+      if (line.empty()) continue;
+      absl::StrAppend(&responses, HandleQuery(*holder.Get(), line), "\n");
+    }
+    pending.erase(0, start);
+    if (pending.size() > max_query_bytes) {
+      absl::StrAppend(&responses, R"({"ok":false,"error":"Query longer than )",
+                      max_query_bytes, R"( bytes."})", "\n");
+      WriteAll(fd, responses);
+      break;
+    }
+    if (!WriteAll(fd, responses)) break;
+  }
+  close(fd);
+}
+
+absl::StatusOr<int> Listen(const std::string& path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The socket path '", path, "' is too long."));
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return absl::ErrnoToStatus(errno, "socket");
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(fd, SOMAXCONN) < 0) {
+    const int error = errno;
+    close(fd);
+    return absl::ErrnoToStatus(error,
+                               absl::StrCat("Listening on '", path, "'"));
+  }
+  return fd;
+}
+
+absl::Status Main() {
+  const std::string game_config_path = absl::GetFlag(FLAGS_game_config);
+  const std::string i18n_path = absl::GetFlag(FLAGS_i18n_strings_json);
+  const std::string socket_path = absl::GetFlag(FLAGS_socket);
+
+  InputTimes loaded_times;
+  ASSIGN_OR_RETURN(loaded_times, ModifiedTimes(game_config_path, i18n_path));
+  absl::StatusOr<std::unique_ptr<const MinerSnapshot>> snapshot =
+      MinerSnapshot::Load(game_config_path, i18n_path);
+  if (!snapshot.ok()) return snapshot.status();
+  SnapshotHolder holder(*std::move(snapshot));
+
+  int listen_fd;
+  ASSIGN_OR_RETURN(listen_fd, Listen(socket_path));
+  LOG(INFO) << "Serving '" << game_config_path << "' on " << socket_path;
+
+  absl::Notification stop;
+  std::thread watcher(WatchGameConfig, game_config_path, i18n_path,
+                      loaded_times, absl::GetFlag(FLAGS_reload_interval),
+                      std::cref(stop), std::ref(holder));
+  const size_t max_query_bytes = absl::GetFlag(FLAGS_max_query_bytes);
+  OpenConnections connections;
+  absl::Status status;
+  while (true) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      status = absl::ErrnoToStatus(errno, "accept");
+      break;
+    }
+    connections.Add();
+    std::thread([fd, max_query_bytes, &holder, &connections] {
+      ServeConnection(fd, max_query_bytes, holder);
+      connections.Done();
+    }).detach();
+  }
+  close(listen_fd);
+  connections.WaitForAll();
+  stop.Notify();
+  watcher.join();
+  return status;
+}
+
+}  // namespace
+
+}  // namespace dataminer
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const absl::Status status = dataminer::Main();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
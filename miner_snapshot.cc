@@ -0,0 +1,54 @@
+#include "miner_snapshot.h"
+
+#include <utility>
+
+#include "campaign_tables.h"
+#include "game_config_loader.h"
+
+namespace dataminer {
+
+absl::StatusOr<std::unique_ptr<const MinerSnapshot>> MinerSnapshot::Create(
+    ArenaGameConfig config) {
+  absl::StatusOr<RecipeGraph> graph =
+      RecipeGraph::Build(config.config().client_game_config().upgrades());
+  if (!graph.ok()) return graph.status();
+  return std::unique_ptr<const MinerSnapshot>(
+      new MinerSnapshot(std::move(config), *std::move(graph)));
+}
+
+absl::StatusOr<std::unique_ptr<const MinerSnapshot>> MinerSnapshot::Load(
+    const absl::string_view game_config_path,
+    const absl::string_view i18n_path) {
+  absl::StatusOr<ArenaGameConfig> config =
+      LoadGameConfig(game_config_path, i18n_path);
+  if (!config.ok()) return config.status();
+  return Create(*std::move(config));
+}
+
+MinerSnapshot::MinerSnapshot(ArenaGameConfig arena_config, RecipeGraph graph)
+    : config_(std::move(arena_config)),
+      index_(config_.config()),
+      graph_(std::move(graph)),
+      rank_ups_(
+          RankUpQuery::Build(config().client_game_config().units(), graph_)),
+      drops_(MaterialDropIndex::Build(config().client_game_config().battles(),
+                                      graph_)),
+      costs_(CostRollup::Build(config().client_game_config(), graph_)),
+      farming_(drops_, index_),
+      crafting_(graph_) {
+  for (const Campaign* campaign :
+       MaterialDropIndex::Campaigns(config().client_game_config().battles())) {
+    for (const Campaign::Battle& battle : campaign->battles()) {
+      nodes_.try_emplace(GetPlannerBattleId(campaign->id(), battle.id()),
+                         Node{campaign, &battle});
+    }
+  }
+}
+
+const MinerSnapshot::Node* MinerSnapshot::FindNode(
+    const absl::string_view battle_id) const {
+  const auto it = nodes_.find(battle_id);
+  return it == nodes_.end() ? nullptr : &it->second;
+}
+
+}  // namespace dataminer
@@ -0,0 +1,77 @@
+#ifndef __MINER_SNAPSHOT_H__
+#define __MINER_SNAPSHOT_H__
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "cost_rollup.h"
+#include "craft_solver.h"
+#include "farming_planner.h"
+#include "game_config_index.h"
+#include "game_config_loader.h"
+#include "material_drop_index.h"
+#include "miner.pb.h"
+#include "rank_up_query.h"
+#include "recipe_graph.h"
+
+namespace dataminer {
+
+// One parsed GameConfig together with every index and engine built over it,
+// for callers that answer many queries against the same config (the query
+// server, the C API and batch mode).
+//
+// A snapshot is immutable once created, so it can be shared between threads.
+// To switch to a new config, load a new snapshot and swap the pointer to it;
+// queries already running on the old one keep it alive until they finish.
+class MinerSnapshot {
+ public:
+  // Where a campaign node is in the config.
+  struct Node {
+    const Campaign* campaign;
+    const Campaign::Battle* battle;
+  };
+
+  static absl::StatusOr<std::unique_ptr<const MinerSnapshot>> Create(
+      ArenaGameConfig config);
+
+  // Loads a snapshot from the files LoadGameConfig takes.
+  static absl::StatusOr<std::unique_ptr<const MinerSnapshot>> Load(
+      absl::string_view game_config_path, absl::string_view i18n_path);
+
+  MinerSnapshot(const MinerSnapshot&) = delete;
+  MinerSnapshot& operator=(const MinerSnapshot&) = delete;
+
+  const GameConfig& config() const { return config_.config(); }
+  const GameConfigIndex& index() const { return index_; }
+  const RecipeGraph& graph() const { return graph_; }
+  const RankUpQuery& rank_ups() const { return rank_ups_; }
+  const MaterialDropIndex& drops() const { return drops_; }
+  const CostRollup& costs() const { return costs_; }
+  const FarmingPlanner& farming() const { return farming_; }
+  const CraftSolver& crafting() const { return crafting_; }
+
+  // Finds a campaign node by the planner's name for it, e.g. "FoCE12".
+  // Returns null if there's no such node.
+  const Node* FindNode(absl::string_view battle_id) const;
+
+ private:
+  MinerSnapshot(ArenaGameConfig arena_config, RecipeGraph graph);
+
+  // The config stays put on its arena, so everything below can point into it.
+  const ArenaGameConfig config_;
+  const GameConfigIndex index_;
+  const RecipeGraph graph_;
+  const RankUpQuery rank_ups_;
+  const MaterialDropIndex drops_;
+  const CostRollup costs_;
+  const FarmingPlanner farming_;
+  const CraftSolver crafting_;
+  absl::flat_hash_map<std::string, Node> nodes_;
+};
+
+}  // namespace dataminer
+
+#endif  // __MINER_SNAPSHOT_H__
@@ -0,0 +1,276 @@
+#include "output_writer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "metrics.h"
+
+ABSL_FLAG(std::string, output_format, "pretty",
+          "How to format JSON outputs: 'pretty' keeps the indented layout, "
+          "'compact' strips all whitespace outside of strings.");
+ABSL_FLAG(bool, gzip_outputs, false,
+          "If true, every JSON output also gets a gzipped sibling with a "
+          "'.gz' suffix, for serving precompressed to the planner.");
+
+namespace dataminer {
+
+namespace {
+
+// The size of the buffers fed to and drained from deflate.
+constexpr size_t kDeflateChunkSize = 64 * 1024;
+
+struct OutputRecord {
+  std::string path;
+  bool changed;
+};
+
+class OutputRegistry {
+ public:
+  static OutputRegistry& Get() {
+    static OutputRegistry* registry = new OutputRegistry();
+    return *registry;
+  }
+
+  void Record(const absl::string_view path, const bool changed) {
+    absl::MutexLock lock(&mu_);
+    records_.push_back({std::string(path), changed});
+  }
+
+  std::vector<OutputRecord> Records() {
+    absl::MutexLock lock(&mu_);
+    return records_;
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::vector<OutputRecord> records_ ABSL_GUARDED_BY(mu_);
+};
+
+absl::Status ErrnoError(const absl::string_view what,
+                        const absl::string_view path) {
+  return absl::UnavailableError(
+      absl::StrCat(what, " '", path, "': ", std::strerror(errno)));
+}
+
+// Returns true if the file at `path` holds exactly `contents`. A missing or
+// unreadable file is treated as different.
+bool MatchesExisting(const std::string& path,
+                     const absl::string_view contents) {
+  static Counter& stat_calls = Metrics::Get().GetCounter(
+      "miner_stat_calls_total", "stat() calls made to check outputs.");
+  stat_calls.Increment();
+  struct stat sbuf;
+  if (stat(path.c_str(), &sbuf) != 0) return false;
+  // Most changes alter the size, which lets us skip reading the old file.
+  if (static_cast<size_t>(sbuf.st_size) != contents.size()) return false;
+
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) return false;
+  std::string existing(contents.size(), '\0');
+  const size_t read = fread(existing.data(), 1, existing.size(), fp);
+  fclose(fp);
+  if (read != existing.size()) return false;
+  return existing == contents;
+}
+
+// Flushes the directory holding `path`, which makes a rename into it
+// durable.
+absl::Status SyncDirectory(const std::string& path) {
+  std::string dir = std::filesystem::path(path).parent_path().string();
+  if (dir.empty()) dir = ".";
+  const int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) return ErrnoError("Couldn't open", dir);
+  const bool synced = fsync(fd) == 0;
+  const absl::Status status =
+      synced ? absl::OkStatus() : ErrnoError("Couldn't sync", dir);
+  close(fd);
+  return status;
+}
+
+// Writes `contents` to a temporary file next to `path` and renames it into
+// place. The file keeps the mode of the one it replaces, and it and the
+// rename are synced to disk, so a crash leaves either the old file or the
+// new one.
+absl::Status WriteAtomically(const std::string& path,
+                             const absl::string_view contents) {
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (fp == nullptr) return ErrnoError("Couldn't open", tmp_path);
+  const size_t written = fwrite(contents.data(), 1, contents.size(), fp);
+  bool ok = written == contents.size() && fflush(fp) == 0;
+  struct stat existing;
+  if (ok && stat(path.c_str(), &existing) == 0) {
+    ok = fchmod(fileno(fp), existing.st_mode & 07777) == 0;
+  }
+  ok = ok && fsync(fileno(fp)) == 0;
+  if (fclose(fp) != 0 || !ok) {
+    const absl::Status status = ErrnoError("Couldn't write", tmp_path);
+    std::remove(tmp_path.c_str());
+    return status;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    const absl::Status status = ErrnoError("Couldn't rename", tmp_path);
+    std::remove(tmp_path.c_str());
+    return status;
+  }
+  return SyncDirectory(path);
+}
+
+}  // namespace
+
+absl::Status WriteOutput(const absl::string_view path,
+                         const absl::string_view contents) {
+  if (path.empty()) {
+    std::cout << contents;
+    return absl::OkStatus();
+  }
+  static Histogram& sizes = Metrics::Get().GetHistogram(
+      "miner_output_size_bytes", "The sizes of the files written.",
+      ExponentialBuckets(1024, 4, 10));
+  sizes.Observe(contents.size());
+  Metrics::Get()
+      .GetGauge("miner_output_bytes", "Bytes emitted to each output file.",
+                {{"path", std::string(path)}})
+      .Set(contents.size());
+  const std::string path_str(path);
+  const bool changed = !MatchesExisting(path_str, contents);
+  if (changed) {
+    if (absl::Status status = WriteAtomically(path_str, contents);
+        !status.ok()) {
+      return status;
+    }
+  }
+  OutputRegistry::Get().Record(path, changed);
+  return absl::OkStatus();
+}
+
+absl::Status WriteJsonOutput(const absl::string_view path,
+                             const absl::string_view json) {
+  const std::string format = absl::GetFlag(FLAGS_output_format);
+  std::string compact;
+  absl::string_view contents = json;
+  if (format == "compact") {
+    compact = MinifyJson(json);
+    contents = compact;
+  } else if (format != "pretty") {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown --output_format: '", format, "'."));
+  }
+  if (absl::Status status = WriteOutput(path, contents); !status.ok()) {
+    return status;
+  }
+  if (path.empty() || !absl::GetFlag(FLAGS_gzip_outputs)) {
+    return absl::OkStatus();
+  }
+  absl::StatusOr<std::string> gzipped = Gzip(contents);
+  if (!gzipped.ok()) return gzipped.status();
+  return WriteOutput(absl::StrCat(path, ".gz"), *gzipped);
+}
+
+std::string OutputOptions() {
+  return absl::StrCat("output_format=", absl::GetFlag(FLAGS_output_format),
+                      " gzip_outputs=",
+                      absl::GetFlag(FLAGS_gzip_outputs) ? "true" : "false");
+}
+
+std::vector<std::string> OutputFiles(const absl::string_view path) {
+  const std::string gzipped = absl::StrCat(path, ".gz");
+  std::vector<std::string> files;
+  for (const OutputRecord& record : OutputRegistry::Get().Records()) {
+    if (record.path == path || record.path == gzipped) {
+      files.push_back(record.path);
+    }
+  }
+  return files;
+}
+
+std::string MinifyJson(const absl::string_view json) {
+  std::string out;
+  out.reserve(json.size());
+  bool in_string = false;
+  bool escaped = false;
+  for (const char c : json) {
+    if (in_string) {
+      out.push_back(c);
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        in_string = false;
+      }
+      continue;
+    }
+    if (c == ' ' || c == '\n' || c == '\t' || c == '\r') continue;
+    if (c == '"') in_string = true;
+    out.push_back(c);
+  }
+  // Keep the file newline-terminated, like the pretty output.
+  out.push_back('\n');
+  return out;
+}
+
+absl::StatusOr<std::string> Gzip(const absl::string_view data) {
+  z_stream stream = {};
+  // 15 window bits plus 16 selects the gzip wrapper. The header's mtime is
+  // left at zero, so identical input always produces identical bytes.
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16,
+                   /*memLevel=*/8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return absl::InternalError("Couldn't initialize deflate.");
+  }
+  std::string out;
+  char buffer[kDeflateChunkSize];
+  size_t offset = 0;
+  int result = Z_OK;
+  while (result != Z_STREAM_END) {
+    const size_t chunk = std::min(kDeflateChunkSize, data.size() - offset);
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + offset));
+    stream.avail_in = static_cast<uInt>(chunk);
+    offset += chunk;
+    const int flush = offset == data.size() ? Z_FINISH : Z_NO_FLUSH;
+    do {
+      stream.next_out = reinterpret_cast<Bytef*>(buffer);
+      stream.avail_out = sizeof(buffer);
+      result = deflate(&stream, flush);
+      if (result == Z_STREAM_ERROR) {
+        deflateEnd(&stream);
+        return absl::InternalError("deflate failed.");
+      }
+      out.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (stream.avail_out == 0);
+  }
+  deflateEnd(&stream);
+  return out;
+}
+
+std::string OutputSummary() {
+  std::vector<std::string> changed;
+  const std::vector<OutputRecord> records = OutputRegistry::Get().Records();
+  for (const OutputRecord& record : records) {
+    if (record.changed) changed.push_back(record.path);
+  }
+  if (changed.empty()) {
+    return absl::StrCat("0 of ", records.size(), " outputs changed.");
+  }
+  return absl::StrCat(changed.size(), " of ", records.size(),
+                      " outputs changed: ", absl::StrJoin(changed, ", "));
+}
+
+}  // namespace dataminer
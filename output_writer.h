@@ -0,0 +1,48 @@
+#ifndef __OUTPUT_WRITER_H__
+#define __OUTPUT_WRITER_H__
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace dataminer {
+
+// Writes `contents` to `path`, but only if the file doesn't already hold
+// exactly those bytes, so unchanged outputs keep their mtime. The new file is
+// written next to the old one, synced, and renamed into place with the old
+// one's mode, so readers never see a partially written file, even after a
+// crash. An empty path writes to stdout.
+//
+// Every call is recorded for OutputSummary(). Safe to call from multiple
+// threads, as long as no two calls share a path.
+absl::Status WriteOutput(absl::string_view path, absl::string_view contents);
+
+// Like WriteOutput, but for JSON artifacts. Honors --output_format, which can
+// strip the indentation the emitters produce, and --gzip_outputs, which also
+// writes a precompressed `<path>.gz` next to the JSON.
+absl::Status WriteJsonOutput(absl::string_view path, absl::string_view json);
+
+// The settings of the flags that change what WriteJsonOutput writes, so that
+// callers can tell when an output written with other settings is stale.
+std::string OutputOptions();
+
+// The files WriteOutput has written so far for the output at `path`: the
+// file itself, and its `.gz` sibling if WriteJsonOutput wrote one.
+std::vector<std::string> OutputFiles(absl::string_view path);
+
+// Returns `json` with all whitespace outside of strings removed.
+std::string MinifyJson(absl::string_view json);
+
+// Compresses `data` into the gzip format, streaming it through deflate in
+// fixed-size chunks.
+absl::StatusOr<std::string> Gzip(absl::string_view data);
+
+// Returns a one-line summary of which outputs WriteOutput changed so far.
+std::string OutputSummary();
+
+}  // namespace dataminer
+
+#endif  // __OUTPUT_WRITER_H__
@@ -6,11 +6,12 @@
 #include "miner.pb.h"
 #include "status_builder.h"
 #include "status_macros.h"
+#include "trace.h"
 
 namespace dataminer {
 
-absl::StatusOr<Avatars> ParseAvatars(const Json::Value& root) {
-  Avatars ret;
+absl::Status ParseAvatars(const Json::Value& root, Avatars& avatars) {
+  TRACE_SCOPE("ParseAvatars");
   RET_CHECK(root.isArray()) << "Parsed JSON for 'avatars' must be an array.";
   for (const Json::Value& avatar : root) {
     RET_CHECK(avatar.isObject() && avatar.isMember("avatarId") &&
@@ -22,11 +23,11 @@ absl::StatusOr<Avatars> ParseAvatars(const Json::Value& root) {
       // Skip premium avatars.
       continue;
     }
-    Avatars::Avatar& new_avatar = *ret.add_avatars();
+    Avatars::Avatar& new_avatar = *avatars.add_avatars();
     new_avatar.set_id(avatar["avatarId"].asString());
     new_avatar.set_unit_id(avatar["value"].asString());
   }
-  return ret;
+  return absl::OkStatus();
 }
 
 }  // namespace dataminer
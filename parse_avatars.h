@@ -1,13 +1,14 @@
 #ifndef __PARSE_AVATARS_H__
 #define __PARSE_AVATARS_H__
 
-#include "absl/status/statusor.h"
+#include "absl/status/status.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 
 namespace dataminer {
 
-absl::StatusOr<Avatars> ParseAvatars(const Json::Value& root);
+// Parses the game config's "avatars" into `avatars`, which should be empty.
+absl::Status ParseAvatars(const Json::Value& root, Avatars& avatars);
 
 }  // namespace dataminer
 
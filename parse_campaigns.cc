@@ -1,25 +1,29 @@
 #include "parse_campaigns.h"
 
 #include <iostream>
+#include <map>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
 #include "calculate_effective_drop_rate.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 #include "status_macros.h"
+#include "trace.h"
 
 namespace dataminer {
 
 namespace {
 
-absl::StatusOr<Campaign::Battle::GuaranteedRewardItem>
-ParseGuaranteedRewardItem(absl::string_view item) {
+absl::Status ParseGuaranteedRewardItem(
+    absl::string_view item,
+    Campaign::Battle::GuaranteedRewardItem& reward_item) {
   item = absl::StripAsciiWhitespace(item);
-  Campaign::Battle::GuaranteedRewardItem reward_item;
   if (item.empty()) {
     return absl::InvalidArgumentError("Reward item cannot be empty.");
   }
@@ -51,12 +55,11 @@ ParseGuaranteedRewardItem(absl::string_view item) {
       reward_item.set_max(max_value);
     }
   }
-  return reward_item;
+  return absl::OkStatus();
 }
 
-absl::StatusOr<Campaign::Battle::PotentialRewardItem> ParsePotentialRewardItem(
-    const absl::string_view item) {
-  Campaign::Battle::PotentialRewardItem ret;
+absl::Status ParsePotentialRewardItem(
+    const absl::string_view item, Campaign::Battle::PotentialRewardItem& ret) {
   const auto mod_index = item.find('%');
   RET_CHECK(mod_index != absl::string_view::npos)
       << "Potential reward item must end with '%A/B'.";
@@ -78,35 +81,91 @@ absl::StatusOr<Campaign::Battle::PotentialRewardItem> ParsePotentialRewardItem(
   ret.set_chance_denominator(chance_denominator);
   ret.set_effective_rate(CalculateEffectiveDropRate(ret.chance_numerator(),
                                                     ret.chance_denominator()));
-  return ret;
+  return absl::OkStatus();
 }
 
-absl::StatusOr<Campaign::Battle::Reward> ParseBattleReward(
-    const Json::Value& reward) {
-  Campaign::Battle::Reward battle_reward;
-
+absl::Status ParseBattleReward(const Json::Value& reward,
+                               Campaign::Battle::Reward& battle_reward) {
   if (reward.isMember("base")) {
     const Json::Value& base = reward["base"];
     RET_CHECK(base.isArray()) << "Battle reward 'base' must be an array.";
     for (const Json::Value& item : base) {
       RET_CHECK(item.isString()) << "Each item in 'base' must be a string.";
-      ASSIGN_OR_RETURN(*battle_reward.add_base(),
-                       ParseGuaranteedRewardItem(item.asString()));
+      RETURN_IF_ERROR(ParseGuaranteedRewardItem(item.asString(),
+                                                *battle_reward.add_base()));
     }
   }
   if (reward.isMember("chanceOf")) {
     const Json::Value& chance_of = reward["chanceOf"];
     RET_CHECK(chance_of.isString())
         << "Battle reward 'chanceOf' must be a string.";
-    ASSIGN_OR_RETURN(*battle_reward.mutable_chance_of(),
-                     ParsePotentialRewardItem(chance_of.asString()));
+    RETURN_IF_ERROR(ParsePotentialRewardItem(
+        chance_of.asString(), *battle_reward.mutable_chance_of()));
   }
-  return battle_reward;
+  return absl::OkStatus();
 }
 
-absl::StatusOr<Campaign::Battle> ParseCampaignBattle(const Json::Value& battle,
-                                                     Campaign& campaign) {
-  Campaign::Battle campaign_battle;
+// Maps an NPC's ID to its index in Units.npcs.
+using NpcIndices = absl::flat_hash_map<absl::string_view, int>;
+
+// Resolves the raw "npcId:level" strings in `battle.enemies()` into
+// `battle.enemy_refs`, applying the corrections Snowprint's data needs.
+void ResolveEnemies(const Units& units, const NpcIndices& npc_indices,
+                    Campaign::Battle& battle) {
+  std::map<absl::string_view, int> enemies;
+  for (const absl::string_view enemy : battle.enemies()) {
+    enemies[enemy]++;
+  }
+  for (const auto& [enemy, count] : enemies) {
+    if (enemy == "powupHealth") continue;
+    const auto colon = enemy.find(':');
+    if (colon == absl::string_view::npos) {
+      LOG(ERROR) << "Invalid enemy format: " << enemy;
+      continue;
+    }
+    const absl::string_view npc_id = enemy.substr(0, colon);
+    int raw_level;
+    if (!absl::SimpleAtoi(enemy.substr(colon + 1), &raw_level)) {
+      LOG(ERROR) << "Invalid level format for enemy: " << enemy;
+      continue;
+    }
+    int level = raw_level;
+    // For whatever reason, SP made the boss indices 1-based, but the
+    // normal-NPC indices 0 based.
+    const bool boss = absl::StrContains(enemy, "Boss");
+    if (boss) level -= 1;
+    // Some random NPC goes out of bounds.
+    const bool ftue = npc_id == "necroNpc1TutWarriorFTUEtest";
+    if (ftue) level -= 1;
+    const auto it = npc_indices.find(npc_id);
+    if (it == npc_indices.end()) {
+      LOG(ERROR) << "Unknown NPC id: " << npc_id;
+      continue;
+    }
+    const Npc& npc = units.npcs(it->second);
+    if (level < 0) {
+      LOG(ERROR) << "NPC " << npc_id << " has negative level: " << level;
+      continue;
+    }
+    // The ref is only added once it's known to be valid, so it can be built
+    // in place.
+    Campaign::Battle::EnemyRef& ref = *battle.add_enemy_refs();
+    ref.set_raw_level(raw_level);
+    if (boss) ref.add_corrections(Campaign::Battle::EnemyRef::BOSS_ONE_BASED);
+    if (ftue) ref.add_corrections(Campaign::Battle::EnemyRef::FTUE_OFF_BY_ONE);
+    if (level >= npc.stats_size()) {
+      level = npc.stats_size() - 1;
+      ref.add_corrections(Campaign::Battle::EnemyRef::CLAMPED_TO_MAX);
+    }
+    ref.set_npc_index(it->second);
+    ref.set_level(level);
+    ref.set_count(count);
+  }
+}
+
+absl::Status ParseCampaignBattle(const Json::Value& battle, const Units& units,
+                                 const NpcIndices& npc_indices,
+                                 Campaign::Battle& campaign_battle) {
   RET_CHECK(battle.isObject()) << "Each battle must be an object.";
   RET_CHECK(battle.isMember("battleId") && battle["battleId"].isString())
       << "Each battle must have a 'battleId' string.";
@@ -156,16 +215,16 @@ absl::StatusOr<Campaign::Battle> ParseCampaignBattle(const Json::Value& battle,
       }
     }
   }
+  ResolveEnemies(units, npc_indices, campaign_battle);
   if (battle.isMember("loot") && battle["loot"].isObject()) {
-    ASSIGN_OR_RETURN(*campaign_battle.mutable_reward(),
-                     ParseBattleReward(battle["loot"]));
+    RETURN_IF_ERROR(
+        ParseBattleReward(battle["loot"], *campaign_battle.mutable_reward()));
   }
-  return campaign_battle;
+  return absl::OkStatus();
 }
 
-absl::StatusOr<Campaign> ParseCampaign(const Json::Value& campaign) {
-  Campaign ret;
-
+absl::Status ParseCampaign(const Json::Value& campaign, const Units& units,
+                           const NpcIndices& npc_indices, Campaign& ret) {
   RET_CHECK(campaign.isObject()) << "Campaign must be an object.";
   RET_CHECK(campaign.isMember("id")) << "Campaign is missing 'id'.";
   RET_CHECK(campaign.isMember("battles")) << "Campaign is missing 'battles'.";
@@ -181,19 +240,34 @@ absl::StatusOr<Campaign> ParseCampaign(const Json::Value& campaign) {
         << "Each faction in 'allowedFactions' must be a string.";
     ret.add_allowed_factions(faction.asString());
   }
-  Json::Value battles = campaign["battles"];
+  const Json::Value& battles = campaign["battles"];
   RET_CHECK(battles.isArray()) << "Campaign 'battles' must be an array.";
   for (const Json::Value& battle : battles) {
-    ASSIGN_OR_RETURN(*ret.add_battles(), ParseCampaignBattle(battle, ret));
+    RETURN_IF_ERROR(
+        ParseCampaignBattle(battle, units, npc_indices, *ret.add_battles()));
   }
+  return absl::OkStatus();
+}
 
-  return ret;
+// Adds a campaign to the list in `battles` for campaigns of `type`, one of
+// kCampaignTypes.
+Campaign* AddCampaign(const absl::string_view type, Battles& battles) {
+  if (type == "Elite") return battles.add_elite_campaigns();
+  if (type == "EliteMirror") return battles.add_mirror_elite_campaigns();
+  if (type == "Event") return battles.add_campaign_events();
+  if (type == "Mirror") return battles.add_mirror_campaigns();
+  return battles.add_standard_campaigns();
 }
 
 }  // namespace
 
-absl::StatusOr<Battles> ParseCampaigns(const Json::Value& root) {
-  Battles battles;
+absl::Status ParseCampaigns(const Json::Value& root, const Units& units,
+                            Battles& battles) {
+  TRACE_SCOPE("ParseCampaigns");
+  NpcIndices npc_indices;
+  for (int i = 0; i < units.npcs_size(); ++i) {
+    npc_indices.try_emplace(units.npcs(i).id(), i);
+  }
   RET_CHECK(root.isObject()) << "Parsed JSON for 'battles' must be an object.";
   RET_CHECK(root.isMember("campaigns")) << "Missing 'campaigns' in JSON.";
   const Json::Value& campaignsContainer = root["campaigns"];
@@ -208,22 +282,11 @@ absl::StatusOr<Battles> ParseCampaigns(const Json::Value& root) {
     for (const Json::Value& campaign : campaigns) {
       RET_CHECK(campaign.isObject())
           << "Each item in '" << type << "' must be an object.";
-      Campaign new_campaign;
-      ASSIGN_OR_RETURN(new_campaign, ParseCampaign(campaign));
-      if (type == "Elite") {
-        *battles.add_elite_campaigns() = new_campaign;
-      } else if (type == "EliteMirror") {
-        *battles.add_mirror_elite_campaigns() = new_campaign;
-      } else if (type == "Event") {
-        *battles.add_campaign_events() = new_campaign;
-      } else if (type == "Mirror") {
-        *battles.add_mirror_campaigns() = new_campaign;
-      } else if (type == "Standard") {
-        *battles.add_standard_campaigns() = new_campaign;
-      }
+      RETURN_IF_ERROR(ParseCampaign(campaign, units, npc_indices,
+                                    *AddCampaign(type, battles)));
     }
   }
-  return battles;
+  return absl::OkStatus();
 }
 
 }  // namespace dataminer
@@ -1,13 +1,17 @@
 #ifndef __PARSE_CAMPAIGNS_H__
 #define __PARSE_CAMPAIGNS_H__
 
-#include "absl/status/statusor.h"
+#include "absl/status/status.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 
 namespace dataminer {
 
-absl::StatusOr<Battles> ParseCampaigns(const Json::Value& root);
+// Parses the campaigns in the game config's "battles" object into `battles`,
+// which should be empty. `units` must already be parsed; each battle's enemies
+// are resolved against its NPCs.
+absl::Status ParseCampaigns(const Json::Value& root, const Units& units,
+                            Battles& battles);
 
 }  // namespace dataminer
 
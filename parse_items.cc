@@ -11,11 +11,12 @@
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 #include "status_macros.h"
+#include "trace.h"
 
 namespace dataminer {
 
-absl::StatusOr<Item::Stats> ParseLevelStats(const absl::string_view item_name,
-                                            const Json::Value& root) {
+absl::Status ParseLevelStats(const absl::string_view item_name,
+                             const Json::Value& root, Item::Stats& stats) {
   struct Stat {
     absl::string_view name;
     std::function<void(Item::Stats&, int)> setter;
@@ -32,7 +33,6 @@ absl::StatusOr<Item::Stats> ParseLevelStats(const absl::string_view item_name,
       {"fixedArmor", std::mem_fn(&Item::Stats::set_fixed_armor)},
       {"hp", std::mem_fn(&Item::Stats::set_hp)},
   };
-  Item::Stats stats;
   for (const Stat& stat : kStats) {
     if (root.isMember(stat.name)) {
       RET_CHECK(root[stat.name].isInt())
@@ -40,7 +40,7 @@ absl::StatusOr<Item::Stats> ParseLevelStats(const absl::string_view item_name,
       stat.setter(stats, root[stat.name].asInt());
     }
   }
-  return stats;
+  return absl::OkStatus();
 }
 
 absl::Status ParseLevels(Item& item, const Json::Value& array) {
@@ -67,15 +67,14 @@ absl::Status ParseLevels(Item& item, const Json::Value& array) {
 
     RET_CHECK(level.isMember("stats") && level["stats"].isObject())
         << "Item level stats must be an object - item" << item.id();
-    ASSIGN_OR_RETURN(*item_level.mutable_stats(),
-                     ParseLevelStats(item.id(), level["stats"]));
+    RETURN_IF_ERROR(ParseLevelStats(item.id(), level["stats"],
+                                    *item_level.mutable_stats()));
   }
   return absl::OkStatus();
 }
 
-absl::StatusOr<Item> ParseItem(const absl::string_view item_name,
-                               const Json::Value& root) {
-  Item item;
+absl::Status ParseItem(const absl::string_view item_name,
+                       const Json::Value& root, Item& item) {
   item.set_id(item_name);
   if (root.isMember("abilityId")) {
     RET_CHECK(root["abilityId"].isString())
@@ -126,18 +125,16 @@ absl::StatusOr<Item> ParseItem(const absl::string_view item_name,
 
   RET_CHECK(root.isMember("levels") && root["levels"].isArray())
       << "levels of item must be an array - item=" << item_name;
-  RETURN_IF_ERROR(ParseLevels(item, root["levels"]));
-  return item;
+  return ParseLevels(item, root["levels"]);
 }
 
-absl::StatusOr<Items> ParseItems(const Json::Value& root) {
-  Items items;
+absl::Status ParseItems(const Json::Value& root, Items& items) {
+  TRACE_SCOPE("ParseItems");
   RET_CHECK(root.isObject()) << "Parsed JSON for 'battles' must be an object.";
   for (const absl::string_view item_name : root.getMemberNames()) {
-    Item& item = *items.add_items();
-    ASSIGN_OR_RETURN(item, ParseItem(item_name, root[item_name]));
+    RETURN_IF_ERROR(ParseItem(item_name, root[item_name], *items.add_items()));
   }
-  return items;
+  return absl::OkStatus();
 }
 
 }  // namespace dataminer
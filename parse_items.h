@@ -1,13 +1,14 @@
 #ifndef __PARSE_ITEMS_H__
 #define __PARSE_ITEMS_H__
 
-#include "absl/status/statusor.h"
+#include "absl/status/status.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 
 namespace dataminer {
 
-absl::StatusOr<Items> ParseItems(const Json::Value& root);
+// Parses the game config's "items" into `items`, which should be empty.
+absl::Status ParseItems(const Json::Value& root, Items& items);
 
 }  // namespace dataminer
 
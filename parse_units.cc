@@ -10,15 +10,14 @@
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 #include "status_macros.h"
+#include "trace.h"
 
 namespace dataminer {
 
 namespace {
 
-absl::StatusOr<std::vector<Unit::RankUpRequirements>> ParseRankUpRequirements(
-    absl::string_view id, const Json::Value& root) {
-  std::vector<Unit::RankUpRequirements> requirements;
-
+absl::Status ParseRankUpRequirements(absl::string_view id,
+                                     const Json::Value& root, Unit& unit) {
   if (!root.isArray()) {
     return absl::InvalidArgumentError(absl::StrCat(
         "RankUpRequirements for unit '", id, "' is not an array."));
@@ -40,23 +39,21 @@ absl::StatusOr<std::vector<Unit::RankUpRequirements>> ParseRankUpRequirements(
                          "' element ", i, " is not a string."));
       }
     }
-    Unit::RankUpRequirements requirement;
+    Unit::RankUpRequirements& requirement = *unit.add_rank_up_requirements();
     requirement.set_top_row_health(rank_up[0].asString());
     requirement.set_bottom_row_health(rank_up[1].asString());
     requirement.set_top_row_damage(rank_up[2].asString());
     requirement.set_bottom_row_damage(rank_up[3].asString());
     requirement.set_top_row_armor(rank_up[4].asString());
     requirement.set_bottom_row_armor(rank_up[5].asString());
-    requirements.push_back(std::move(requirement));
   }
-
-  return requirements;
+  return absl::OkStatus();
 }
 
-absl::StatusOr<Unit> ParseUnit(const absl::string_view id,
-                               const Json::Value& root) {
-  Unit unit;
-
+// Parses the lineup entry `root` into `unit`. Returns Cancelled for a Machine
+// of War, which ParseUnits handles separately.
+absl::Status ParseUnit(const absl::string_view id, const Json::Value& root,
+                       Unit& unit) {
   const auto fields = {
       "BaseRarity",      "FactionId",        "GrandAllianceId", "Movement",
       "activeAbilities", "passiveAbilities", "itemSlots",       "name",
@@ -140,19 +137,11 @@ absl::StatusOr<Unit> ParseUnit(const absl::string_view id,
   unit.set_name(root["name"].asString());
   unit.set_id(id);
 
-  std::vector<Unit::RankUpRequirements> rank_up_requirements;
-  ASSIGN_OR_RETURN(rank_up_requirements,
-                   ParseRankUpRequirements(id, root["upgrades"]));
-  for (const auto& requirement : rank_up_requirements) {
-    *unit.add_rank_up_requirements() = requirement;
-  }
-
-  return unit;
+  return ParseRankUpRequirements(id, root["upgrades"], unit);
 }
 
-absl::StatusOr<Npc> ParseNpc(const absl::string_view id,
-                             const Json::Value& root) {
-  Npc npc;
+absl::Status ParseNpc(const absl::string_view id, const Json::Value& root,
+                      Npc& npc) {
   npc.set_id(id);
   constexpr absl::string_view kRequiredFields[] = {
       "activeAbilities", "name", "passiveAbilities", "traits", "weapons"};
@@ -211,13 +200,11 @@ absl::StatusOr<Npc> ParseNpc(const absl::string_view id,
       stats.set_stars(json_stats["StarLevel"].asInt());
     }
   }
-
-  return npc;
+  return absl::OkStatus();
 }
 
-absl::StatusOr<MachineOfWarUpgradeCosts> ParseUpgradeCost(
-    const Json::Value& root) {
-  MachineOfWarUpgradeCosts costs;
+absl::Status ParseUpgradeCost(const Json::Value& root,
+                              MachineOfWarUpgradeCosts& costs) {
   if (!root.isObject()) {
     return absl::InvalidArgumentError("Upgrade cost is not an object.");
   }
@@ -242,12 +229,13 @@ absl::StatusOr<MachineOfWarUpgradeCosts> ParseUpgradeCost(
           absl::StrCat("Unknown upgrade cost type: ", member));
     }
   }
-  return costs;
+  return absl::OkStatus();
 }
 
 }  // namespace
 
-absl::StatusOr<Units> ParseUnits(const Json::Value& root) {
+absl::Status ParseUnits(const Json::Value& root, Units& units) {
+  TRACE_SCOPE("ParseUnits");
   RET_CHECK(root.isObject()) << "Parsed JSON is not an object.";
   RET_CHECK(root.isMember("lineup")) << "Missing 'lineup' in JSON.";
   RET_CHECK(root.isMember("abilities")) << "Missing 'abilities' in JSON.";
@@ -257,28 +245,27 @@ absl::StatusOr<Units> ParseUnits(const Json::Value& root) {
       << "Missing 'damageProfileModifiers' in JSON.";
   RET_CHECK(root.isMember("xpLevels")) << "Missing 'xpLevels' in JSON.";
 
-  Units units;
-
   std::set<std::string> mows;
-  Json::Value lineup = root.get("lineup", {});
+  const Json::Value& lineup = root["lineup"];
   RET_CHECK(lineup.isObject()) << "'lineup' is not an object.";
   for (const absl::string_view id : lineup.getMemberNames()) {
-    Json::Value value = lineup.get(id, {});
+    const Json::Value& value = lineup[id];
     RET_CHECK(value.isObject())
         << "Lineup entry for '" << id << "' must be an object.";
 
-    absl::StatusOr<Unit> unit = ParseUnit(id, value);
-    if (absl::IsCancelled(unit.status())) {
+    const absl::Status status = ParseUnit(id, value, *units.add_units());
+    if (absl::IsCancelled(status)) {
       // Machine of War units are not supported.
+      units.mutable_units()->RemoveLast();
       mows.insert(std::string(id));
       continue;
     }
-    ASSIGN_OR_RETURN(*units.add_units(), unit);
+    RETURN_IF_ERROR(status);
   }
 
   if (!mows.empty()) {
     for (const auto& mow_id : mows) {
-      Json::Value mow_value = lineup.get(mow_id, {});
+      const Json::Value& mow_value = lineup[mow_id];
       RET_CHECK(mow_value.isObject())
           << "Machine of War entry for '" << mow_id << "' must be an object.";
       MachineOfWar& mow = *units.add_mows();
@@ -320,7 +307,7 @@ absl::StatusOr<Units> ParseUnits(const Json::Value& root) {
             << "Ability '" << abilities[i]->name()
             << "' for Machine of War entry '" << mow_id
             << "' is missing or not an array.";
-        const Json::Value upgrades = ability["upgrades"];
+        const Json::Value& upgrades = ability["upgrades"];
         if (upgrades.size() < 54) {
           LOG(ERROR) << "Ability '" << abilities[i]->name()
                      << "' for Machine of War entry '" << mow_id
@@ -342,13 +329,13 @@ absl::StatusOr<Units> ParseUnits(const Json::Value& root) {
     }
   }
 
-  Json::Value npcs = root.get("npc", {});
+  const Json::Value& npcs = root["npc"];
   RET_CHECK(npcs.isObject()) << "'npc' is not an object.";
   for (const absl::string_view id : npcs.getMemberNames()) {
-    Json::Value value = npcs.get(id, {});
+    const Json::Value& value = npcs[id];
     RET_CHECK(value.isObject())
         << "NPC entry for '" << id << "' must be an object.";
-    ASSIGN_OR_RETURN(*units.add_npcs(), ParseNpc(id, value));
+    RETURN_IF_ERROR(ParseNpc(id, value, *units.add_npcs()));
   }
 
   RET_CHECK(root["xpLevels"].isArray()) << "'xpLevels' is not an array.";
@@ -385,18 +372,17 @@ absl::StatusOr<Units> ParseUnits(const Json::Value& root) {
   for (const Json::Value& cost : root["abilityUpgradeCostsMoW"]) {
     RET_CHECK(cost.isObject())
         << "'abilityUpgradeCostsMoW' entry is not an object.";
-    MachineOfWarUpgradeCosts& new_cost = *units.add_mow_upgrade_costs();
-    ASSIGN_OR_RETURN(new_cost, ParseUpgradeCost(cost));
+    RETURN_IF_ERROR(ParseUpgradeCost(cost, *units.add_mow_upgrade_costs()));
   }
-
-  return units;
+  return absl::OkStatus();
 }
 
 absl::Status AmendUnitsWithDisplayStrings(const Json::Value& root,
                                           Units* units) {
+  TRACE_SCOPE("AmendUnitsWithDisplayStrings");
   std::map<std::string, std::string> full_names, short_names, shorter_names,
       titles, descs;
-  static std::map<std::string, std::map<std::string, std::string>*> suffixes = {
+  const std::map<std::string, std::map<std::string, std::string>*> suffixes = {
       {"_Name", &full_names},
       {"_ShortName", &short_names},
       {"_ExtraShortName", &shorter_names},
@@ -1,13 +1,14 @@
 #ifndef __PARSE_UNITS_H__
 #define __PARSE_UNITS_H__
 
-#include "absl/status/statusor.h"
+#include "absl/status/status.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 
 namespace dataminer {
 
-absl::StatusOr<Units> ParseUnits(const Json::Value& root);
+// Parses the game config's "units" into `units`, which should be empty.
+absl::Status ParseUnits(const Json::Value& root, Units& units);
 
 absl::Status AmendUnitsWithDisplayStrings(const Json::Value& root,
                                           Units* units);
@@ -5,14 +5,15 @@
 #include "absl/strings/string_view.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
+#include "trace.h"
 
 namespace dataminer {
 
 namespace {
 
-absl::StatusOr<Upgrades::Upgrade::Recipe> ParseUpgradeRecipe(
-    const absl::string_view id, const Json::Value& recipe) {
-  Upgrades::Upgrade::Recipe upgrade_recipe;
+absl::Status ParseUpgradeRecipe(const absl::string_view id,
+                                const Json::Value& recipe,
+                                Upgrades::Upgrade::Recipe& upgrade_recipe) {
   if (!recipe.isArray()) {
     return absl::InvalidArgumentError(
         absl::StrCat(id, ": Recipe is not an array."));
@@ -22,7 +23,6 @@ absl::StatusOr<Upgrades::Upgrade::Recipe> ParseUpgradeRecipe(
       return absl::InvalidArgumentError(
           absl::StrCat(id, ": Recipe item is not an object."));
     }
-    Upgrades::Upgrade::Recipe::Ingredient recipe_item;
     if (!item.isMember("id")) {
       return absl::InvalidArgumentError(
           absl::StrCat(id, ": Recipe item is missing 'id'."));
@@ -31,22 +31,23 @@ absl::StatusOr<Upgrades::Upgrade::Recipe> ParseUpgradeRecipe(
       return absl::InvalidArgumentError(
           absl::StrCat(id, ": Recipe item is missing 'amount'."));
     }
+    Upgrades::Upgrade::Recipe::Ingredient& recipe_item =
+        *upgrade_recipe.add_ingredients();
     recipe_item.set_id(item["id"].asString());
     recipe_item.set_amount(item["amount"].asInt());
-    *upgrade_recipe.add_ingredients() = std::move(recipe_item);
   }
-  return upgrade_recipe;
+  return absl::OkStatus();
 }
 
 }  // namespace
 
-absl::StatusOr<Upgrades> ParseUpgrades(const Json::Value& root) {
-  Upgrades upgrades;
+absl::Status ParseUpgrades(const Json::Value& root, Upgrades& upgrades) {
+  TRACE_SCOPE("ParseUpgrades");
   if (!root.isObject()) {
     return absl::InvalidArgumentError("Parsed JSON is not an object.");
   }
   for (const absl::string_view id : root.getMemberNames()) {
-    Json::Value value = root.get(id, {});
+    const Json::Value& value = root[id];
     if (id == "upgArmL008") {
       // Snowprint has two Transdimensional Sanctums, one is uncraftable with no
       // locations, the other is craftable. We ignore the uncraftable one.
@@ -75,16 +76,14 @@ absl::StatusOr<Upgrades> ParseUpgrades(const Json::Value& root) {
     upgrade.set_rarity(value.get("rarity", {}).asString());
     upgrade.set_stat_type(value.get("statType", {}).asString());
     if (value.isMember("crafting")) {
-      Json::Value recipe = value["crafting"];
-      absl::StatusOr<Upgrades::Upgrade::Recipe> recipe_status =
-          ParseUpgradeRecipe(id, recipe);
+      absl::Status recipe_status =
+          ParseUpgradeRecipe(id, value["crafting"], *upgrade.mutable_recipe());
       if (!recipe_status.ok()) {
-        return recipe_status.status();
+        return recipe_status;
       }
-      *upgrade.mutable_recipe() = std::move(*recipe_status);
     }
   }
-  return upgrades;
+  return absl::OkStatus();
 }
 
 }  // namespace dataminer
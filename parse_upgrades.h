@@ -1,13 +1,14 @@
 #ifndef __PARSE_UPGRADES_H__
 #define __PARSE_UPGRADES_H__
 
-#include "absl/status/statusor.h"
+#include "absl/status/status.h"
 #include "libjson/json/value.h"
 #include "miner.pb.h"
 
 namespace dataminer {
 
-absl::StatusOr<Upgrades> ParseUpgrades(const Json::Value& root);
+// Parses the game config's "upgrades" into `upgrades`, which should be empty.
+absl::Status ParseUpgrades(const Json::Value& root, Upgrades& upgrades);
 
 }  // namespace dataminer
 
@@ -0,0 +1,450 @@
+#include "query_handler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "craft_solver.h"
+#include "libjson/json/reader.h"
+#include "libjson/json/value.h"
+#include "libjson/json/writer.h"
+#include "status_macros.h"
+
+namespace dataminer {
+
+namespace {
+
+// Answers a query of one type. Fills `result` with the answer, or returns
+// why it can't.
+using Handler = absl::Status (*)(const MinerSnapshot& snapshot,
+                                 const Json::Value& query,
+                                 Json::Value& result);
+
+// The most of one material a query can name. It keeps the totals the
+// planner and the craft solver compute from it well inside an int64_t.
+constexpr int64_t kMaxCount = CraftSolver::kMaxCount;
+
+// Reads the string argument `name` of `query`.
+absl::StatusOr<std::string> GetString(const Json::Value& query,
+                                      const char* name) {
+  const Json::Value& value = query[name];
+  if (!value.isString()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected a string '", name, "'."));
+  }
+  return value.asString();
+}
+
+absl::StatusOr<Rank::Enum> GetRank(const Json::Value& query,
+                                   const char* name) {
+  std::string value;
+  ASSIGN_OR_RETURN(value, GetString(query, name));
+  Rank::Enum rank;
+  if (!Rank::Enum_Parse(value, &rank)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("'", value, "' isn't a rank."));
+  }
+  return rank;
+}
+
+Json::Value StringArray(
+    const google::protobuf::RepeatedPtrField<std::string>& strings) {
+  Json::Value array(Json::arrayValue);
+  for (const std::string& s : strings) array.append(s);
+  return array;
+}
+
+Json::Value AttackToJson(const Unit::Attack& attack) {
+  Json::Value json(Json::objectValue);
+  json["damageType"] = attack.damage_type();
+  json["hits"] = attack.hits();
+  json["range"] = attack.range();
+  return json;
+}
+
+// Writes `materials` as [{"material": ..., "rarity": ..., "count": ...}].
+Json::Value MaterialsToJson(const RecipeGraph& graph,
+                            const RecipeGraph::Materials& materials) {
+  Json::Value json(Json::arrayValue);
+  for (const RecipeGraph::MaterialCount& material : materials) {
+    const Upgrades::Upgrade& upgrade = graph.upgrade(material.material);
+    Json::Value& entry = json.append(Json::Value(Json::objectValue));
+    entry["material"] = upgrade.id();
+    entry["rarity"] = upgrade.rarity();
+    entry["count"] = Json::Int64{material.count};
+  }
+  return json;
+}
+
+// Reads the argument `name` of `query`, an object from upgrade ID to count,
+// into a list sorted by material. A missing argument is an empty list.
+absl::StatusOr<RecipeGraph::Materials> GetMaterials(const RecipeGraph& graph,
+                                                    const Json::Value& query,
+                                                    const char* name) {
+  RecipeGraph::Materials materials;
+  const Json::Value& value = query[name];
+  if (value.isNull()) return materials;
+  if (!value.isObject()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected '", name, "' to map upgrade IDs to counts."));
+  }
+  for (auto it = value.begin(); it != value.end(); ++it) {
+    const std::string id = it.name();
+    const int material = graph.Find(id);
+    if (material < 0) {
+      return absl::NotFoundError(
+          absl::StrCat("No upgrade material '", id, "'."));
+    }
+    // isInt64() first: asInt64() throws for anything out of its range.
+    if (!it->isInt64() || it->asInt64() < 0 || it->asInt64() > kMaxCount) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected a count of '", id, "' between 0 and ", kMaxCount, "."));
+    }
+    const RecipeGraph::MaterialCount count = {material, it->asInt64()};
+    RecipeGraph::Accumulate({&count, 1}, 1, materials);
+  }
+  return materials;
+}
+
+absl::StatusOr<RankUpQuery::Request> GetRankUp(const Json::Value& query,
+                                               std::string& unit) {
+  ASSIGN_OR_RETURN(unit, GetString(query, "unit"));
+  RankUpQuery::Request request;
+  request.unit_id = unit;
+  ASSIGN_OR_RETURN(request.from, GetRank(query, "from"));
+  ASSIGN_OR_RETURN(request.to, GetRank(query, "to"));
+  return request;
+}
+
+absl::Status HandleRankUp(const MinerSnapshot& snapshot,
+                          const Json::Value& query, Json::Value& result) {
+  std::string unit;
+  RankUpQuery::Request request;
+  ASSIGN_OR_RETURN(request, GetRankUp(query, unit));
+  RecipeGraph::Materials materials;
+  ASSIGN_OR_RETURN(materials, snapshot.rank_ups().Query(
+                                  request.unit_id, request.from, request.to));
+  result = MaterialsToJson(snapshot.graph(), materials);
+  return absl::OkStatus();
+}
+
+// Plans the raids for "needs", plus the base materials of every rank-up in
+// "rank_ups", optionally limited to a "roster" and a number of "days".
+absl::Status HandleFarm(const MinerSnapshot& snapshot, const Json::Value& query,
+                        Json::Value& result) {
+  RecipeGraph::Materials needs;
+  ASSIGN_OR_RETURN(needs, GetMaterials(snapshot.graph(), query, "needs"));
+  const Json::Value& rank_ups = query["rank_ups"];
+  if (!rank_ups.isNull()) {
+    if (!rank_ups.isArray()) {
+      return absl::InvalidArgumentError("Expected 'rank_ups' to be a list.");
+    }
+    // The requests point into `units`, so it's sized up front.
+    std::vector<std::string> units(rank_ups.size());
+    std::vector<RankUpQuery::Request> requests(rank_ups.size());
+    for (Json::ArrayIndex i = 0; i < rank_ups.size(); ++i) {
+      if (!rank_ups[i].isObject()) {
+        return absl::InvalidArgumentError(
+            "Expected 'rank_ups' to hold objects.");
+      }
+      ASSIGN_OR_RETURN(requests[i], GetRankUp(rank_ups[i], units[i]));
+    }
+    RecipeGraph::Materials materials;
+    ASSIGN_OR_RETURN(materials, snapshot.rank_ups().QueryBatch(requests));
+    RecipeGraph::Accumulate(materials, 1, needs);
+  }
+  FarmingPlanner::Options options;
+  const Json::Value& roster = query["roster"];
+  if (!roster.isNull() && !roster.isArray()) {
+    return absl::InvalidArgumentError("Expected 'roster' to be a list.");
+  }
+  for (const Json::Value& unit : roster) {
+    if (!unit.isString()) {
+      return absl::InvalidArgumentError("Expected unit IDs in 'roster'.");
+    }
+    options.roster.insert(unit.asString());
+  }
+  const Json::Value& days = query["days"];
+  if (!days.isNull() && (!days.isInt() || days.asInt() < 0)) {
+    return absl::InvalidArgumentError("Expected 'days' to be a count.");
+  }
+  options.days = days.asInt();
+
+  FarmingPlanner::Plan plan;
+  ASSIGN_OR_RETURN(plan, snapshot.farming().PlanFarming(needs, options));
+  Json::Value& raids = result["raids"] = Json::Value(Json::arrayValue);
+  for (const FarmingPlanner::Raids& raid : plan.raids) {
+    Json::Value& entry = raids.append(Json::Value(Json::objectValue));
+    entry["battle"] = std::string(raid.battle_id);
+    entry["count"] = Json::Int64{raid.count};
+  }
+  result["energy"] = Json::Int64{plan.energy};
+  result["fractionalEnergy"] = plan.fractional_energy;
+  result["unfarmable"] = MaterialsToJson(snapshot.graph(), plan.unfarmable);
+  return absl::OkStatus();
+}
+
+// With a "material", works out whether "inventory" can craft "count" (1 by
+// default) of it. Without one, lists everything "inventory" can craft.
+absl::Status HandleCraft(const MinerSnapshot& snapshot,
+                         const Json::Value& query, Json::Value& result) {
+  const RecipeGraph& graph = snapshot.graph();
+  RecipeGraph::Materials inventory;
+  ASSIGN_OR_RETURN(inventory, GetMaterials(graph, query, "inventory"));
+  if (!query.isMember("material")) {
+    result = MaterialsToJson(graph, snapshot.crafting().Craftable(inventory));
+    return absl::OkStatus();
+  }
+  std::string id;
+  ASSIGN_OR_RETURN(id, GetString(query, "material"));
+  const int material = graph.Find(id);
+  if (material < 0) {
+    return absl::NotFoundError(absl::StrCat("No upgrade material '", id, "'."));
+  }
+  const Json::Value& count = query.get("count", 1);
+  if (!count.isInt64() || count.asInt64() < 1 ||
+      count.asInt64() > kMaxCount) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected 'count' between 1 and ", kMaxCount, "."));
+  }
+  const CraftSolver::Result craft =
+      snapshot.crafting().Craft(inventory, material, count.asInt64());
+  result["feasible"] = craft.feasible;
+  result["used"] = MaterialsToJson(graph, craft.used);
+  result["crafted"] = MaterialsToJson(graph, craft.crafted);
+  result["shortfall"] = MaterialsToJson(graph, craft.shortfall);
+  result["maxCraftable"] =
+      Json::Int64{snapshot.crafting().MaxCraftable(inventory, material)};
+  return absl::OkStatus();
+}
+
+absl::Status HandleNode(const MinerSnapshot& snapshot, const Json::Value& query,
+                        Json::Value& result) {
+  std::string battle_id;
+  ASSIGN_OR_RETURN(battle_id, GetString(query, "battle"));
+  const MinerSnapshot::Node* node = snapshot.FindNode(battle_id);
+  if (node == nullptr) {
+    return absl::NotFoundError(
+        absl::StrCat("No campaign node '", battle_id, "'."));
+  }
+  const Campaign::Battle& battle = *node->battle;
+  result["campaign"] = node->campaign->id();
+  result["battle"] = battle_id;
+  result["energyCost"] = battle.energy_cost();
+  result["maxAttempts"] = battle.max_attempts();
+  result["requiredUnits"] = StringArray(battle.required_units());
+  result["enemies"] = StringArray(battle.enemies());
+  Json::Value& rewards = result["rewards"] = Json::Value(Json::arrayValue);
+  for (const Campaign::Battle::GuaranteedRewardItem& item :
+       battle.reward().base()) {
+    Json::Value& reward = rewards.append(Json::Value(Json::objectValue));
+    reward["id"] = item.id();
+    reward["min"] = item.min();
+    reward["max"] = item.max();
+  }
+  if (battle.reward().has_chance_of()) {
+    const Campaign::Battle::PotentialRewardItem& item =
+        battle.reward().chance_of();
+    Json::Value& reward = rewards.append(Json::Value(Json::objectValue));
+    reward["id"] = item.id();
+    // Spelled as in newCampaignData.json.
+    reward["chance_numerator"] = item.chance_numerator();
+    reward["chance_denominator"] = item.chance_denominator();
+    reward["effective_rate"] = item.effective_rate();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status HandleDrops(const MinerSnapshot& snapshot,
+                         const Json::Value& query, Json::Value& result) {
+  std::string material;
+  ASSIGN_OR_RETURN(material, GetString(query, "material"));
+  if (snapshot.graph().Find(material) < 0) {
+    return absl::NotFoundError(
+        absl::StrCat("No upgrade material '", material, "'."));
+  }
+  result = Json::Value(Json::arrayValue);
+  for (const MaterialDropIndex::Drop& drop : snapshot.drops().Drops(material)) {
+    Json::Value& entry = result.append(Json::Value(Json::objectValue));
+    entry["battle"] = drop.battle_id;
+    // Spelled and rounded as in the material drop file.
+    entry["energyCost"] = drop.energy_cost;
+    entry["effective_rate"] = drop.effective_rate;
+    entry["energyPerDrop"] = std::round(drop.energy_per_drop * 100) / 100;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status HandleUnit(const MinerSnapshot& snapshot, const Json::Value& query,
+                        Json::Value& result) {
+  std::string id;
+  ASSIGN_OR_RETURN(id, GetString(query, "unit"));
+  const Unit* unit = snapshot.index().FindUnit(id);
+  if (unit == nullptr) {
+    return absl::NotFoundError(absl::StrCat("No unit '", id, "'."));
+  }
+  result["id"] = unit->id();
+  result["name"] = unit->name();
+  result["fullName"] = unit->full_name();
+  result["faction"] = unit->faction_id();
+  result["alliance"] = unit->alliance();
+  result["baseRarity"] = unit->base_rarity();
+  result["movement"] = unit->movement();
+  result["damage"] = unit->stats().damage();
+  result["armor"] = unit->stats().armor();
+  result["health"] = unit->stats().health();
+  result["traits"] = StringArray(unit->traits());
+  result["activeAbilities"] = StringArray(unit->active_abilities());
+  result["passiveAbilities"] = StringArray(unit->passive_abilities());
+  if (unit->has_melee_attack()) {
+    result["meleeAttack"] = AttackToJson(unit->melee_attack());
+  }
+  if (unit->has_ranged_attack()) {
+    result["rangedAttack"] = AttackToJson(unit->ranged_attack());
+  }
+  return absl::OkStatus();
+}
+
+absl::Status HandleNpc(const MinerSnapshot& snapshot, const Json::Value& query,
+                       Json::Value& result) {
+  std::string id;
+  ASSIGN_OR_RETURN(id, GetString(query, "npc"));
+  const Npc* npc = snapshot.index().FindNpc(id);
+  if (npc == nullptr) {
+    return absl::NotFoundError(absl::StrCat("No NPC '", id, "'."));
+  }
+  result["id"] = npc->id();
+  result["name"] = npc->name();
+  result["faction"] = npc->faction_id();
+  result["alliance"] = npc->alliance();
+  result["movement"] = npc->movement();
+  result["traits"] = StringArray(npc->traits());
+  result["activeAbilities"] = StringArray(npc->active_abilities());
+  result["passiveAbilities"] = StringArray(npc->passive_abilities());
+  if (npc->has_melee_attack()) {
+    result["meleeAttack"] = AttackToJson(npc->melee_attack());
+  }
+  if (npc->has_ranged_attack()) {
+    result["rangedAttack"] = AttackToJson(npc->ranged_attack());
+  }
+  Json::Value& stats = result["stats"] = Json::Value(Json::arrayValue);
+  for (const Npc::Stats& level : npc->stats()) {
+    Json::Value& entry = stats.append(Json::Value(Json::objectValue));
+    entry["level"] = level.level();
+    entry["rank"] = level.rank();
+    entry["stars"] = level.stars();
+    entry["damage"] = level.damage();
+    entry["armor"] = level.armor();
+    entry["health"] = level.health();
+  }
+  return absl::OkStatus();
+}
+
+const absl::flat_hash_map<absl::string_view, Handler>& Handlers() {
+  static const auto* const kHandlers =
+      new absl::flat_hash_map<absl::string_view, Handler>({
+          {"craft", &HandleCraft},
+          {"drops", &HandleDrops},
+          {"effective_rate", &HandleDrops},
+          {"farm", &HandleFarm},
+          {"node", &HandleNode},
+          {"npc", &HandleNpc},
+          {"rank_up", &HandleRankUp},
+          {"unit", &HandleUnit},
+      });
+  return *kHandlers;
+}
+
+absl::Status Dispatch(const MinerSnapshot& snapshot, const Json::Value& query,
+                      Json::Value& result) {
+  std::string type;
+  ASSIGN_OR_RETURN(type, GetString(query, "type"));
+  const auto it = Handlers().find(type);
+  if (it == Handlers().end()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown query type '", type, "'."));
+  }
+  return it->second(snapshot, query, result);
+}
+
+// A streambuf that appends to a string, so that a response is written
+// straight into the caller's line, which keeps its capacity between queries.
+class StringAppender : public std::streambuf {
+ public:
+  explicit StringAppender(std::string& out) : out_(out) {}
+
+ protected:
+  int_type overflow(const int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      out_.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, const std::streamsize n) override {
+    out_.append(s, n);
+    return n;
+  }
+
+ private:
+  std::string& out_;
+};
+
+void WriteLine(const Json::Value& response, std::string& line) {
+  // A StreamWriter keeps state while it writes, so each thread has its own.
+  thread_local const std::unique_ptr<Json::StreamWriter> writer = [] {
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    // Like the file outputs, write at most 3 decimals, so a float effective
+    // rate reads 1.499 rather than 1.4990000128746033.
+    builder["precision"] = 3;
+    builder["precisionType"] = "decimal";
+    return std::unique_ptr<Json::StreamWriter>(builder.newStreamWriter());
+  }();
+  line.clear();
+  StringAppender appender(line);
+  std::ostream stream(&appender);
+  writer->write(response, &stream);
+}
+
+}  // namespace
+
+std::string HandleQuery(const MinerSnapshot& snapshot,
+                        const absl::string_view json_line) {
+  std::string response;
+  HandleQuery(snapshot, json_line, response);
+  return response;
+}
+
+void HandleQuery(const MinerSnapshot& snapshot,
+                 const absl::string_view json_line,
+                 std::string& response_line) {
+  Json::Value query;
+  Json::Value response(Json::objectValue);
+  Json::Reader reader;
+  absl::Status status;
+  if (!reader.parse(json_line.data(), json_line.data() + json_line.size(),
+                    query, false)) {
+    status = absl::InvalidArgumentError(reader.getFormattedErrorMessages());
+  } else if (!query.isObject()) {
+    status = absl::InvalidArgumentError("Expected a JSON object.");
+  } else {
+    if (query.isMember("id")) response["id"] = query["id"];
+    Json::Value result(Json::objectValue);
+    status = Dispatch(snapshot, query, result);
+    if (status.ok()) response["result"] = std::move(result);
+  }
+  response["ok"] = status.ok();
+  if (!status.ok()) response["error"] = std::string(status.message());
+  WriteLine(response, response_line);
+}
+
+}  // namespace dataminer
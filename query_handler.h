@@ -0,0 +1,52 @@
+#ifndef __QUERY_HANDLER_H__
+#define __QUERY_HANDLER_H__
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "miner_snapshot.h"
+
+namespace dataminer {
+
+// Answers one query, given as a single line of JSON, against `snapshot`, and
+// returns the response as a single line of JSON, without the newline.
+//
+// Every query is an object with a "type" and that type's arguments, and may
+// have an "id", which is echoed back so callers can match up responses:
+//
+//   {"id": 1, "type": "rank_up", "unit": "ultraCalgar",
+//    "from": "STONE_1", "to": "GOLD_1"}
+//   {"type": "node", "battle": "FoCE12"}
+//   {"type": "drops", "material": "upgArmC001"}
+//   {"type": "unit", "unit": "ultraCalgar"}
+//   {"type": "npc", "npc": "tyranGaunt"}
+//   {"type": "farm", "needs": {"upgArmC001": 10},
+//    "rank_ups": [{"unit": "ultraCalgar", "from": "STONE_1",
+//                  "to": "IRON_1"}],
+//    "roster": ["ultraCalgar"], "days": 7}
+//   {"type": "craft", "inventory": {"upgArmC001": 10},
+//    "material": "upgArmE001C", "count": 2}
+//
+// A farm query plans the raids for its "needs" plus the base materials of
+// its "rank_ups"; "roster" and "days" are optional. Crafted needs that no
+// node drops are farmed as their base materials. A craft query without a
+// "material" lists everything the inventory can craft.
+//
+// Fields that the output files also have are spelled and rounded as there,
+// e.g. "effective_rate" to 3 decimals, and no real has more than 3 decimals.
+//
+// "effective_rate" is another name for "drops". The response is either
+// {"id": ..., "ok": true, "result": ...} or
+// {"id": ..., "ok": false, "error": "..."}.
+//
+// Only reads `snapshot`, so it can be called from any number of threads.
+std::string HandleQuery(const MinerSnapshot& snapshot,
+                        absl::string_view json_line);
+
+// Like above, but writes the response to `response_line`.
+void HandleQuery(const MinerSnapshot& snapshot, absl::string_view json_line,
+                 std::string& response_line);
+
+}  // namespace dataminer
+
+#endif  // __QUERY_HANDLER_H__
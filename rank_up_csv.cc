@@ -0,0 +1,58 @@
+#include "rank_up_csv.h"
+
+#include <sstream>
+
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "miner.pb.h"
+#include "output_writer.h"
+#include "recipe_graph.h"
+#include "trace.h"
+
+namespace dataminer {
+
+absl::Status EmitRankUp(const absl::string_view output_path,
+                        const GameConfigIndex& index) {
+  TRACE_SCOPE("EmitRankUp");
+  const ClientGameConfig& client_config = index.config().client_game_config();
+  absl::StatusOr<RecipeGraph> graph =
+      RecipeGraph::Build(client_config.upgrades());
+  if (!graph.ok()) return graph.status();
+
+  std::ostringstream out;
+  out << "unit,target_rank,quantity,upgrade_material,rarity\n";
+  for (const Unit& unit : client_config.units().units()) {
+    for (int rank = Rank::STONE_1; rank < Rank::ADAMANTINE_1; ++rank) {
+      const int i = rank - 1;
+      if (i >= unit.rank_up_requirements_size()) {
+        LOG(ERROR) << "No rank up requirements for " << unit.id() << ":"
+                   << Rank::Enum_Name(rank) << ".\n";
+        continue;
+      }
+      const Unit::RankUpRequirements& req = unit.rank_up_requirements(i);
+      // Sorted by dense ID, which is the (rarity, ID) order of the output.
+      RecipeGraph::Materials mats;
+      for (const std::string* upgrade_material :
+           {&req.top_row_health(), &req.bottom_row_health(),
+            &req.top_row_armor(), &req.bottom_row_armor(),
+            &req.top_row_damage(), &req.bottom_row_damage()}) {
+        const int material = graph->Find(*upgrade_material);
+        if (material < 0) {
+          LOG(ERROR) << "Material '" << *upgrade_material
+                     << "' not found in upgrades.\n";
+          continue;
+        }
+        graph->AddBaseMaterials(material, 1, mats);
+      }
+      for (const RecipeGraph::MaterialCount& mat : mats) {
+        const Upgrades::Upgrade& upgrade = graph->upgrade(mat.material);
+        out << unit.id() << "," << Rank::Enum_Name(rank + 1) << ","
+            << mat.count << "," << upgrade.id() << "," << upgrade.rarity()
+            << "\n";
+      }
+    }
+  }
+  return WriteOutput(output_path, out.str());
+}
+
+}  // namespace dataminer
@@ -0,0 +1,18 @@
+#ifndef __RANK_UP_CSV_H__
+#define __RANK_UP_CSV_H__
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "game_config_index.h"
+
+namespace dataminer {
+
+// Writes the base materials each unit needs for each rank up to `path` as CSV,
+// one row per unit, target rank and material. Returns an error status if the
+// creation fails.
+absl::Status EmitRankUp(absl::string_view output_path,
+                        const GameConfigIndex& index);
+
+}  // namespace dataminer
+
+#endif  // __RANK_UP_CSV_H__
@@ -0,0 +1,137 @@
+#include "rank_up_query.h"
+
+#include <string>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "status_macros.h"
+
+namespace dataminer {
+
+RankUpQuery RankUpQuery::Build(const Units& units, const RecipeGraph& graph) {
+  RankUpQuery query;
+  query.graph_ = &graph;
+  query.row_offsets_.push_back(0);
+  for (const Unit& unit : units.units()) {
+    if (!query.units_.try_emplace(unit.id(), query.unit_rows_.size()).second) {
+      continue;
+    }
+    query.unit_rows_.push_back(query.row_offsets_.size() - 1);
+    RecipeGraph::Materials total;
+    // The empty prefix: nothing is needed to stay at Stone 1.
+    query.row_offsets_.push_back(query.prefixes_.size());
+    for (const Unit::RankUpRequirements& req : unit.rank_up_requirements()) {
+      for (const std::string* upgrade_material :
+           {&req.top_row_health(), &req.bottom_row_health(),
+            &req.top_row_armor(), &req.bottom_row_armor(),
+            &req.top_row_damage(), &req.bottom_row_damage()}) {
+        const int material = graph.Find(*upgrade_material);
+        if (material < 0) {
+          LOG(ERROR) << "Material '" << *upgrade_material << "' for "
+                     << unit.id() << " not found in upgrades.";
+          continue;
+        }
+        graph.AddBaseMaterials(material, 1, total);
+      }
+      query.prefixes_.insert(query.prefixes_.end(), total.begin(),
+                             total.end());
+      query.row_offsets_.push_back(query.prefixes_.size());
+    }
+  }
+  query.unit_rows_.push_back(query.row_offsets_.size() - 1);
+  return query;
+}
+
+absl::Span<const RecipeGraph::MaterialCount> RankUpQuery::Prefix(
+    const int unit, const int rank_ups) const {
+  const int row = unit_rows_[unit] + rank_ups;
+  return absl::MakeConstSpan(prefixes_.data() + row_offsets_[row],
+                             row_offsets_[row + 1] - row_offsets_[row]);
+}
+
+absl::StatusOr<int> RankUpQuery::Resolve(const Request& request) const {
+  const auto it = units_.find(request.unit_id);
+  if (it == units_.end()) {
+    return absl::NotFoundError(
+        absl::StrCat("Unknown unit '", request.unit_id, "'."));
+  }
+  if (request.from < Rank::STONE_1 || request.to < request.from) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Can't rank ", request.unit_id, " up from ",
+        Rank::Enum_Name(request.from), " to ", Rank::Enum_Name(request.to),
+        "."));
+  }
+  const int unit = it->second;
+  const int max_rank_ups = unit_rows_[unit + 1] - unit_rows_[unit] - 1;
+  if (request.to - Rank::STONE_1 > max_rank_ups) {
+    return absl::OutOfRangeError(
+        absl::StrCat("No rank up requirements for ", request.unit_id, " to ",
+                     Rank::Enum_Name(request.to), "."));
+  }
+  return unit;
+}
+
+absl::StatusOr<RecipeGraph::Materials> RankUpQuery::Query(
+    const absl::string_view unit_id, const Rank::Enum from,
+    const Rank::Enum to) const {
+  const absl::StatusOr<int> unit = Resolve({unit_id, from, to});
+  if (!unit.ok()) return unit.status();
+  // The prefixes only grow, so every material of the lower one is also in the
+  // upper one, and the difference is one merge.
+  const absl::Span<const RecipeGraph::MaterialCount> lower =
+      Prefix(*unit, from - Rank::STONE_1);
+  const absl::Span<const RecipeGraph::MaterialCount> upper =
+      Prefix(*unit, to - Rank::STONE_1);
+  RecipeGraph::Materials result;
+  result.reserve(upper.size());
+  auto it = lower.begin();
+  for (const RecipeGraph::MaterialCount& mat : upper) {
+    int64_t count = mat.count;
+    if (it != lower.end() && it->material == mat.material) {
+      count -= it->count;
+      ++it;
+    }
+    if (count != 0) result.push_back({mat.material, count});
+  }
+  return result;
+}
+
+absl::StatusOr<RecipeGraph::Materials> RankUpQuery::QueryBatch(
+    const absl::Span<const Request> requests) const {
+  // Summing a roster's worth of sparse vectors one merge at a time would
+  // reallocate on every request, so this scatters them all into one dense
+  // total instead.
+  std::vector<int64_t> totals(graph_->size());
+  RETURN_IF_ERROR(AddTo(requests, absl::MakeSpan(totals)));
+  RecipeGraph::Materials result;
+  for (int material = 0; material < graph_->size(); ++material) {
+    if (totals[material] != 0) result.push_back({material, totals[material]});
+  }
+  return result;
+}
+
+absl::Status RankUpQuery::AddTo(const absl::Span<const Request> requests,
+                                const absl::Span<int64_t> totals) const {
+  // Every request is checked before any is added, so a bad one leaves
+  // `totals` alone.
+  for (const Request& request : requests) RETURN_IF_ERROR(Check(request));
+  for (const Request& request : requests) {
+    const int unit = *Resolve(request);
+    for (const RecipeGraph::MaterialCount& mat :
+         Prefix(unit, request.to - Rank::STONE_1)) {
+      totals[mat.material] += mat.count;
+    }
+    for (const RecipeGraph::MaterialCount& mat :
+         Prefix(unit, request.from - Rank::STONE_1)) {
+      totals[mat.material] -= mat.count;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RankUpQuery::Check(const Request& request) const {
+  return Resolve(request).status();
+}
+
+}  // namespace dataminer
@@ -0,0 +1,82 @@
+#ifndef __RANK_UP_QUERY_H__
+#define __RANK_UP_QUERY_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "miner.pb.h"
+#include "recipe_graph.h"
+
+namespace dataminer {
+
+// Answers "which base materials does unit X need to go from rank A to rank
+// B". For every unit, this keeps the running total of base materials over
+// its rank-ups, so a query is one subtraction of two precomputed vectors.
+//
+// Points into the Units and RecipeGraph it was built from, which must outlive
+// it. It's immutable once built, so it can be shared between threads.
+class RankUpQuery {
+ public:
+  struct Request {
+    absl::string_view unit_id;
+    Rank::Enum from;
+    Rank::Enum to;
+  };
+
+  // Precomputes the totals for every unit in `units`. Rank-up materials that
+  // aren't in `graph` are logged and left out.
+  static RankUpQuery Build(const Units& units, const RecipeGraph& graph);
+
+  RankUpQuery(RankUpQuery&&) = default;
+  RankUpQuery& operator=(RankUpQuery&&) = default;
+
+  const RecipeGraph& graph() const { return *graph_; }
+
+  // Returns the base materials `unit_id` needs to go from rank `from` to rank
+  // `to`, sorted by material. Fails if there's no such unit, if `to` is below
+  // `from`, or if the unit's rank-ups don't go as high as `to`.
+  absl::StatusOr<RecipeGraph::Materials> Query(absl::string_view unit_id,
+                                               Rank::Enum from,
+                                               Rank::Enum to) const;
+
+  // Like Query, but returns the total over all of `requests`, e.g. for a
+  // whole roster. Fails if any one of them would.
+  absl::StatusOr<RecipeGraph::Materials> QueryBatch(
+      absl::Span<const Request> requests) const;
+
+  // Like QueryBatch, but adds the total into `totals`, which is indexed by
+  // material and has graph().size() entries. Doesn't allocate unless it
+  // fails, in which case `totals` is left as it was.
+  absl::Status AddTo(absl::Span<const Request> requests,
+                     absl::Span<int64_t> totals) const;
+
+  // Returns why `request` can't be answered, or OK if it can.
+  absl::Status Check(const Request& request) const;
+
+ private:
+  RankUpQuery() = default;
+
+  // The materials of rank-ups [0, rank_ups) of unit `unit`, i.e. from Stone 1
+  // up to rank Stone 1 + `rank_ups`.
+  absl::Span<const RecipeGraph::MaterialCount> Prefix(int unit,
+                                                      int rank_ups) const;
+
+  // Checks that `request` can be answered, and returns its unit's position.
+  absl::StatusOr<int> Resolve(const Request& request) const;
+
+  const RecipeGraph* graph_ = nullptr;
+  absl::flat_hash_map<absl::string_view, int> units_;
+  // Unit u's prefixes are rows [unit_rows_[u], unit_rows_[u + 1]), and row r
+  // is prefixes_[row_offsets_[r], row_offsets_[r + 1]).
+  std::vector<int> unit_rows_;
+  std::vector<int> row_offsets_;
+  std::vector<RecipeGraph::MaterialCount> prefixes_;
+};
+
+}  // namespace dataminer
+
+#endif  // __RANK_UP_QUERY_H__
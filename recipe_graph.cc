@@ -0,0 +1,147 @@
+#include "recipe_graph.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
+namespace dataminer {
+
+namespace {
+
+// Where a material is in the depth-first walk that orders the graph.
+enum class VisitState { kUnvisited, kVisiting, kDone };
+
+// Appends `material` to `order` after all of its ingredients. Fails if the
+// walk comes back to a material it's still expanding.
+absl::Status Visit(const int material,
+                   const std::vector<RecipeGraph::Materials>& recipes,
+                   const std::vector<const Upgrades::Upgrade*>& upgrades,
+                   std::vector<VisitState>& state, std::vector<int>& order) {
+  if (state[material] == VisitState::kDone) return absl::OkStatus();
+  if (state[material] == VisitState::kVisiting) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The recipe for '", upgrades[material]->id(), "' depends on itself."));
+  }
+  state[material] = VisitState::kVisiting;
+  for (const RecipeGraph::MaterialCount& ingredient : recipes[material]) {
+    absl::Status status =
+        Visit(ingredient.material, recipes, upgrades, state, order);
+    if (!status.ok()) return status;
+  }
+  state[material] = VisitState::kDone;
+  order.push_back(material);
+  return absl::OkStatus();
+}
+
+// Concatenates `lists` into `flat`, with list i at
+// flat[offsets[i], offsets[i + 1]).
+void Flatten(const std::vector<RecipeGraph::Materials>& lists,
+             std::vector<int>& offsets,
+             std::vector<RecipeGraph::MaterialCount>& flat) {
+  offsets.reserve(lists.size() + 1);
+  offsets.push_back(0);
+  for (const RecipeGraph::Materials& list : lists) {
+    flat.insert(flat.end(), list.begin(), list.end());
+    offsets.push_back(flat.size());
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<RecipeGraph> RecipeGraph::Build(const Upgrades& upgrades) {
+  RecipeGraph graph;
+  {
+    absl::flat_hash_map<absl::string_view, const Upgrades::Upgrade*> unique;
+    for (const Upgrades::Upgrade& upgrade : upgrades.upgrades()) {
+      if (unique.try_emplace(upgrade.id(), &upgrade).second) {
+        graph.upgrades_.push_back(&upgrade);
+      }
+    }
+  }
+  std::sort(graph.upgrades_.begin(), graph.upgrades_.end(),
+            [](const Upgrades::Upgrade* lhs, const Upgrades::Upgrade* rhs) {
+              if (lhs->rarity() != rhs->rarity()) {
+                return lhs->rarity() < rhs->rarity();
+              }
+              return lhs->id() < rhs->id();
+            });
+  graph.ids_.reserve(graph.upgrades_.size());
+  for (int i = 0; i < graph.size(); ++i) {
+    graph.ids_.emplace(graph.upgrades_[i]->id(), i);
+  }
+
+  // Repeated ingredients in a recipe are merged.
+  std::vector<Materials> recipes(graph.size());
+  for (int i = 0; i < graph.size(); ++i) {
+    const Upgrades::Upgrade& upgrade = *graph.upgrades_[i];
+    for (const Upgrades::Upgrade::Recipe::Ingredient& ingredient :
+         upgrade.recipe().ingredients()) {
+      const int material = graph.Find(ingredient.id());
+      if (material < 0) {
+        LOG(ERROR) << "Material '" << ingredient.id() << "' in the recipe for '"
+                   << upgrade.id() << "' not found in upgrades.";
+        continue;
+      }
+      const MaterialCount amount = {material, ingredient.amount()};
+      if (amount.count > 0) Accumulate({&amount, 1}, 1, recipes[i]);
+    }
+  }
+
+  std::vector<VisitState> state(graph.size(), VisitState::kUnvisited);
+  graph.topological_order_.reserve(graph.size());
+  for (int i = 0; i < graph.size(); ++i) {
+    absl::Status status =
+        Visit(i, recipes, graph.upgrades_, state, graph.topological_order_);
+    if (!status.ok()) return status;
+  }
+
+  // Ingredients come first in the topological order, so their expansions are
+  // always done by the time a recipe needs them. Each one is expanded into
+  // its own vector first, since the flat storage moves as it grows.
+  std::vector<Materials> base(graph.size());
+  for (const int material : graph.topological_order_) {
+    if (!graph.upgrades_[material]->has_recipe()) {
+      base[material].push_back({material, 1});
+      continue;
+    }
+    for (const MaterialCount& ingredient : recipes[material]) {
+      Accumulate(base[ingredient.material], ingredient.count, base[material]);
+    }
+  }
+  Flatten(base, graph.offsets_, graph.base_materials_);
+  Flatten(recipes, graph.ingredient_offsets_, graph.ingredients_);
+  return graph;
+}
+
+int RecipeGraph::Find(const absl::string_view id) const {
+  const auto it = ids_.find(id);
+  return it == ids_.end() ? -1 : it->second;
+}
+
+void RecipeGraph::Accumulate(const absl::Span<const MaterialCount> materials,
+                             const int64_t scale, Materials& total) {
+  if (materials.empty() || scale == 0) return;
+  Materials merged;
+  merged.reserve(total.size() + materials.size());
+  auto lhs = total.begin();
+  auto rhs = materials.begin();
+  while (lhs != total.end() || rhs != materials.end()) {
+    if (rhs == materials.end() ||
+        (lhs != total.end() && lhs->material < rhs->material)) {
+      merged.push_back(*lhs++);
+    } else if (lhs == total.end() || rhs->material < lhs->material) {
+      merged.push_back({rhs->material, rhs->count * scale});
+      ++rhs;
+    } else {
+      merged.push_back({lhs->material, lhs->count + rhs->count * scale});
+      ++lhs;
+      ++rhs;
+    }
+  }
+  total = std::move(merged);
+}
+
+}  // namespace dataminer
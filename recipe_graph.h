@@ -0,0 +1,102 @@
+#ifndef __RECIPE_GRAPH_H__
+#define __RECIPE_GRAPH_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "miner.pb.h"
+
+namespace dataminer {
+
+// The crafting graph of the upgrade materials, with every material's full
+// expansion into base (uncraftable) materials computed once up front.
+//
+// Each upgrade gets a dense ID in [0, size()). IDs are ordered by rarity, then
+// by Snowprint ID, which is the order the planner lists materials in, so a
+// vector sorted by dense ID is already in output order.
+//
+// Material vectors are sparse: a list of (material, count) pairs sorted by
+// material. Expanding a rank-up is a handful of merges of precomputed
+// vectors, instead of a recursive walk per unit of every ingredient.
+//
+// The graph points into the Upgrades it was built from, which must outlive it.
+// It's immutable once built, so it can be shared between threads.
+class RecipeGraph {
+ public:
+  struct MaterialCount {
+    int material;
+    int64_t count;
+
+    bool operator==(const MaterialCount& other) const {
+      return material == other.material && count == other.count;
+    }
+  };
+  using Materials = std::vector<MaterialCount>;
+
+  // Builds the graph of `upgrades`. Ingredients that aren't upgrades are
+  // logged and left out, as are upgrades whose ID is repeated (the first one
+  // wins). Fails if a recipe depends on itself.
+  static absl::StatusOr<RecipeGraph> Build(const Upgrades& upgrades);
+
+  RecipeGraph(RecipeGraph&&) = default;
+  RecipeGraph& operator=(RecipeGraph&&) = default;
+
+  int size() const { return static_cast<int>(upgrades_.size()); }
+
+  // Returns the dense ID of the upgrade with Snowprint ID `id`, or -1.
+  int Find(absl::string_view id) const;
+
+  const Upgrades::Upgrade& upgrade(int material) const {
+    return *upgrades_[material];
+  }
+
+  // Every material, with each one after all of its ingredients.
+  absl::Span<const int> TopologicalOrder() const { return topological_order_; }
+
+  // The ingredients of one `material`'s recipe, sorted by material. Empty for
+  // base materials.
+  absl::Span<const MaterialCount> Ingredients(int material) const {
+    return absl::MakeConstSpan(
+        ingredients_.data() + ingredient_offsets_[material],
+        ingredient_offsets_[material + 1] - ingredient_offsets_[material]);
+  }
+
+  // The base materials one `material` takes to craft. For a base material,
+  // that's just itself.
+  absl::Span<const MaterialCount> BaseMaterials(int material) const {
+    return absl::MakeConstSpan(base_materials_.data() + offsets_[material],
+                               offsets_[material + 1] - offsets_[material]);
+  }
+
+  // Adds `scale` times `materials` to `total`. Both must be sorted by
+  // material, and `total` stays that way.
+  static void Accumulate(absl::Span<const MaterialCount> materials,
+                         int64_t scale, Materials& total);
+
+  // Adds the base materials for `count` of `material` to `total`.
+  void AddBaseMaterials(int material, int64_t count, Materials& total) const {
+    Accumulate(BaseMaterials(material), count, total);
+  }
+
+ private:
+  RecipeGraph() = default;
+
+  std::vector<const Upgrades::Upgrade*> upgrades_;
+  absl::flat_hash_map<absl::string_view, int> ids_;
+  std::vector<int> topological_order_;
+  // Ingredients(m) is ingredients_[ingredient_offsets_[m],
+  // ingredient_offsets_[m + 1]).
+  std::vector<int> ingredient_offsets_;
+  std::vector<MaterialCount> ingredients_;
+  // BaseMaterials(m) is base_materials_[offsets_[m], offsets_[m + 1]).
+  std::vector<int> offsets_;
+  std::vector<MaterialCount> base_materials_;
+};
+
+}  // namespace dataminer
+
+#endif  // __RECIPE_GRAPH_H__
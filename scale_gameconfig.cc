@@ -0,0 +1,526 @@
+// Writes a scaled-up copy of a gameconfig for load testing the miner, e.g.
+//
+//   scale_gameconfig --seed_config=testdata/synthetic_gameconfig.json
+//       --seed_i18n=testdata/synthetic_i18n.json --scale=10
+//       --output=/tmp/gameconfig_10x.json --i18n_output=/tmp/i18n_10x.json
+//
+// The output has `--scale` times the seed's units, NPCs, items, avatars and
+// campaigns, and its recipes are `--scale` times as deep. Copy 0 is the seed
+// itself; copy k clones every entity with "_x<k>" appended to its ID and
+// rewrites the clone's references (rank-up and recipe materials, abilities,
+// "npcId:level" enemies, loot, required and allowed units, avatars) to point
+// at copy k's entities, so every copy is as internally consistent as the
+// seed. Cloned campaigns take the next unused real campaign ID of their
+// family, e.g. campaign3 after campaign1 and campaign2, and once those run
+// out, extend the seed campaign with more battles instead.
+//
+// Clones' stats are jittered by up to 10% so that copies aren't identical.
+// The jitter comes straight from std::mt19937, whose output the standard
+// pins down, so a given seed config and --seed always produce the same
+// bytes.
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "campaign_tables.h"
+#include "libjson/json/reader.h"
+#include "libjson/json/value.h"
+#include "libjson/json/writer.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, seed_config, "testdata/synthetic_gameconfig.json",
+          "The gameconfig JSON to scale up.");
+ABSL_FLAG(std::string, seed_i18n, "",
+          "If set, the i18n JSON whose unit display strings are cloned along "
+          "with the units.");
+ABSL_FLAG(std::string, output, "", "Where to write the scaled gameconfig.");
+ABSL_FLAG(std::string, i18n_output, "",
+          "Where to write the scaled i18n JSON. Requires --seed_i18n.");
+ABSL_FLAG(int, scale, 10, "How many times to scale the seed up.");
+ABSL_FLAG(int, seed, 1, "Seeds the jitter added to the clones' stats.");
+
+namespace dataminer {
+
+namespace {
+
+using IdSet = absl::flat_hash_set<std::string>;
+
+// Returns copy `copy`'s ID for the seed entity `id`.
+std::string CopyId(const absl::string_view id, const int copy) {
+  if (copy == 0) return std::string(id);
+  return absl::StrCat(id, "_x", copy);
+}
+
+// Like CopyId, but leaves IDs that aren't in `ids` alone, e.g. "gold" in a
+// loot table or an ability every copy shares.
+std::string RemapId(const IdSet& ids, const absl::string_view id,
+                    const int copy) {
+  if (!ids.contains(id)) return std::string(id);
+  return CopyId(id, copy);
+}
+
+// Returns the member `key` of `value`, or null if there isn't one. Unlike
+// Json::Value::operator[], never adds the member.
+Json::Value* FindMember(Json::Value& value, const char* key) {
+  if (!value.isObject() || !value.isMember(key)) return nullptr;
+  return &value[key];
+}
+
+// Like FindMember, but returns an empty array if there's no such array, so
+// callers can loop over optional arrays.
+Json::Value& ArrayMember(Json::Value& value, const char* key) {
+  static Json::Value* const empty = new Json::Value(Json::arrayValue);
+  Json::Value* member = FindMember(value, key);
+  return member != nullptr && member->isArray() ? *member : *empty;
+}
+
+// Appends the copy number to the display string `key` of a clone.
+void RenameCopy(Json::Value& value, const char* key, const int copy) {
+  Json::Value* name = FindMember(value, key);
+  if (name != nullptr && name->isString()) {
+    *name = absl::StrCat(name->asString(), " #", copy);
+  }
+}
+
+// Remaps each string in the array `key` of `value`.
+void RemapArray(const IdSet& known, Json::Value& value, const char* key,
+                const int copy) {
+  for (Json::Value& id : ArrayMember(value, key)) {
+    if (id.isString()) id = RemapId(known, id.asString(), copy);
+  }
+}
+
+// The IDs of the seed's entities, before anything is cloned.
+struct SeedIds {
+  IdSet upgrades;
+  IdSet units;
+  IdSet abilities;
+  IdSet npcs;
+};
+
+// Jitters the integer stats of a clone by up to 10% either way.
+class Jitter {
+ public:
+  explicit Jitter(const int seed) : rng_(seed) {}
+
+  void Apply(Json::Value& stat) {
+    if (!stat.isInt()) return;
+    // rng_() is uniform over [0, 2^32), so this is uniform over [0.9, 1.1).
+    const double factor = 0.9 + 0.2 * (rng_() / 4294967296.0);
+    stat = static_cast<int>(stat.asInt() * factor + 0.5);
+  }
+
+  // Applies the jitter to each of `fields` that `stats` has.
+  void ApplyToMembers(Json::Value& stats,
+                      std::initializer_list<const char*> fields) {
+    for (const char* field : fields) {
+      if (Json::Value* stat = FindMember(stats, field)) Apply(*stat);
+    }
+  }
+
+ private:
+  std::mt19937 rng_;
+};
+
+// Makes every recipe `scale` times as deep by routing each ingredient through
+// a chain of scale - 1 single-ingredient tiers, e.g. a recipe that used
+// upgHpC001 uses upgHpC001_t2, crafted from upgHpC001_t1, crafted from
+// upgHpC001. Each tier takes one of the one below, so the base materials a
+// recipe costs don't change, only how many crafts it takes.
+absl::Status DeepenRecipes(Json::Value& upgrades, const int scale) {
+  RET_CHECK(upgrades.isObject()) << "'upgrades' must be an object.";
+  if (scale <= 1) return absl::OkStatus();
+  std::set<std::string> ingredients;
+  for (const std::string& id : upgrades.getMemberNames()) {
+    for (const Json::Value& ingredient :
+         ArrayMember(upgrades[id], "crafting")) {
+      ingredients.insert(ingredient["id"].asString());
+    }
+  }
+  const auto tier_id = [](const absl::string_view id, const int tier) {
+    return tier == 0 ? std::string(id) : absl::StrCat(id, "_t", tier);
+  };
+  for (const std::string& id : upgrades.getMemberNames()) {
+    for (Json::Value& ingredient : ArrayMember(upgrades[id], "crafting")) {
+      ingredient["id"] = tier_id(ingredient["id"].asString(), scale - 1);
+    }
+  }
+  for (const std::string& id : ingredients) {
+    if (!upgrades.isMember(id)) continue;
+    for (int tier = 1; tier < scale; ++tier) {
+      Json::Value upgrade = upgrades[id];
+      upgrade["crafting"] = Json::Value(Json::arrayValue);
+      Json::Value ingredient(Json::objectValue);
+      ingredient["id"] = tier_id(id, tier - 1);
+      ingredient["amount"] = 1;
+      upgrade["crafting"].append(ingredient);
+      RenameCopy(upgrade, "name", tier);
+      upgrades[tier_id(id, tier)] = upgrade;
+    }
+  }
+  return absl::OkStatus();
+}
+
+void ScaleUpgrades(Json::Value& upgrades, const SeedIds& seed,
+                   const int scale) {
+  for (int copy = 1; copy < scale; ++copy) {
+    for (const std::string& id : seed.upgrades) {
+      Json::Value upgrade = upgrades[id];
+      for (Json::Value& ingredient : ArrayMember(upgrade, "crafting")) {
+        ingredient["id"] =
+            RemapId(seed.upgrades, ingredient["id"].asString(), copy);
+      }
+      RenameCopy(upgrade, "name", copy);
+      upgrades[CopyId(id, copy)] = upgrade;
+    }
+  }
+}
+
+// Remaps the material IDs in each row of a unit's or ability's "upgrades".
+void RemapUpgradeRows(const IdSet& upgrades, Json::Value& value,
+                      const int copy) {
+  for (Json::Value& row : ArrayMember(value, "upgrades")) {
+    if (!row.isArray()) continue;
+    for (Json::Value& id : row) {
+      if (id.isString()) id = RemapId(upgrades, id.asString(), copy);
+    }
+  }
+}
+
+// Clones the units, the abilities they use and the NPCs.
+void ScaleUnits(Json::Value& units, const SeedIds& seed, const int scale,
+                Jitter& jitter) {
+  Json::Value& lineup = units["lineup"];
+  Json::Value& abilities = units["abilities"];
+  Json::Value& npcs = units["npc"];
+  for (int copy = 1; copy < scale; ++copy) {
+    for (const std::string& id : lineup.getMemberNames()) {
+      if (!seed.units.contains(id)) continue;
+      Json::Value unit = lineup[id];
+      RemapArray(seed.abilities, unit, "activeAbilities", copy);
+      RemapArray(seed.abilities, unit, "passiveAbilities", copy);
+      RemapUpgradeRows(seed.upgrades, unit, copy);
+      if (Json::Value* stats = FindMember(unit, "stats")) {
+        jitter.ApplyToMembers(*stats, {"Health", "Damage", "FixedArmor"});
+      }
+      RenameCopy(unit, "name", copy);
+      lineup[CopyId(id, copy)] = unit;
+    }
+    for (const std::string& id : seed.abilities) {
+      Json::Value ability = abilities[id];
+      RemapUpgradeRows(seed.upgrades, ability, copy);
+      abilities[CopyId(id, copy)] = ability;
+    }
+    for (const std::string& id : npcs.getMemberNames()) {
+      if (!seed.npcs.contains(id)) continue;
+      Json::Value npc = npcs[id];
+      for (Json::Value& stats : ArrayMember(npc, "stats")) {
+        jitter.ApplyToMembers(stats, {"Health", "Damage", "FixedArmor"});
+      }
+      RenameCopy(npc, "name", copy);
+      npcs[CopyId(id, copy)] = npc;
+    }
+  }
+}
+
+void ScaleAvatars(Json::Value& avatars, const SeedIds& seed,
+                  const int scale) {
+  const Json::Value seed_avatars = avatars;
+  for (int copy = 1; copy < scale; ++copy) {
+    for (Json::Value avatar : seed_avatars) {
+      avatar["avatarId"] = CopyId(avatar["avatarId"].asString(), copy);
+      avatar["value"] = RemapId(seed.units, avatar["value"].asString(), copy);
+      avatars.append(avatar);
+    }
+  }
+}
+
+void ScaleItems(Json::Value& items, const SeedIds& seed, const int scale) {
+  const std::vector<std::string> ids = items.getMemberNames();
+  for (int copy = 1; copy < scale; ++copy) {
+    for (const std::string& id : ids) {
+      Json::Value item = items[id];
+      RemapArray(seed.units, item, "allowedUnits", copy);
+      RenameCopy(item, "name", copy);
+      items[CopyId(id, copy)] = item;
+    }
+  }
+}
+
+// Remaps the material in a loot string such as "upgHpC001:1-2" or
+// "upgHpC001%1/4", whichever of `separators` comes first.
+std::string RemapLoot(const IdSet& upgrades, const absl::string_view loot,
+                      const absl::string_view separators, const int copy) {
+  const size_t end = loot.find_first_of(separators);
+  const absl::string_view id = loot.substr(0, end);
+  return absl::StrCat(RemapId(upgrades, id, copy),
+                      end == absl::string_view::npos ? "" : loot.substr(end));
+}
+
+void RemapBattle(const SeedIds& seed, Json::Value& battle, const int copy) {
+  RemapArray(seed.units, battle, "requiredUnits", copy);
+  for (Json::Value& team : ArrayMember(battle, "units")) {
+    if (!team.isArray()) continue;
+    for (Json::Value& unit : team) {
+      if (!unit.isString()) continue;
+      unit = RemapLoot(seed.npcs, unit.asString(), ":", copy);
+    }
+  }
+  Json::Value* loot = FindMember(battle, "loot");
+  if (loot == nullptr) return;
+  for (Json::Value& base : ArrayMember(*loot, "base")) {
+    if (base.isString()) {
+      base = RemapLoot(seed.upgrades, base.asString(), ":", copy);
+    }
+  }
+  Json::Value* chance_of = FindMember(*loot, "chanceOf");
+  if (chance_of != nullptr && chance_of->isString()) {
+    *chance_of = RemapLoot(seed.upgrades, chance_of->asString(), "%", copy);
+  }
+}
+
+// Returns the ID for the next clone of campaign `id`: the lowest-numbered
+// campaign of its family ("campaign", "elite", ...) that the miner's campaign
+// tables know and that isn't used yet, or "" once there are none left.
+std::string NextCampaignId(const absl::string_view id, IdSet& used) {
+  absl::string_view family = id;
+  while (!family.empty() && absl::ascii_isdigit(family.back())) {
+    family.remove_suffix(1);
+  }
+  for (const CampaignInfo& campaign : kCampaigns) {
+    const absl::string_view number = absl::StripPrefix(campaign.id, family);
+    if (number.size() == campaign.id.size() || number.empty() ||
+        !absl::ascii_isdigit(number.front())) {
+      continue;
+    }
+    if (used.insert(std::string(campaign.id)).second) {
+      return std::string(campaign.id);
+    }
+  }
+  return "";
+}
+
+// Returns the highest battle number in `campaign`, ignoring the "B" that
+// boss battles end in.
+int LastBattleNumber(const Json::Value& campaign) {
+  int last = 0;
+  for (const Json::Value& battle : campaign["battles"]) {
+    int number;
+    if (absl::SimpleAtoi(absl::StripSuffix(battle["battleId"].asString(), "B"),
+                         &number)) {
+      last = std::max(last, number);
+    }
+  }
+  return last;
+}
+
+// Renumbers a battle of a clone that extends its seed campaign, so its
+// number follows those of the earlier copies.
+void RenumberBattle(Json::Value& battle, const int offset, const int copy) {
+  Json::Value* id = FindMember(battle, "battleId");
+  if (id == nullptr || !id->isString()) return;
+  const std::string old_id = id->asString();
+  const bool boss = absl::EndsWith(old_id, "B");
+  int number;
+  if (absl::SimpleAtoi(absl::StripSuffix(old_id, "B"), &number)) {
+    *id = absl::StrCat(number + offset, boss ? "B" : "");
+  } else {
+    *id = CopyId(old_id, copy);
+  }
+}
+
+// Clones each campaign under the next real ID of its family. The miner logs
+// every battle of a campaign its tables don't know, which would swamp a load
+// test, so once a family runs out of real IDs, the clone's battles are
+// appended to the seed campaign instead, numbered after its own.
+absl::Status ScaleCampaigns(Json::Value& battles, const SeedIds& seed,
+                            const int scale) {
+  Json::Value* campaigns = FindMember(battles, "campaigns");
+  RET_CHECK(campaigns != nullptr && campaigns->isObject())
+      << "'battles.campaigns' must be an object.";
+  IdSet used;
+  for (const std::string& type : campaigns->getMemberNames()) {
+    RET_CHECK((*campaigns)[type].isArray())
+        << "'" << type << "' must be an array.";
+    for (const Json::Value& campaign : (*campaigns)[type]) {
+      used.insert(campaign["id"].asString());
+    }
+  }
+  const Json::Value seed_campaigns = *campaigns;
+  for (int copy = 1; copy < scale; ++copy) {
+    for (const std::string& type : seed_campaigns.getMemberNames()) {
+      Json::Value& list = (*campaigns)[type];
+      for (int i = 0; i < static_cast<int>(seed_campaigns[type].size()); ++i) {
+        Json::Value campaign = seed_campaigns[type][i];
+        for (Json::Value& battle : ArrayMember(campaign, "battles")) {
+          RemapBattle(seed, battle, copy);
+        }
+        const std::string id = NextCampaignId(campaign["id"].asString(), used);
+        if (!id.empty()) {
+          campaign["id"] = id;
+          list.append(campaign);
+          continue;
+        }
+        // The seed campaigns are still the first in the list.
+        const int offset = copy * LastBattleNumber(seed_campaigns[type][i]);
+        Json::Value* extended = FindMember(list[i], "battles");
+        RET_CHECK(extended != nullptr && extended->isArray())
+            << "Campaign '" << campaign["id"].asString()
+            << "' is missing 'battles'.";
+        for (Json::Value& battle : ArrayMember(campaign, "battles")) {
+          RenumberBattle(battle, offset, copy);
+          extended->append(battle);
+        }
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Adds each copy's display strings for the cloned units to the i18n JSON.
+void ScaleI18n(Json::Value& i18n, const SeedIds& seed, const int scale) {
+  Json::Value* source = FindMember(i18n, "mSource");
+  if (source == nullptr) return;
+  Json::Value& terms = ArrayMember(*source, "mTerms");
+  const Json::Value seed_terms = terms;
+  for (int copy = 1; copy < scale; ++copy) {
+    for (Json::Value term : seed_terms) {
+      const std::string name = term["Term"].asString();
+      if (!absl::StartsWith(name, "Units/")) continue;
+      const size_t underscore = name.rfind('_');
+      if (underscore == std::string::npos) continue;
+      const std::string id = name.substr(6, underscore - 6);
+      if (!seed.units.contains(id)) continue;
+      term["Term"] =
+          absl::StrCat("Units/", CopyId(id, copy), name.substr(underscore));
+      for (Json::Value& language : ArrayMember(term, "Languages")) {
+        if (language.isString()) {
+          language = absl::StrCat(language.asString(), " #", copy);
+        }
+      }
+      terms.append(term);
+    }
+  }
+}
+
+absl::Status ReadJson(const absl::string_view path, Json::Value& root) {
+  std::ifstream in{std::string(path)};
+  if (!in) {
+    return absl::NotFoundError(absl::StrCat("Couldn't open '", path, "'."));
+  }
+  Json::Reader reader;
+  if (!reader.parse(in, root) || !root.isObject()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Couldn't parse json file: '", path,
+                     "': ", reader.getFormattedErrorMessages()));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WriteJson(const absl::string_view path, const Json::Value& root) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  std::ofstream out{std::string(path)};
+  out << Json::writeString(builder, root) << "\n";
+  out.close();
+  if (!out) {
+    return absl::InternalError(absl::StrCat("Couldn't write '", path, "'."));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Main() {
+  const int scale = absl::GetFlag(FLAGS_scale);
+  RET_CHECK(scale >= 1) << "--scale must be at least 1.";
+  RET_CHECK(!absl::GetFlag(FLAGS_output).empty()) << "--output is required.";
+  RET_CHECK(absl::GetFlag(FLAGS_i18n_output).empty() ||
+            !absl::GetFlag(FLAGS_seed_i18n).empty())
+      << "--i18n_output requires --seed_i18n.";
+
+  Json::Value root;
+  RETURN_IF_ERROR(ReadJson(absl::GetFlag(FLAGS_seed_config), root));
+  RET_CHECK(root["clientGameConfig"].isObject())
+      << "Missing 'clientGameConfig' in the seed config.";
+  Json::Value& config = root["clientGameConfig"];
+  Json::Value& units = config["units"];
+  RET_CHECK(units["lineup"].isObject() && units["abilities"].isObject() &&
+            units["npc"].isObject())
+      << "'units' must have 'lineup', 'abilities' and 'npc' objects.";
+
+  RETURN_IF_ERROR(DeepenRecipes(config["upgrades"], scale));
+  SeedIds seed;
+  for (const std::string& id : config["upgrades"].getMemberNames()) {
+    seed.upgrades.insert(id);
+  }
+  for (const std::string& id : units["lineup"].getMemberNames()) {
+    seed.units.insert(id);
+    Json::Value& unit = units["lineup"][id];
+    for (const char* field : {"activeAbilities", "passiveAbilities"}) {
+      for (const Json::Value& ability : ArrayMember(unit, field)) {
+        if (units["abilities"].isMember(ability.asString())) {
+          seed.abilities.insert(ability.asString());
+        }
+      }
+    }
+  }
+  for (const std::string& id : units["npc"].getMemberNames()) {
+    seed.npcs.insert(id);
+  }
+
+  // Everything is cloned in a fixed order, so the jitter is reproducible.
+  Jitter jitter(absl::GetFlag(FLAGS_seed));
+  ScaleUpgrades(config["upgrades"], seed, scale);
+  ScaleUnits(units, seed, scale, jitter);
+  ScaleAvatars(ArrayMember(config, "avatars"), seed, scale);
+  if (Json::Value* items = FindMember(config, "items")) {
+    ScaleItems(*items, seed, scale);
+  }
+  RET_CHECK(FindMember(config, "battles") != nullptr)
+      << "Missing 'battles' in the seed config.";
+  RETURN_IF_ERROR(ScaleCampaigns(config["battles"], seed, scale));
+  root["clientGameConfigVersion"] =
+      absl::StrCat(root["clientGameConfigVersion"].asString(), "-x", scale);
+  RETURN_IF_ERROR(WriteJson(absl::GetFlag(FLAGS_output), root));
+  LOG(INFO) << "Wrote " << seed.units.size() * scale << " units, "
+            << seed.npcs.size() * scale << " NPCs and "
+            << seed.upgrades.size() * scale << " upgrades to "
+            << absl::GetFlag(FLAGS_output);
+
+  if (absl::GetFlag(FLAGS_i18n_output).empty()) return absl::OkStatus();
+  Json::Value i18n;
+  RETURN_IF_ERROR(ReadJson(absl::GetFlag(FLAGS_seed_i18n), i18n));
+  ScaleI18n(i18n, seed, scale);
+  return WriteJson(absl::GetFlag(FLAGS_i18n_output), i18n);
+}
+
+}  // namespace
+
+}  // namespace dataminer
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+  if (absl::Status status = dataminer::Main(); !status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
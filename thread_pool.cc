@@ -0,0 +1,88 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "metrics.h"
+
+namespace dataminer {
+
+namespace {
+
+// The workers running a task, across every pool.
+std::atomic<int> busy_workers{0};
+
+// Set on the workers while they run a task.
+thread_local bool in_task = false;
+
+}  // namespace
+
+ThreadPool::ThreadPool(const int num_threads) {
+  const int count = std::max(num_threads, 1);
+  threads_.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    threads_.emplace_back([this] { WorkLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  Wait();
+  {
+    absl::MutexLock lock(&mu_);
+    stopping_ = true;
+  }
+  for (std::thread& thread : threads_) thread.join();
+}
+
+void ThreadPool::Schedule(std::function<void()> fn) {
+  std::function<void()> task = AllocationScope::Carry(std::move(fn));
+  absl::MutexLock lock(&mu_);
+  queue_.push_back(std::move(task));
+}
+
+void ThreadPool::Wait() {
+  absl::MutexLock lock(&mu_);
+  mu_.Await(absl::Condition(this, &ThreadPool::IsIdle));
+}
+
+int ThreadPool::DefaultThreadCount() {
+  const unsigned int hw = std::thread::hardware_concurrency();
+  return hw == 0 ? 4 : static_cast<int>(hw);
+}
+
+int ThreadPool::SpareThreadCount() {
+  // A caller that's a worker blocks while the nested pool runs, so its core
+  // is free for the pool.
+  const int busy = busy_workers.load(std::memory_order_relaxed) - in_task;
+  return std::max(DefaultThreadCount() - busy, 1);
+}
+
+bool ThreadPool::IsIdle() const { return queue_.empty() && active_ == 0; }
+
+bool ThreadPool::HasWorkOrStopping() const {
+  return stopping_ || !queue_.empty();
+}
+
+void ThreadPool::WorkLoop() {
+  while (true) {
+    std::function<void()> fn;
+    {
+      absl::MutexLock lock(&mu_);
+      mu_.Await(absl::Condition(this, &ThreadPool::HasWorkOrStopping));
+      if (queue_.empty()) return;  // Only reached when stopping.
+      fn = std::move(queue_.front());
+      queue_.pop_front();
+      ++active_;
+    }
+    busy_workers.fetch_add(1, std::memory_order_relaxed);
+    in_task = true;
+    fn();
+    in_task = false;
+    busy_workers.fetch_sub(1, std::memory_order_relaxed);
+    absl::MutexLock lock(&mu_);
+    --active_;
+  }
+}
+
+}  // namespace dataminer
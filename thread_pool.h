@@ -0,0 +1,57 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace dataminer {
+
+// A fixed-size pool of worker threads. Work is run in the order it was
+// scheduled, but completes in whatever order the threads get to it, so callers
+// that need ordered output should have each task write to its own slot.
+class ThreadPool {
+ public:
+  // Starts `num_threads` workers. Values less than 1 are treated as 1.
+  explicit ThreadPool(int num_threads);
+
+  // Waits for all scheduled work to finish, then stops the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Queues `fn` to run on one of the workers. Its allocations count towards
+  // the caller's AllocationScope.
+  void Schedule(std::function<void()> fn);
+
+  // Blocks until every task scheduled so far has finished.
+  void Wait();
+
+  // The number of threads to use when the caller has no better idea.
+  static int DefaultThreadCount();
+
+  // The number of threads a nested pool can start without oversubscribing
+  // the cores: DefaultThreadCount() less the workers, in every pool, that are
+  // running a task, not counting the caller if it's one of them. At least 1.
+  static int SpareThreadCount();
+
+ private:
+  void WorkLoop();
+  bool IsIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool HasWorkOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  absl::Mutex mu_;
+  std::deque<std::function<void()>> queue_ ABSL_GUARDED_BY(mu_);
+  int active_ ABSL_GUARDED_BY(mu_) = 0;
+  bool stopping_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace dataminer
+
+#endif  // __THREAD_POOL_H__
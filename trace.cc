@@ -0,0 +1,104 @@
+#include "trace.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "output_writer.h"
+
+namespace dataminer {
+
+namespace trace_internal {
+std::atomic<bool> enabled{false};
+}  // namespace trace_internal
+
+namespace {
+
+struct Span {
+  absl::string_view name;
+  int64_t start_ns;
+  int64_t end_ns;
+};
+
+// One thread's spans. Only its thread appends to it, so the lock is only
+// ever contended while the trace is being written.
+struct ThreadBuffer {
+  explicit ThreadBuffer(const int tid) : tid(tid) {}
+
+  const int tid;
+  absl::Mutex mu;
+  std::vector<Span> spans ABSL_GUARDED_BY(mu);
+};
+
+// Every thread's buffer. Buffers outlive their threads, so the spans of
+// pool workers that have already exited still get written.
+class Registry {
+ public:
+  static Registry& Get() {
+    static Registry* const registry = new Registry();
+    return *registry;
+  }
+
+  ThreadBuffer* Register() {
+    absl::MutexLock lock(&mu_);
+    buffers_.push_back(
+        std::make_unique<ThreadBuffer>(static_cast<int>(buffers_.size())));
+    return buffers_.back().get();
+  }
+
+  void set_start_ns(const int64_t start_ns) {
+    absl::MutexLock lock(&mu_);
+    start_ns_ = start_ns;
+  }
+
+  // Writes every span as a Chrome "complete" event. Timestamps are in
+  // microseconds from the start of the trace, with nanosecond precision.
+  void AppendEvents(std::string& out) {
+    absl::MutexLock lock(&mu_);
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+      absl::MutexLock buffer_lock(&buffer->mu);
+      for (const Span& span : buffer->spans) {
+        absl::StrAppendFormat(
+            &out,
+            "%s\n    {\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, "
+            "\"dur\": %.3f, \"pid\": 1, \"tid\": %d}",
+            first ? "" : ",", span.name, (span.start_ns - start_ns_) / 1e3,
+            (span.end_ns - span.start_ns) / 1e3, buffer->tid);
+        first = false;
+      }
+    }
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_ ABSL_GUARDED_BY(mu_);
+  int64_t start_ns_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+void StartTracing() {
+  Registry::Get().set_start_ns(TraceNanos());
+  trace_internal::enabled.store(true, std::memory_order_relaxed);
+}
+
+void RecordSpan(const absl::string_view name, const int64_t start_ns,
+                const int64_t end_ns) {
+  thread_local ThreadBuffer* const buffer = Registry::Get().Register();
+  absl::MutexLock lock(&buffer->mu);
+  buffer->spans.push_back({name, start_ns, end_ns});
+}
+
+absl::Status WriteTrace(const absl::string_view path) {
+  trace_internal::enabled.store(false, std::memory_order_relaxed);
+  std::string json = "{\n  \"displayTimeUnit\": \"ns\",\n  \"traceEvents\": [";
+  Registry::Get().AppendEvents(json);
+  json += "\n  ]\n}\n";
+  return WriteOutput(path, json);
+}
+
+}  // namespace dataminer
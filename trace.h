@@ -0,0 +1,77 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace dataminer {
+
+// Records where the time goes, as spans with nanosecond timestamps and the
+// thread they ran on, and writes them out in Chrome's trace-event format,
+// which chrome://tracing and ui.perfetto.dev both open.
+//
+// Spans are recorded with TRACE_SCOPE:
+//
+//   absl::Status ParseUnits(const Json::Value& root, Units& units) {
+//     TRACE_SCOPE("ParseUnits");
+//     ...
+//   }
+//
+// Until StartTracing() is called, a TRACE_SCOPE is one relaxed atomic load,
+// so it's fine to leave in hot code. Once tracing, each thread records into
+// its own buffer, so threads don't contend.
+void StartTracing();
+
+namespace trace_internal {
+extern std::atomic<bool> enabled;
+}  // namespace trace_internal
+
+inline bool TracingEnabled() {
+  return trace_internal::enabled.load(std::memory_order_relaxed);
+}
+
+// Stops tracing and writes every span recorded so far to `path`.
+absl::Status WriteTrace(absl::string_view path);
+
+// Records a span that ran from `start_ns` to `end_ns` on this thread, in
+// TraceNanos() time. `name` must outlive the trace, e.g. a string literal.
+void RecordSpan(absl::string_view name, int64_t start_ns, int64_t end_ns);
+
+inline int64_t TraceNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Records a span for its own lifetime. Use TRACE_SCOPE instead of this.
+class TraceScope {
+ public:
+  explicit TraceScope(const absl::string_view name)
+      : name_(name), start_ns_(TracingEnabled() ? TraceNanos() : -1) {}
+
+  ~TraceScope() {
+    if (start_ns_ >= 0) RecordSpan(name_, start_ns_, TraceNanos());
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const absl::string_view name_;
+  // -1 if tracing was off when the scope started.
+  const int64_t start_ns_;
+};
+
+}  // namespace dataminer
+
+#define TRACE_SCOPE_CONCAT_INNER(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_INNER(a, b)
+// Traces the rest of the enclosing scope as a span called `name`.
+#define TRACE_SCOPE(name) \
+  ::dataminer::TraceScope TRACE_SCOPE_CONCAT(trace_scope_, __LINE__)(name)
+
+#endif  // __TRACE_H__